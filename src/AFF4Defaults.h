@@ -77,11 +77,106 @@
  */
 #define AFF4_IMAGE_STREAM_CHUNK_CACHE_SIZE (8 * 1024 * 1204)
 
+/**
+ * The number of recently used chunks each thread holds in front of the image stream caches. (must be a power of 2).
+ */
+#define AFF4_IMAGE_STREAM_L1_ENTRIES 8
+
+/**
+ * The default size of the image stream compressed chunk cache. (bytes)
+ */
+#define AFF4_IMAGE_STREAM_COMPRESSED_CACHE_SIZE (4 * 1024 * 1024)
+
+/**
+ * Share decompressed chunks with identical compressed contents between image streams by default.
+ */
+#define AFF4_IMAGE_STREAM_CHUNK_SHARING true
+
+/**
+ * The largest compressed chunk considered for sharing. (bytes). Repeated filler chunks compress well below this.
+ */
+#define AFF4_IMAGE_STREAM_SHARED_PAYLOAD_SIZE 4096
+
+/**
+ * The number of compressed chunk contents remembered for sharing.
+ */
+#define AFF4_IMAGE_STREAM_SHARED_CHUNKS 1024
+
 /**
  * The minimum size of the image stream cache. (bytes)
  */
 #define AFF4_MINIMUM_IMAGE_STREAM_CHUNK_CACHE_SIZE (1024 * 1204)
 
+/**
+ * The initial block size of the per-container metadata arenas. (bytes)
+ */
+#define AFF4_ARENA_BLOCK_SIZE (16 * 1024)
+
+/**
+ * Use the native turtle parser (with raptor fallback) for container metadata by default.
+ */
+#define AFF4_NATIVE_TURTLE_PARSER true
+
+/**
+ * The minimum number of entries for a stored, sorted aff4:Map to be used in place from a memory mapping.
+ */
+#define AFF4_MAP_IN_PLACE_THRESHOLD (64 * 1024)
+
+/**
+ * The minimum read size for an aff4:Map to read from its target streams concurrently.
+ */
+#define AFF4_MAP_CONCURRENT_READ_THRESHOLD (1024 * 1024)
+
+/**
+ * The maximum number of consecutive map entries in the same aff4:ImageStream read by a single batched read.
+ */
+#define AFF4_MAP_READ_BATCH_SIZE 64
+
+/**
+ * The minimum default number of library worker threads. (The default is one per core).
+ */
+#define AFF4_EXECUTOR_MIN_THREADS 4
+
+/**
+ * The maximum number of library worker threads.
+ */
+#define AFF4_EXECUTOR_MAX_THREADS 256
+
+/**
+ * The maximum number of queued normal and high priority library tasks.
+ */
+#define AFF4_EXECUTOR_QUEUE_SIZE (64 * 1024)
+
+/**
+ * The maximum number of queued low priority (speculative) library tasks.
+ */
+#define AFF4_EXECUTOR_LOW_QUEUE_SIZE 2048
+
+/**
+ * The default maximum number of container reads in flight before reads are queued by class.
+ */
+#define AFF4_IO_QUEUE_DEPTH 16
+
+/**
+ * The size of the slices speculative and background container reads are split into.
+ */
+#define AFF4_IO_SLICE_SIZE (256 * 1024)
+
+/**
+ * The default read ahead window of an aff4:Map, in bytes.
+ */
+#define AFF4_MAP_PREFETCH_WINDOW (4 * 1024 * 1024)
+
+/**
+ * The maximum number of bytes read by a single coalesced read of a vectored read.
+ */
+#define AFF4_READV_MAX_RUN (1024 * 1024)
+
+/**
+ * The maximum gap between ranges of a vectored read that are coalesced into a single read.
+ */
+#define AFF4_READV_COALESCE_GAP (16 * 1024)
+
 /**
  * The default filename extension for AFF4 files.
  */
@@ -16,6 +16,8 @@
  */
 
 #include <map>
+#include <vector>
+#include <cstring>
 
 #include "aff4config.h"
 #include "aff4.h"
@@ -104,36 +106,134 @@ static const std::map<aff4::Lexicon, std::string> lexiconMappings = { //
 				{ BBT_CONTAINS_UNALLOCATED, (BBT_BASE_URI "ContainsUnallocated") }, //
 		};
 
+/**
+ * @brief Perfect hash table over all lexicon strings, plus the reverse lexicon to string table.
+ * <p>
+ * The hash seed is chosen when the table is built, so that every lexicon string occupies its own slot. A lookup is
+ * then a single hash, probe and memcmp().
+ */
+class LexiconTable {
+public:
+	LexiconTable() :
+			seed(0), mask(0) {
+		// Reverse table, indexed by lexicon value + 1 (to accommodate UNKNOWN = -1).
+		strings.resize(Lexicon::BBT_CONTAINS_UNALLOCATED + 2, nullptr);
+		for (auto it = lexiconMappings.begin(); it != lexiconMappings.end(); it++) {
+			strings[it->first + 1] = &it->second;
+		}
+		// Find a table size and seed that has no collisions.
+		size_t tableSize = 256;
+		while (tableSize < (lexiconMappings.size() * 4)) {
+			tableSize <<= 1;
+		}
+		while (true) {
+			mask = (uint32_t) (tableSize - 1);
+			for (seed = 1; seed < 0x10000; seed++) {
+				if (build(tableSize)) {
+					return;
+				}
+			}
+			tableSize <<= 1;
+		}
+	}
+
+	inline const std::string* getString(aff4::Lexicon lexicon) const noexcept {
+		if ((lexicon < Lexicon::UNKNOWN) || (lexicon > Lexicon::BBT_CONTAINS_UNALLOCATED)) {
+			return nullptr;
+		}
+		return strings[lexicon + 1];
+	}
+
+	inline aff4::Lexicon getLexicon(const char* lexicon, size_t length) const noexcept {
+		const Slot& slot = slots[hash(lexicon, length) & mask];
+		if ((slot.value != nullptr) && (slot.value->length() == length)
+				&& (std::memcmp(slot.value->data(), lexicon, length) == 0)) {
+			return slot.lexicon;
+		}
+		return Lexicon::UNKNOWN;
+	}
+
+private:
+	struct Slot {
+		aff4::Lexicon lexicon;
+		const std::string* value;
+	};
+
+	uint32_t seed;
+	uint32_t mask;
+	std::vector<Slot> slots;
+	std::vector<const std::string*> strings;
+
+	/**
+	 * Seeded FNV-1a.
+	 */
+	inline uint32_t hash(const char* value, size_t length) const noexcept {
+		uint32_t h = 2166136261u ^ seed;
+		for (size_t i = 0; i < length; i++) {
+			h ^= (uint8_t) value[i];
+			h *= 16777619u;
+		}
+		return h ^ (h >> 15);
+	}
+
+	bool build(size_t tableSize) {
+		slots.assign(tableSize, Slot { Lexicon::UNKNOWN, nullptr });
+		for (auto it = lexiconMappings.begin(); it != lexiconMappings.end(); it++) {
+			Slot& slot = slots[hash(it->second.data(), it->second.length()) & mask];
+			if (slot.value != nullptr) {
+				if (*slot.value == it->second) {
+					// Duplicate string, the first (lowest) lexicon wins.
+					continue;
+				}
+				return false;
+			}
+			slot.lexicon = it->first;
+			slot.value = &it->second;
+		}
+		return true;
+	}
+};
+
+/**
+ * Get the lexicon lookup table, built on first use.
+ * @return The lexicon lookup table.
+ */
+static const LexiconTable& getLexiconTable() {
+	static const LexiconTable table;
+	return table;
+}
+
 namespace lexicon {
 
 std::string getLexiconString(aff4::Lexicon lexicon) noexcept {
-	auto it = lexiconMappings.find(lexicon);
-	if (it != lexiconMappings.end()) {
-		return it->second;
+	const std::string* value = getLexiconTable().getString(lexicon);
+	if (value != nullptr) {
+		return *value;
 	}
 	// Guaranteed to return something.
 	return getLexiconString(Lexicon::UNKNOWN);
 }
 
 aff4::Lexicon getLexicon(const std::string& lexicon) noexcept {
-	if (lexicon.length() == 0) {
+	return getLexicon(lexicon.data(), lexicon.length());
+}
+
+aff4::Lexicon getLexicon(const char* lexicon, size_t length) noexcept {
+	if (length == 0) {
 #if DEBUG
-	fprintf( aff4::getDebugOutput(), "%s[%d] : Unknown lexicon? %s\n", __FILE__, __LINE__, lexicon.c_str());
+	fprintf( aff4::getDebugOutput(), "%s[%d] : Unknown lexicon? (empty)\n", __FILE__, __LINE__);
 #endif
 		return Lexicon::UNKNOWN;
 	}
-	for (auto it = lexiconMappings.begin(); it != lexiconMappings.end(); it++) {
-		if (it->second.compare(lexicon.c_str()) == 0) {
-			return it->first;
-		}
-	}
+	aff4::Lexicon result = getLexiconTable().getLexicon(lexicon, length);
 #if DEBUG
-	fprintf( aff4::getDebugOutput(), "%s[%d] : Unknown lexicon? %s\n",  __FILE__, __LINE__,lexicon.c_str());
+	if (result == Lexicon::UNKNOWN) {
+		fprintf( aff4::getDebugOutput(), "%s[%d] : Unknown lexicon? %.*s\n",  __FILE__, __LINE__, (int) length, lexicon);
+	}
 #endif
-	return Lexicon::UNKNOWN;
+	return result;
 }
 
 } // namespace lexicon.
 
 } // namespace aff4
-
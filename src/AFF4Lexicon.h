@@ -398,6 +398,14 @@ LIBAFF4_API std::string getLexiconString(aff4::Lexicon lexicon) noexcept;
  * @return The enum lexicon.
  */
 LIBAFF4_API aff4::Lexicon getLexicon(const std::string& lexicon) noexcept;
+
+/**
+ * Get the enum for the applicable lexicon string value
+ * @param lexicon The lexicon characters (need not be NULL terminated).
+ * @param length The number of characters in the lexicon.
+ * @return The enum lexicon.
+ */
+LIBAFF4_API aff4::Lexicon getLexicon(const char* lexicon, size_t length) noexcept;
 } /* namespace lexicon */
 
 } /* namespace aff4 */
@@ -92,6 +92,70 @@ namespace aff4 {
 		 */
 		LIBAFF4_API virtual void setMapGapStreamOverride(std::shared_ptr<IAFF4Stream>& stream) = 0;
 
+		/**
+		 * Get the runs of content in the given range of the image.
+		 *
+		 * @param offset The offset from the start of the image.
+		 * @param count The length of the range.
+		 * @return The runs covering the range (truncated to the image size), in offset order.
+		 * @see IAFF4Stream::getExtents()
+		 */
+		LIBAFF4_API virtual std::vector<StreamExtent> getExtents(uint64_t offset, uint64_t count) {
+			std::shared_ptr<IAFF4Stream> stream = getStream();
+			return (stream == nullptr) ? std::vector<StreamExtent>() : stream->getExtents(offset, count);
+		}
+
+		/**
+		 * Get the offset of the next stored data at or after offset. (As lseek(SEEK_DATA)).
+		 *
+		 * @param offset The offset from the start of the image.
+		 * @return The offset of the next stored data, or the image size if there is none.
+		 */
+		LIBAFF4_API virtual uint64_t nextData(uint64_t offset) {
+			std::shared_ptr<IAFF4Stream> stream = getStream();
+			return (stream == nullptr) ? size() : stream->nextData(offset);
+		}
+
+		/**
+		 * Get the offset of the next region at or after offset that holds no stored data. (As lseek(SEEK_HOLE)).
+		 *
+		 * @param offset The offset from the start of the image.
+		 * @return The offset of the next region without stored data, or the image size if there is none.
+		 */
+		LIBAFF4_API virtual uint64_t nextHole(uint64_t offset) {
+			std::shared_ptr<IAFF4Stream> stream = getStream();
+			return (stream == nullptr) ? size() : stream->nextHole(offset);
+		}
+
+		/**
+		 * Hint that the given range of the image will be read soon.
+		 *
+		 * @param offset The offset from the start of the image.
+		 * @param count The length of the range.
+		 * @param priority The urgency of the hint.
+		 * @see IAFF4Stream::prefetch()
+		 */
+		LIBAFF4_API virtual void prefetch(uint64_t offset, uint64_t count, PrefetchPriority priority = PREFETCH_NORMAL) {
+			std::shared_ptr<IAFF4Stream> stream = getStream();
+			if (stream != nullptr) {
+				stream->prefetch(offset, count, priority);
+			}
+		}
+
+		/**
+		 * Hint that the given range of the image will not be read again soon.
+		 *
+		 * @param offset The offset from the start of the image.
+		 * @param count The length of the range.
+		 * @see IAFF4Stream::evict()
+		 */
+		LIBAFF4_API virtual void evict(uint64_t offset, uint64_t count) {
+			std::shared_ptr<IAFF4Stream> stream = getStream();
+			if (stream != nullptr) {
+				stream->evict(offset, count);
+			}
+		}
+
 	};
 
 } /* namespace aff4 */
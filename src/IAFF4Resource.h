@@ -83,6 +83,35 @@ namespace aff4 {
 		 * @return The collection of objects for the given key.
 		 */
 		LIBAFF4_API virtual std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) = 0;
+		/**
+		 * Get a read only view of all properties for this object, without copying.
+		 * <p>
+		 * The map may be shared with the container's RDF model, and is never modified once returned. (Properties later
+		 * added to this object are published in a new map). Use the map's const_iterators to walk the properties.
+		 * <p>
+		 * The default implementation returns a copy of getProperties().
+		 *
+		 * @return A read only view of all properties for this object.
+		 */
+		LIBAFF4_API virtual std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() {
+			return std::make_shared<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>(getProperties());
+		}
+		/**
+		 * Get a read only view of the collection of objects for the given property, without copying.
+		 * <p>
+		 * The collection is never modified once returned, and keeps the map it belongs to alive. The default
+		 * implementation looks up the property in getPropertyMap().
+		 *
+		 * @param resource The resource to acquired
+		 * @return The collection of objects for the given key. (empty collection if the property is not set).
+		 */
+		LIBAFF4_API virtual std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) {
+			static const std::vector<aff4::rdf::RDFValue> empty;
+			std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties = getPropertyMap();
+			auto it = properties->find(resource);
+			return std::shared_ptr<const std::vector<aff4::rdf::RDFValue>>(properties,
+					(it != properties->end()) ? &it->second : &empty);
+		}
 
 	};
 
@@ -32,8 +32,133 @@
 #ifndef SRC_IAFF4STREAM_H_
 #define SRC_IAFF4STREAM_H_
 
+#include <algorithm>
+#include <functional>
+#include <future>
+
 namespace aff4 {
 
+	/**
+	 * @brief The type of content of a region of a stream.
+	 */
+	enum ExtentType {
+		/**
+		 * Stored data.
+		 */
+		EXTENT_DATA,
+		/**
+		 * aff4:Zero (or aff4:SymbolicStream00), reads as zeros.
+		 */
+		EXTENT_ZERO,
+		/**
+		 * aff4:SymbolicStreamXX, reads as a repeated byte.
+		 */
+		EXTENT_SYMBOLIC,
+		/**
+		 * aff4:UnknownData, or a stream that could not be located.
+		 */
+		EXTENT_UNKNOWN,
+		/**
+		 * aff4:UnreadableData.
+		 */
+		EXTENT_UNREADABLE,
+		/**
+		 * A region not described by an aff4:Map, read from the map gap stream. (aff4:Zero unless overridden).
+		 */
+		EXTENT_GAP
+	};
+
+	/**
+	 * @brief The urgency of a prefetch hint.
+	 */
+	enum PrefetchPriority {
+		/**
+		 * Speculative; dropped if the library executor is busy.
+		 */
+		PREFETCH_LOW,
+		/**
+		 * Loaded after previously queued hints.
+		 */
+		PREFETCH_NORMAL,
+		/**
+		 * Loaded before previously queued hints.
+		 */
+		PREFETCH_HIGH
+	};
+
+	/**
+	 * @brief A run of a stream with the same type of content, read from the same target stream.
+	 */
+	struct StreamExtent {
+		/**
+		 * The offset of the run in the stream.
+		 */
+		uint64_t offset;
+		/**
+		 * The length of the run.
+		 */
+		uint64_t length;
+		/**
+		 * The type of content.
+		 */
+		ExtentType type;
+		/**
+		 * The resource of the stream the run is read from.
+		 */
+		std::string target;
+		/**
+		 * The offset of the run in the target stream.
+		 */
+		uint64_t targetOffset;
+	};
+
+	/**
+	 * @brief A single range of a vectored read.
+	 */
+	struct ReadRequest {
+		/**
+		 * The buffer to read into.
+		 */
+		void* buffer;
+		/**
+		 * The number of bytes to read.
+		 */
+		uint64_t count;
+		/**
+		 * The offset from the start of the stream.
+		 */
+		uint64_t offset;
+		/**
+		 * Set to the number of bytes read. (0 indicates nothing read, or -1 indicates error).
+		 */
+		int64_t result;
+	};
+
+	class IAFF4Stream;
+
+	/**
+	 * Completion of an asynchronous read.
+	 * <p>
+	 * Called with the result of the read (as returned by IAFF4Stream::read()), and the errno value if the read failed.
+	 */
+	typedef std::function<void(int64_t result, int error)> ReadCallback;
+
+	namespace stream {
+	/**
+	 * Queue a read of the given stream on the library executor.
+	 * <p>
+	 * The callback is invoked via the completion executor (see aff4::stream::setCompletionExecutor()). If the read can't
+	 * be queued, the callback is invoked with -1 and EAGAIN.
+	 *
+	 * @param stream The stream to read. The stream must remain open until the callback is invoked.
+	 * @param buf A pointer to the buffer to read to. The buffer must remain valid until the callback is invoked.
+	 * @param count The number of bytes to read
+	 * @param offset The offset from the start of the stream.
+	 * @param callback The completion.
+	 */
+	LIBAFF4_API void queueRead(IAFF4Stream* stream, void *buf, uint64_t count, uint64_t offset, ReadCallback callback);
+	}
+
 	/**
 	 * @brief General interface for all aff4:Stream objects
 	 */
@@ -64,6 +189,156 @@ namespace aff4 {
 		 */
 		LIBAFF4_API virtual int64_t read(void *buf, uint64_t count, uint64_t offset) = 0;
 
+		/**
+		 * Read a number of ranges from the stream in a single call.
+		 * <p>
+		 * Ranges may be in any order, and may overlap. Streams with a cache load each distinct chunk backing the
+		 * ranges once, so this is preferred over many small reads. The default implementation reads each range in
+		 * turn.
+		 *
+		 * @param requests The ranges to read. The result of each is set.
+		 * @param count The number of ranges.
+		 * @return The total number of bytes read, or -1 if any range failed to read.
+		 */
+		LIBAFF4_API virtual int64_t readv(ReadRequest* requests, size_t count) {
+			int64_t total = 0;
+			bool failed = false;
+			for (size_t i = 0; i < count; i++) {
+				requests[i].result = read(requests[i].buffer, requests[i].count, requests[i].offset);
+				if (requests[i].result < 0) {
+					failed = true;
+				} else {
+					total += requests[i].result;
+				}
+			}
+			return failed ? -1 : total;
+		}
+
+		/**
+		 * Read a number of bytes from the stream starting at offset, without blocking the calling thread.
+		 * <p>
+		 * The read is serviced by the library executor. The stream and buffer must remain valid until the callback is
+		 * invoked.
+		 *
+		 * @param buf A pointer to the buffer to read to.
+		 * @param count The number of bytes to read
+		 * @param offset The offset from the start of the stream.
+		 * @param callback The completion, invoked via the completion executor.
+		 * @see aff4::stream::setCompletionExecutor()
+		 */
+		LIBAFF4_API virtual void readAsync(void *buf, uint64_t count, uint64_t offset, ReadCallback callback) {
+			aff4::stream::queueRead(this, buf, count, offset, callback);
+		}
+
+		/**
+		 * Read a number of bytes from the stream starting at offset, without blocking the calling thread.
+		 * <p>
+		 * The stream and buffer must remain valid until the future is ready. (Named apart from readAsync() so that
+		 * implementations overriding the callback form do not hide it).
+		 *
+		 * @param buf A pointer to the buffer to read to.
+		 * @param count The number of bytes to read
+		 * @param offset The offset from the start of the stream.
+		 * @return The number of bytes read, once ready. (0 indicates nothing read, or -1 indicates error).
+		 */
+		LIBAFF4_API std::future<int64_t> readAsyncFuture(void *buf, uint64_t count, uint64_t offset) {
+			std::shared_ptr<std::promise<int64_t>> promise = std::make_shared<std::promise<int64_t>>();
+			std::future<int64_t> future = promise->get_future();
+			readAsync(buf, count, offset, [promise](int64_t result, int error) {
+				(void) error;
+				promise->set_value(result);
+			});
+			return future;
+		}
+
+		/**
+		 * Get the runs of content in the given range of the stream.
+		 * <p>
+		 * Unlike read, this never reads stream content, so it may be used to skip regions that hold no stored data. The
+		 * default implementation reports the stream as a single run of stored data.
+		 *
+		 * @param offset The offset from the start of the stream.
+		 * @param count The length of the range.
+		 * @return The runs covering the range (truncated to the stream size), in offset order.
+		 */
+		LIBAFF4_API virtual std::vector<StreamExtent> getExtents(uint64_t offset, uint64_t count) {
+			std::vector<StreamExtent> extents;
+			uint64_t length = size();
+			if ((offset < length) && (count > 0)) {
+				StreamExtent extent = { offset, std::min<uint64_t>(count, length - offset), EXTENT_DATA, getResourceID(),
+						offset };
+				extents.push_back(extent);
+			}
+			return extents;
+		}
+
+		/**
+		 * Get the offset of the next stored data at or after offset. (As lseek(SEEK_DATA)).
+		 *
+		 * @param offset The offset from the start of the stream.
+		 * @return The offset of the next stored data, or the stream size if there is none.
+		 */
+		LIBAFF4_API virtual uint64_t nextData(uint64_t offset) {
+			uint64_t length = size();
+			if (offset >= length) {
+				return length;
+			}
+			for (const StreamExtent& extent : getExtents(offset, length - offset)) {
+				if (extent.type == EXTENT_DATA) {
+					return std::max<uint64_t>(extent.offset, offset);
+				}
+			}
+			return length;
+		}
+
+		/**
+		 * Get the offset of the next region at or after offset that holds no stored data. (As lseek(SEEK_HOLE)).
+		 *
+		 * @param offset The offset from the start of the stream.
+		 * @return The offset of the next region without stored data, or the stream size if there is none.
+		 */
+		LIBAFF4_API virtual uint64_t nextHole(uint64_t offset) {
+			uint64_t length = size();
+			if (offset >= length) {
+				return length;
+			}
+			for (const StreamExtent& extent : getExtents(offset, length - offset)) {
+				if (extent.type != EXTENT_DATA) {
+					return std::max<uint64_t>(extent.offset, offset);
+				}
+			}
+			return length;
+		}
+
+		/**
+		 * Hint that the given range will be read soon. (As posix_fadvise(POSIX_FADV_WILLNEED)).
+		 * <p>
+		 * Streams with a cache load the range in the background and return immediately. This is a hint only, and
+		 * does not change the content read. The default implementation does nothing.
+		 *
+		 * @param offset The offset from the start of the stream.
+		 * @param count The length of the range.
+		 * @param priority The urgency of the hint.
+		 */
+		LIBAFF4_API virtual void prefetch(uint64_t offset, uint64_t count, PrefetchPriority priority = PREFETCH_NORMAL) {
+			(void) offset;
+			(void) count;
+			(void) priority;
+		}
+
+		/**
+		 * Hint that the given range will not be read again soon. (As posix_fadvise(POSIX_FADV_DONTNEED)).
+		 * <p>
+		 * Streams with a cache drop the cached content of the range. The default implementation does nothing.
+		 *
+		 * @param offset The offset from the start of the stream.
+		 * @param count The length of the range.
+		 */
+		LIBAFF4_API virtual void evict(uint64_t offset, uint64_t count) {
+			(void) offset;
+			(void) count;
+		}
+
 	};
 
 } /* namespace aff4 */
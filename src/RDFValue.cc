@@ -16,6 +16,7 @@
  */
 
 #include "RDFValue.h"
+#include "StringInterner.h"
 #include <time.h>
 
 namespace aff4 {
@@ -146,13 +147,105 @@ std::chrono::system_clock::time_point getTime(const std::string& value) {
 	return std::chrono::system_clock::from_time_t(time_epoch);
 }
 
+static_assert(sizeof(std::chrono::system_clock::rep) <= sizeof(int64_t), "system_clock ticks must fit in 64 bits");
+static_assert(sizeof(RDFValue) <= 16, "RDFValue should be a compact tagged union");
+
+void RDFValue::setLiteral(const std::string& literal) {
+	releaseLiteral();
+	if (!literal.empty()) {
+		value_literal = new SharedString(literal);
+	}
+}
+
+void RDFValue::releaseLiteral() noexcept {
+	if (hasLiteral() && (value_literal != nullptr)) {
+		if (--value_literal->references == 0) {
+			delete value_literal;
+		}
+		value_literal = nullptr;
+	}
+}
+
+RDFValue::RDFValue(const RDFValue& o) noexcept :
+		xsdType(o.xsdType), rdfType(o.rdfType), value_long(o.value_long) {
+	if (hasLiteral() && (value_literal != nullptr)) {
+		value_literal->references++;
+	}
+}
+
+RDFValue::RDFValue(RDFValue&& o) noexcept :
+		xsdType(o.xsdType), rdfType(o.rdfType), value_long(o.value_long) {
+	if (hasLiteral()) {
+		o.value_literal = nullptr;
+	}
+}
+
+RDFValue& RDFValue::operator=(const RDFValue& o) noexcept {
+	if (this != &o) {
+		if (o.hasLiteral() && (o.value_literal != nullptr)) {
+			o.value_literal->references++;
+		}
+		releaseLiteral();
+		xsdType = o.xsdType;
+		rdfType = o.rdfType;
+		value_long = o.value_long;
+	}
+	return *this;
+}
+
+RDFValue& RDFValue::operator=(RDFValue&& o) noexcept {
+	if (this != &o) {
+		releaseLiteral();
+		xsdType = o.xsdType;
+		rdfType = o.rdfType;
+		value_long = o.value_long;
+		if (hasLiteral()) {
+			o.value_literal = nullptr;
+		}
+	}
+	return *this;
+}
+
+std::string RDFValue::getValue() const noexcept {
+	if (hasLiteral() && (value_literal != nullptr)) {
+		return value_literal->value;
+	}
+	return std::string();
+}
+
+bool RDFValue::operator==(const RDFValue& rhs) const noexcept {
+	if ((xsdType != rhs.xsdType) || (rdfType != rhs.rdfType)) {
+		return false;
+	}
+	switch (xsdType) {
+	case Int:
+		return value_int == rhs.value_int;
+	case Long:
+		return value_long == rhs.value_long;
+	case Float:
+		return value_float == rhs.value_float;
+	case Boolean:
+		return value_bool == rhs.value_bool;
+	case XSDDateTime:
+		return timestamp == rhs.timestamp;
+	default:
+		if (value_literal == rhs.value_literal) {
+			return true;
+		}
+		if ((value_literal == nullptr) || (rhs.value_literal == nullptr)) {
+			return false;
+		}
+		return value_literal->value == rhs.value_literal->value;
+	}
+}
+
 std::string RDFValue::toString() noexcept {
 
 	switch (xsdType) {
 	case UNKNOWN:
 		break;
 	case String:
-		return value_literal;
+		return getValue();
 	case Boolean:
 		return (value_bool == true) ? "true" : "false";
 	case Float:
@@ -162,15 +255,15 @@ std::string RDFValue::toString() noexcept {
 	case Long:
 		return std::to_string(value_long);
 	case Literal:
-		return value_literal + "^^" + aff4::lexicon::getLexiconString(rdfType);
+		return getValue() + "^^" + aff4::lexicon::getLexiconString(rdfType);
 	case Resource:
-		if (!value_literal.empty()) {
-			return value_literal;
+		if (value_literal != nullptr) {
+			return value_literal->value;
 		} else {
 			return aff4::lexicon::getLexiconString(rdfType);
 		}
 	case XSDDateTime:
-		std::time_t now_c = std::chrono::system_clock::to_time_t(timestamp);
+		std::time_t now_c = std::chrono::system_clock::to_time_t(getXSDDateTime());
 #ifdef _WIN32
 		std::tm now_tm;
 		gmtime_s(&now_tm, &now_c);
@@ -188,7 +281,7 @@ std::string RDFValue::toString() noexcept {
 
 	}
 // ???
-	return value_literal;
+	return getValue();
 }
 
 } /* namespace rdf */
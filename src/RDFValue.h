@@ -32,6 +32,7 @@
 #ifndef SRC_RDFVALUE_H_
 #define SRC_RDFVALUE_H_
 
+#include <cstdint>
 #include <string>
 #include <chrono>
 #include <ctime>
@@ -138,111 +139,145 @@ namespace aff4 {
 		 * </ul>
 		 * For dateTime values, the millisecond portion of the timestamp is currently NOT supported.
 		 */
+		/**
+		 * Reference counted immutable string, shared between RDFValue instances. (opaque).
+		 */
+		struct SharedString;
+
+		class StringInterner;
+
 		class RDFValue {
 
 		private:
 			XSDType xsdType;
 			aff4::Lexicon rdfType;
-			int32_t value_int;
-			int64_t value_long;
-			bool value_bool;
-			float value_float;
-			std::string value_literal;
-			std::chrono::system_clock::time_point timestamp;
+			/**
+			 * The value, as selected by xsdType.
+			 */
+			union {
+				int32_t value_int;
+				int64_t value_long;
+				bool value_bool;
+				float value_float;
+				/**
+				 * Ticks of std::chrono::system_clock since the epoch.
+				 */
+				int64_t timestamp;
+				/**
+				 * String, Literal and Resource values. (nullptr for the empty string).
+				 */
+				SharedString* value_literal;
+			};
+
+			friend class StringInterner;
+
+			/**
+			 * Does this value type hold a string?
+			 */
+			inline bool hasLiteral() const noexcept {
+				return (xsdType == String) || (xsdType == Literal) || (xsdType == Resource) || (xsdType == UNKNOWN);
+			}
+
+			/**
+			 * Set the string value. (The empty string is held as nullptr).
+			 */
+			LIBAFF4_API void setLiteral(const std::string& literal);
+
+			/**
+			 * Release the held string value, if any.
+			 */
+			LIBAFF4_API void releaseLiteral() noexcept;
 
 		public:
 
 			/**
 			 * Create a typed resource. (String value).
+			 * <p>
+			 * The string value is only held for String, Literal and Resource types.
 			 */
 			explicit RDFValue(XSDType xsdType, aff4::Lexicon type, const std::string& literal) : xsdType(xsdType), rdfType(type),
-			value_int(0), value_long(0), value_bool(false), value_float(0.0), value_literal(literal),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			value_long(0) {
+				if (hasLiteral()) {
+					value_literal = nullptr;
+					setLiteral(literal);
+				}
+			}
 			/**
 			 * Create a resource property, type only
 			 */
-			explicit RDFValue(aff4::Lexicon type) : xsdType(Resource), rdfType(type),
-			value_int(0), value_long(0), value_bool(false), value_float(0.0), value_literal(""),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(aff4::Lexicon type) : xsdType(Resource), rdfType(type), value_literal(nullptr) {}
 
 			/**
 			 * Create a literal type.
 			 */
-			explicit RDFValue(aff4::Lexicon type, const std::string& literal): xsdType(Literal), rdfType(type) ,
-			value_int(0), value_long(0), value_bool(false), value_float(0.0), value_literal(literal),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(aff4::Lexicon type, const std::string& literal): xsdType(Literal), rdfType(type),
+			value_literal(nullptr) {
+				setLiteral(literal);
+			}
 
 			/**
 			 * Create a string type.
 			 */
-			explicit RDFValue(const std::string& value): xsdType(String), rdfType(aff4::Lexicon::UNKNOWN) ,
-			value_int(0), value_long(0), value_bool(false), value_float(0.0), value_literal(value),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(const std::string& value): xsdType(String), rdfType(aff4::Lexicon::UNKNOWN),
+			value_literal(nullptr) {
+				setLiteral(value);
+			}
 
 			/**
 			 * Create an Integer
 			 */
-			explicit RDFValue(int32_t value): xsdType(Int), rdfType(aff4::Lexicon::UNKNOWN) ,
-			value_int(value), value_long(0), value_bool(false), value_float(0.0), value_literal(""),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(int32_t value): xsdType(Int), rdfType(aff4::Lexicon::UNKNOWN), value_long(0) {
+				value_int = value;
+			}
 
 			/**
 			 * Create a long
 			 */
-			explicit RDFValue(int64_t value): xsdType(Long), rdfType(aff4::Lexicon::UNKNOWN) ,
-			value_int(0), value_long(value), value_bool(false), value_float(0.0), value_literal(""),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(int64_t value): xsdType(Long), rdfType(aff4::Lexicon::UNKNOWN), value_long(value) {}
 
 			/**
 			 * Create a float
 			 */
-			explicit RDFValue(float value): xsdType(Float), rdfType(aff4::Lexicon::UNKNOWN) ,
-			value_int(0), value_long(0), value_bool(false), value_float(value), value_literal(""),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(float value): xsdType(Float), rdfType(aff4::Lexicon::UNKNOWN), value_long(0) {
+				value_float = value;
+			}
 
 			/**
 			 * Create a boolean type
 			 */
-			explicit RDFValue(bool value): xsdType(Boolean), rdfType(aff4::Lexicon::UNKNOWN) ,
-			value_int(0), value_long(0), value_bool(value), value_float(0.0), value_literal(""),
-			timestamp(std::chrono::system_clock::time_point()) {}
+			explicit RDFValue(bool value): xsdType(Boolean), rdfType(aff4::Lexicon::UNKNOWN), value_long(0) {
+				value_bool = value;
+			}
 
 			/**
 			 * Create a timestamp.
 			 */
-			explicit RDFValue(const std::chrono::system_clock::time_point& value): xsdType(XSDDateTime), rdfType(aff4::Lexicon::UNKNOWN) ,
-			value_int(0), value_long(0), value_bool(false), value_float(0.0), value_literal(""),
-			timestamp(value) {}
+			explicit RDFValue(const std::chrono::system_clock::time_point& value): xsdType(XSDDateTime),
+			rdfType(aff4::Lexicon::UNKNOWN), timestamp(value.time_since_epoch().count()) {}
 
-			virtual ~RDFValue() {}
+			~RDFValue() {
+				releaseLiteral();
+			}
 
 			/**
-			 * Copy constructor.
+			 * Copy constructor. (String values are shared, not copied).
 			 */
-			RDFValue(const RDFValue& o) :
-			xsdType(o.xsdType),
-			rdfType(o.rdfType) ,
-			value_int(o.value_int),
-			value_long(o.value_long),
-			value_bool(o.value_bool),
-			value_float(o.value_float),
-			value_literal(o.value_literal),
-			timestamp(o.timestamp) {}
+			LIBAFF4_API RDFValue(const RDFValue& o) noexcept;
+
+			/**
+			 * Move constructor.
+			 */
+			LIBAFF4_API RDFValue(RDFValue&& o) noexcept;
 
 			/**
 			 * = Operator overload.
 			 */
-			RDFValue& operator=(const RDFValue& o) {
-				xsdType=o.xsdType;
-				rdfType=o.rdfType;
-				value_int=o.value_int;
-				value_long=o.value_long;
-				value_bool=o.value_bool;
-				value_float=o.value_float;
-				value_literal =o.value_literal;
-				timestamp = o.timestamp;
-				return *this;
-			}
+			LIBAFF4_API RDFValue& operator=(const RDFValue& o) noexcept;
+
+			/**
+			 * Move assignment.
+			 */
+			LIBAFF4_API RDFValue& operator=(RDFValue&& o) noexcept;
 
 			/**
 			 * Get the value type.
@@ -261,38 +296,39 @@ namespace aff4 {
 			}
 			/**
 			 * Get the string value.
-			 * @return the value.
+			 * @return the value. (empty string for non string types).
 			 */
-			LIBAFF4_API inline std::string getValue() const noexcept {
-				return value_literal;
-			}
+			LIBAFF4_API std::string getValue() const noexcept;
 			/**
 			 * Get the integer value.
 			 * @return the value.
 			 */
 			LIBAFF4_API inline int32_t getInteger() const noexcept {
-				return value_int;
+				return (xsdType == Int) ? value_int : 0;
 			}
 			/**
 			 * Get the integer value.
 			 * @return the value.
 			 */
 			LIBAFF4_API inline int64_t getLong() const noexcept {
-				return value_long;
+				return (xsdType == Long) ? value_long : 0;
 			}
 			/**
 			 * Get the boolean value
 			 * @return the value.
 			 */
 			LIBAFF4_API inline bool getBoolean() const noexcept {
-				return value_bool;
+				return (xsdType == Boolean) ? value_bool : false;
 			}
 			/**
 			 * Get the XSD Datetime value.
 			 * @return the value.
 			 */
 			LIBAFF4_API inline std::chrono::system_clock::time_point getXSDDateTime() const noexcept {
-				return timestamp;
+				if (xsdType != XSDDateTime) {
+					return std::chrono::system_clock::time_point();
+				}
+				return std::chrono::system_clock::time_point(std::chrono::system_clock::duration(timestamp));
 			}
 
 			/**
@@ -306,16 +342,7 @@ namespace aff4 {
 			/**
 			 * Overload == operator
 			 */
-			LIBAFF4_API bool operator==(const RDFValue& rhs) const {
-				return (this->xsdType == rhs.xsdType) &&
-				(this->rdfType == rhs.rdfType) &&
-				(this->timestamp == rhs.timestamp) &&
-				(this->value_bool == rhs.value_bool) &&
-				(this->value_float == rhs.value_float) &&
-				(this->value_int == rhs.value_int) &&
-				(this->value_long == rhs.value_long) &&
-				(this->value_literal == rhs.value_literal);
-			}
+			LIBAFF4_API bool operator==(const RDFValue& rhs) const noexcept;
 
 			/**
 			 * Overload != operator
@@ -36,11 +36,12 @@ static std::string version(PACKAGE_STRING);
 /**
  * Typedef for held container references.
  * <p>
- * We have a resolver, the parent container, and the aff4:Stream for the map.s
+ * We have a resolver, the parent container, the aff4:Stream for the map, and the filename opened.
  */
 typedef typename std::tuple<std::shared_ptr<aff4::IAFF4Resolver>, //
 		std::shared_ptr<aff4::IAFF4Container>, //
-		std::shared_ptr<aff4::IAFF4Stream>> container_t;
+		std::shared_ptr<aff4::IAFF4Stream>, //
+		std::string> container_t;
 
 /**
  * Map of open containers.
@@ -77,6 +78,16 @@ int AFF4_open(const char* filename) {
 		errno = ENOENT;
 		return -1;
 	}
+	// Share a container already open on the file, and with it the caches of its streams.
+	for (auto it = handles->begin(); it != handles->end(); it++) {
+		if (std::get<3>(it->second) == file) {
+			int handle = nextHandle;
+			(*handles)[handle] = it->second;
+			nextHandle++;
+			return handle;
+		}
+	}
+
 	// Attempt to open the file.
 	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file);
 	if (container == nullptr) {
@@ -113,7 +124,7 @@ int AFF4_open(const char* filename) {
 		errno = ENOENT;
 		return -1;
 	}
-	container_t handleEntry = std::make_tuple(resolver, container, stream);
+	container_t handleEntry = std::make_tuple(resolver, container, stream, file);
 	int handle = nextHandle;
 	(*handles)[handle] = handleEntry;
 	nextHandle++;
@@ -140,9 +151,9 @@ int64_t AFF4_object_blocksize(int handle) {
 	auto it = handles->find(handle);
 	if (it != handles->end()) {
 		container_t con = it->second;
-		std::vector<aff4::rdf::RDFValue> properties = std::get<2>(con)->getProperty(aff4::Lexicon::AFF4_BLOCKSIZE);
-		if (!properties.empty()) {
-			aff4::rdf::RDFValue v = properties[0];
+		std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> properties = std::get<2>(con)->getPropertyValues(aff4::Lexicon::AFF4_BLOCKSIZE);
+		if (!properties->empty()) {
+			const aff4::rdf::RDFValue& v = (*properties)[0];
 			if (v.getXSDType() == aff4::rdf::XSDType::Int) {
 				return v.getInteger();
 			} else if (v.getXSDType() == aff4::rdf::XSDType::Long) {
@@ -182,6 +193,48 @@ int AFF4_read(int handle, uint64_t offset, void* buffer, int length) {
 	return -1;
 }
 
+int AFF4_prefetch(int handle, uint64_t offset, uint64_t length, int priority) {
+	if (handles == nullptr) {
+		AFF4_init();
+	}
+	if ((priority < AFF4_PREFETCH_LOW) || (priority > AFF4_PREFETCH_HIGH)) {
+		errno = EINVAL;
+		return -1;
+	}
+	auto it = handles->find(handle);
+	if (it != handles->end()) {
+		container_t con = it->second;
+		std::shared_ptr<aff4::IAFF4Stream> stream = std::get<2>(con);
+		stream->prefetch(offset, length, (aff4::PrefetchPriority) priority);
+		return 0;
+	}
+	errno = EBADF;
+	return -1;
+}
+
+int AFF4_evict(int handle, uint64_t offset, uint64_t length) {
+	if (handles == nullptr) {
+		AFF4_init();
+	}
+	auto it = handles->find(handle);
+	if (it != handles->end()) {
+		container_t con = it->second;
+		std::shared_ptr<aff4::IAFF4Stream> stream = std::get<2>(con);
+		stream->evict(offset, length);
+		return 0;
+	}
+	errno = EBADF;
+	return -1;
+}
+
+int AFF4_set_io_class(int ioClass) {
+	if ((ioClass < AFF4_IO_SPECULATIVE) || (ioClass > AFF4_IO_INTERACTIVE)) {
+		errno = EINVAL;
+		return -1;
+	}
+	return aff4::io::setIOClass((aff4::io::IOClass) ioClass);
+}
+
 int AFF4_close(int handle) {
 	if (handles == nullptr) {
 		AFF4_init();
@@ -189,10 +242,15 @@ int AFF4_close(int handle) {
 	auto it = handles->find(handle);
 	if (it != handles->end()) {
 		container_t con = it->second;
-		// Close the container
-		std::get<1>(con)->close();
-		// And remove the map entry.
+		// Remove the map entry.
 		handles->erase(it);
+		// And close the container, once no other handle shares it.
+		for (auto entry = handles->begin(); entry != handles->end(); entry++) {
+			if (std::get<1>(entry->second) == std::get<1>(con)) {
+				return 0;
+			}
+		}
+		std::get<1>(con)->close();
 		return 0;
 	}
 	errno = EBADF;
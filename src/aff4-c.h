@@ -81,6 +81,9 @@ LIBAFF4_API void AFF4_init();
 
 /**
  * Open the given filename, and access the first aff4:Image in the container.
+ * <p>
+ * Opening a filename that is already open returns a new handle on the same open container, so all handles on the
+ * file share its caches. (The filename must match as given). The container is closed once all its handles are closed.
  * @param filename The filename to open. (UTF-8)
  * @return Object handle, or -1 on error. See errno.
  * (ENOENT = No Such File, or the file is not a valid AFF4 file).
@@ -112,6 +115,48 @@ LIBAFF4_API int64_t AFF4_object_blocksize(int handle);
  */
 LIBAFF4_API int AFF4_read(int handle, uint64_t offset, void* buffer, int length);
 
+/**
+ * Prefetch priorities. (Speculative, queued after earlier hints, queued before earlier hints).
+ */
+#define AFF4_PREFETCH_LOW 0
+#define AFF4_PREFETCH_NORMAL 1
+#define AFF4_PREFETCH_HIGH 2
+
+/**
+ * Hint that the given range will be read soon, so it is loaded in the background.
+ * @param handle The Object handle.
+ * @param offset the offset into the stream
+ * @param length The length of the range.
+ * @param priority The urgency of the hint. (AFF4_PREFETCH_LOW, AFF4_PREFETCH_NORMAL or AFF4_PREFETCH_HIGH).
+ * @return 0 for success, or -1 on error. See errno
+ */
+LIBAFF4_API int AFF4_prefetch(int handle, uint64_t offset, uint64_t length, int priority);
+
+/**
+ * Hint that the given range will not be read again soon, so its cached content is dropped.
+ * @param handle The Object handle.
+ * @param offset the offset into the stream
+ * @param length The length of the range.
+ * @return 0 for success, or -1 on error. See errno
+ */
+LIBAFF4_API int AFF4_evict(int handle, uint64_t offset, uint64_t length);
+
+/**
+ * I/O classes. (Speculative, background, normal, interactive).
+ */
+#define AFF4_IO_SPECULATIVE 0
+#define AFF4_IO_BACKGROUND 1
+#define AFF4_IO_NORMAL 2
+#define AFF4_IO_INTERACTIVE 3
+
+/**
+ * Set the I/O class of reads issued by the calling thread. When the container I/O queue is full, reads are admitted
+ * by class, so interactive reads are not held behind bulk work such as hashing.
+ * @param ioClass The I/O class. (AFF4_IO_SPECULATIVE, AFF4_IO_BACKGROUND, AFF4_IO_NORMAL or AFF4_IO_INTERACTIVE).
+ * @return The previous I/O class, or -1 on error. See errno
+ */
+LIBAFF4_API int AFF4_set_io_class(int ioClass);
+
 /**
  * Close the given handle.
  * @param handle The Object handle to close.
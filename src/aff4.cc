@@ -17,12 +17,57 @@
 
 #include "aff4config.h"
 #include "aff4.h"
+#include "Executor.h"
+#include "IOScheduler.h"
+
+#include <errno.h>
+#include <mutex>
 
 /**
  * The default cache size for reads.
  */
 static uint64_t CHUNK_CACHE_SIZE = AFF4_IMAGE_STREAM_CHUNK_CACHE_SIZE;
 
+/**
+ * The default compressed chunk cache size for reads.
+ */
+static uint64_t COMPRESSED_CACHE_SIZE = AFF4_IMAGE_STREAM_COMPRESSED_CACHE_SIZE;
+
+/**
+ * Share identical chunks between image streams.
+ */
+static bool CHUNK_SHARING = AFF4_IMAGE_STREAM_CHUNK_SHARING;
+
+/**
+ * Use the native turtle parser for container metadata.
+ */
+static bool NATIVE_TURTLE_PARSER = AFF4_NATIVE_TURTLE_PARSER;
+
+/**
+ * The minimum number of entries for a map to be used in place.
+ */
+static uint64_t MAP_IN_PLACE_THRESHOLD = AFF4_MAP_IN_PLACE_THRESHOLD;
+
+/**
+ * The minimum read size for a map to read target streams concurrently.
+ */
+static uint64_t MAP_CONCURRENT_READ_THRESHOLD = AFF4_MAP_CONCURRENT_READ_THRESHOLD;
+
+/**
+ * The read ahead window for a map.
+ */
+static uint64_t MAP_PREFETCH_WINDOW = AFF4_MAP_PREFETCH_WINDOW;
+
+/**
+ * The executor for asynchronous read completions.
+ */
+static aff4::stream::CompletionExecutor COMPLETION_EXECUTOR;
+
+/**
+ * Lock for the completion executor.
+ */
+static std::mutex completionExecutorLock;
+
 /**
  * The default output for debug output.
  */
@@ -55,3 +100,151 @@ uint64_t aff4::stream::setImageStreamCacheSize(uint64_t size) {
 	}
 	return oldValue;
 }
+
+uint64_t aff4::stream::getImageStreamCompressedCacheSize() {
+	return COMPRESSED_CACHE_SIZE;
+}
+
+uint64_t aff4::stream::setImageStreamCompressedCacheSize(uint64_t size) {
+	uint64_t oldValue = COMPRESSED_CACHE_SIZE;
+	COMPRESSED_CACHE_SIZE = size;
+	return oldValue;
+}
+
+bool aff4::stream::isImageStreamChunkSharingEnabled() {
+	return CHUNK_SHARING;
+}
+
+bool aff4::stream::setImageStreamChunkSharingEnabled(bool enabled) {
+	bool oldValue = CHUNK_SHARING;
+	CHUNK_SHARING = enabled;
+	return oldValue;
+}
+
+bool aff4::rdf::isNativeTurtleParserEnabled() {
+	return NATIVE_TURTLE_PARSER;
+}
+
+bool aff4::rdf::setNativeTurtleParserEnabled(bool enabled) {
+	bool oldValue = NATIVE_TURTLE_PARSER;
+	NATIVE_TURTLE_PARSER = enabled;
+	return oldValue;
+}
+
+uint64_t aff4::map::getMapInPlaceThreshold() {
+	return MAP_IN_PLACE_THRESHOLD;
+}
+
+uint64_t aff4::map::setMapInPlaceThreshold(uint64_t entries) {
+	uint64_t oldValue = MAP_IN_PLACE_THRESHOLD;
+	MAP_IN_PLACE_THRESHOLD = entries;
+	return oldValue;
+}
+
+uint64_t aff4::map::getConcurrentReadThreshold() {
+	return MAP_CONCURRENT_READ_THRESHOLD;
+}
+
+uint64_t aff4::map::setConcurrentReadThreshold(uint64_t bytes) {
+	uint64_t oldValue = MAP_CONCURRENT_READ_THRESHOLD;
+	MAP_CONCURRENT_READ_THRESHOLD = bytes;
+	return oldValue;
+}
+
+uint64_t aff4::map::getPrefetchWindow() {
+	return MAP_PREFETCH_WINDOW;
+}
+
+uint64_t aff4::map::setPrefetchWindow(uint64_t bytes) {
+	uint64_t oldValue = MAP_PREFETCH_WINDOW;
+	MAP_PREFETCH_WINDOW = bytes;
+	return oldValue;
+}
+
+uint32_t aff4::executor::getThreadCount() {
+	return (uint32_t) aff4::util::Executor::getDefault().getThreadCount();
+}
+
+uint32_t aff4::executor::setThreadCount(uint32_t threads) {
+	return (uint32_t) aff4::util::Executor::getDefault().setThreadCount(threads);
+}
+
+bool aff4::executor::setThreadAffinity(const std::vector<uint32_t>& cpus) {
+	return aff4::util::Executor::getDefault().setAffinity(cpus);
+}
+
+uint64_t aff4::executor::getQueueLimit(aff4::executor::Priority priority) {
+	return aff4::util::Executor::getDefault().getQueueLimit(priority);
+}
+
+uint64_t aff4::executor::setQueueLimit(aff4::executor::Priority priority, uint64_t limit) {
+	return aff4::util::Executor::getDefault().setQueueLimit(priority, limit);
+}
+
+aff4::executor::HostExecutor aff4::executor::setHostExecutor(aff4::executor::HostExecutor executor) {
+	return aff4::util::Executor::getDefault().setHostExecutor(executor);
+}
+
+aff4::io::IOClass aff4::io::getIOClass() {
+	return aff4::util::IOScheduler::getCurrentClass();
+}
+
+aff4::io::IOClass aff4::io::setIOClass(aff4::io::IOClass ioClass) {
+	return aff4::util::IOScheduler::setCurrentClass(ioClass);
+}
+
+uint32_t aff4::io::getQueueDepth() {
+	return aff4::util::IOScheduler::getDefault().getQueueDepth();
+}
+
+uint32_t aff4::io::setQueueDepth(uint32_t depth) {
+	return aff4::util::IOScheduler::getDefault().setQueueDepth(depth);
+}
+
+uint64_t aff4::io::getRateLimit(aff4::io::IOClass ioClass) {
+	return aff4::util::IOScheduler::getDefault().getRateLimit(ioClass);
+}
+
+uint64_t aff4::io::setRateLimit(aff4::io::IOClass ioClass, uint64_t bytesPerSecond) {
+	return aff4::util::IOScheduler::getDefault().setRateLimit(ioClass, bytesPerSecond);
+}
+
+aff4::stream::CompletionExecutor aff4::stream::setCompletionExecutor(aff4::stream::CompletionExecutor executor) {
+	std::lock_guard<std::mutex> lock(completionExecutorLock);
+	aff4::stream::CompletionExecutor oldValue = COMPLETION_EXECUTOR;
+	COMPLETION_EXECUTOR = executor;
+	return oldValue;
+}
+
+/**
+ * Deliver the completion of an asynchronous read.
+ * @param callback The completion.
+ * @param result The result of the read.
+ * @param error The errno value of a failed read.
+ */
+static void completeRead(const aff4::ReadCallback& callback, int64_t result, int error) {
+	aff4::stream::CompletionExecutor executor;
+	{
+		std::lock_guard<std::mutex> lock(completionExecutorLock);
+		executor = COMPLETION_EXECUTOR;
+	}
+	if (executor) {
+		executor([callback, result, error]() {
+			callback(result, error);
+		});
+	} else {
+		callback(result, error);
+	}
+}
+
+void aff4::stream::queueRead(aff4::IAFF4Stream* stream, void *buf, uint64_t count, uint64_t offset,
+		aff4::ReadCallback callback) {
+	bool queued = aff4::util::Executor::getDefault().submit([stream, buf, count, offset, callback]() {
+		errno = 0;
+		int64_t result = stream->read(buf, count, offset);
+		completeRead(callback, result, (result < 0) ? errno : 0);
+	});
+	if (!queued) {
+		completeRead(callback, -1, EAGAIN);
+	}
+}
@@ -28,6 +28,7 @@
 #ifndef AFF4_H_
 #define AFF4_H_
 
+#include <functional>
 #include <string>
 #include <map>
 #include <vector>
@@ -113,6 +114,310 @@ LIBAFF4_API uint64_t getImageStreamCacheSize();
  */
 LIBAFF4_API uint64_t setImageStreamCacheSize(uint64_t size);
 
+/**
+ * Get the size of the compressed chunk cache (in bytes) each Image Stream will utilise. (system default is 4 MiB).
+ * <p>
+ * Behind the cache of decompressed chunks, each opened aff4:ImageStream keeps the compressed chunks it has read, so
+ * a chunk evicted from the decompressed cache is reloaded with only a decompression. As compressed chunks are
+ * typically several times smaller, this covers more of the image for the same memory.
+ * This value is a global setting, and changes will only apply to new streams as they are opened.
+ * @return The size of the compressed chunk cache each materialised Image Stream will consume.
+ */
+LIBAFF4_API uint64_t getImageStreamCompressedCacheSize();
+
+/**
+ * Set the size of the compressed chunk cache (in bytes) each image stream will utilise.
+ * @param size The new size/limit for each compressed chunk cache. (0 to disable).
+ * @return The old size.
+ */
+LIBAFF4_API uint64_t setImageStreamCompressedCacheSize(uint64_t size);
+
+/**
+ * Is sharing of identical chunks enabled? (system default is enabled).
+ * <p>
+ * When enabled, chunks with identical compressed contents (such as the all-zero and filler chunks common in disk and
+ * memory images) share a single decompressed buffer, and are decompressed once while any stream holds the buffer.
+ * Chunks that decompress to all zeros share a single zero page.
+ * This value is a global setting, and changes will only apply to new streams as they are opened.
+ * @return TRUE if new streams share identical chunks.
+ */
+LIBAFF4_API bool isImageStreamChunkSharingEnabled();
+
+/**
+ * Enable or disable sharing of identical chunks.
+ * @param enabled TRUE to share identical chunks.
+ * @return The old setting.
+ */
+LIBAFF4_API bool setImageStreamChunkSharingEnabled(bool enabled);
+
+/**
+ * Executor used to deliver the completions of asynchronous reads. Called with the completion to run.
+ */
+typedef std::function<void(std::function<void()>)> CompletionExecutor;
+
+/**
+ * Set the executor used to deliver the completions of asynchronous reads. (system default is none).
+ * <p>
+ * With no executor set, completions are run on the library worker thread that serviced the read, so must not block.
+ * @param executor The executor, or nullptr to run completions on the library worker threads.
+ * @return The old executor.
+ */
+LIBAFF4_API CompletionExecutor setCompletionExecutor(CompletionExecutor executor);
+
+}
+
+namespace rdf {
+
+/**
+ * Is the native Turtle parser enabled? (system default is enabled).
+ * <p>
+ * When enabled, container metadata is parsed with a built-in parser for the subset of Turtle written by AFF4
+ * implementations, falling back to raptor for documents it does not handle.
+ * @return TRUE if the native parser will be used for new containers.
+ */
+LIBAFF4_API bool isNativeTurtleParserEnabled();
+
+/**
+ * Enable or disable the native Turtle parser. Changes only apply to containers opened after the call.
+ * @param enabled TRUE to use the native parser, FALSE to always use raptor.
+ * @return The old setting.
+ */
+LIBAFF4_API bool setNativeTurtleParserEnabled(bool enabled);
+
+}
+
+namespace map {
+
+/**
+ * Get the minimum number of entries for an aff4:Map to be used in place. (system default is 65536).
+ * <p>
+ * Maps at least this large, whose map segment is stored uncompressed with sorted, contiguous entries, are memory
+ * mapped and used in place rather than loaded. Smaller maps are loaded, and contiguous entries coalesced.
+ * @return The minimum number of entries.
+ */
+LIBAFF4_API uint64_t getMapInPlaceThreshold();
+
+/**
+ * Set the minimum number of entries for an aff4:Map to be used in place. Changes only apply to maps opened after the
+ * call.
+ * @param entries The minimum number of entries. (UINT64_MAX to always load maps).
+ * @return The old setting.
+ */
+LIBAFF4_API uint64_t setMapInPlaceThreshold(uint64_t entries);
+
+/**
+ * Get the minimum read size for an aff4:Map to read from different target streams concurrently. (system default is 1MB).
+ * <p>
+ * Reads at least this large that span more than one target stream (eg striped images) issue the reads for each
+ * target stream in parallel on the library executor, and wait for all to complete.
+ * @return The minimum read size in bytes.
+ */
+LIBAFF4_API uint64_t getConcurrentReadThreshold();
+
+/**
+ * Set the minimum read size for an aff4:Map to read from different target streams concurrently.
+ * @param bytes The minimum read size in bytes. (0 to always read target streams in turn).
+ * @return The old setting.
+ */
+LIBAFF4_API uint64_t setConcurrentReadThreshold(uint64_t bytes);
+
+/**
+ * Get the read ahead window of an aff4:Map. (system default is 4MB).
+ * <p>
+ * Once an aff4:Map is read sequentially, the chunks of the target streams backing up to this many bytes past the
+ * last read are loaded in the background, following the map entries rather than the target stream layout.
+ * @return The read ahead window in bytes.
+ */
+LIBAFF4_API uint64_t getPrefetchWindow();
+
+/**
+ * Set the read ahead window of an aff4:Map.
+ * @param bytes The read ahead window in bytes. (0 to disable read ahead).
+ * @return The old setting.
+ */
+LIBAFF4_API uint64_t setPrefetchWindow(uint64_t bytes);
+
+}
+
+namespace executor {
+
+/**
+ * The priority of work queued on the library executor.
+ */
+enum Priority {
+	/**
+	 * Speculative work (eg read ahead), run only when nothing else is queued.
+	 */
+	PRIORITY_LOW = 0,
+	/**
+	 * Requested work (eg asynchronous reads).
+	 */
+	PRIORITY_NORMAL = 1,
+	/**
+	 * Work a caller is blocked on (eg the parts of a vectored or concurrent read).
+	 */
+	PRIORITY_HIGH = 2
+};
+
+/**
+ * Host executor, called with a library task and its priority. The task must be run exactly once.
+ */
+typedef std::function<void(std::function<void()>, Priority)> HostExecutor;
+
+/**
+ * Get the number of worker threads of the library executor. (system default is one per core, and at least
+ * AFF4_EXECUTOR_MIN_THREADS).
+ * <p>
+ * All library background work (read ahead, prefetch, asynchronous, vectored and concurrent reads) shares these threads.
+ * @return The number of worker threads.
+ */
+LIBAFF4_API uint32_t getThreadCount();
+
+/**
+ * Set the number of worker threads of the library executor. Queued work is retained.
+ * <p>
+ * Must not be called from a library task.
+ * @param threads The number of worker threads, between 1 and AFF4_EXECUTOR_MAX_THREADS. (0 for the system default).
+ * @return The old setting.
+ */
+LIBAFF4_API uint32_t setThreadCount(uint32_t threads);
+
+/**
+ * Restrict the worker threads of the library executor to the given CPUs.
+ * <p>
+ * Must not be called from a library task.
+ * @param cpus The CPU numbers the workers may run on. (empty for no restriction).
+ * @return TRUE if thread affinity is supported on this platform.
+ */
+LIBAFF4_API bool setThreadAffinity(const std::vector<uint32_t>& cpus);
+
+/**
+ * Get the maximum number of queued tasks of the given priority.
+ * @param priority The priority.
+ * @return The maximum number of queued tasks.
+ */
+LIBAFF4_API uint64_t getQueueLimit(Priority priority);
+
+/**
+ * Set the maximum number of queued tasks of the given priority. Work submitted once the queue is full is refused;
+ * read ahead is dropped, and asynchronous reads fail with EAGAIN.
+ * @param priority The priority.
+ * @param limit The maximum number of queued tasks.
+ * @return The old setting.
+ */
+LIBAFF4_API uint64_t setQueueLimit(Priority priority, uint64_t limit);
+
+/**
+ * Run library tasks on the host's executor rather than the library worker threads. (system default is none).
+ * <p>
+ * Queue limits are not applied to tasks handed to the host executor.
+ * @param executor The host executor, or nullptr to use the library worker threads.
+ * @return The old executor.
+ */
+LIBAFF4_API HostExecutor setHostExecutor(HostExecutor executor);
+
+}
+
+namespace io {
+
+/**
+ * The class of a container read, used to order reads when the container I/O queue is full.
+ */
+enum IOClass {
+	/**
+	 * Speculative reads (eg read ahead). Split into slices, and yield to all other reads.
+	 */
+	IO_SPECULATIVE = 0,
+	/**
+	 * Bulk reads (eg hashing, verification or explicit prefetch). Split into slices, and yield to normal and
+	 * interactive reads.
+	 */
+	IO_BACKGROUND = 1,
+	/**
+	 * Reads of unclassified threads.
+	 */
+	IO_NORMAL = 2,
+	/**
+	 * Reads a user is waiting on.
+	 */
+	IO_INTERACTIVE = 3
+};
+
+/**
+ * Get the I/O class of reads issued by the calling thread. (system default is IO_NORMAL).
+ * <p>
+ * Library tasks run with the class of the thread that queued them; read ahead runs as IO_SPECULATIVE.
+ * @return The I/O class of the calling thread.
+ */
+LIBAFF4_API IOClass getIOClass();
+
+/**
+ * Set the I/O class of reads issued by the calling thread.
+ * @param ioClass The I/O class.
+ * @return The old setting.
+ */
+LIBAFF4_API IOClass setIOClass(IOClass ioClass);
+
+/**
+ * Get the maximum number of container reads in flight before reads are queued by class. (system default is 16).
+ * @return The maximum number of reads in flight.
+ */
+LIBAFF4_API uint32_t getQueueDepth();
+
+/**
+ * Set the maximum number of container reads in flight before reads are queued by class.
+ * <p>
+ * Speculative and background reads may not occupy the last quarter of the queue, which is kept for normal and
+ * interactive reads.
+ * @param depth The maximum number of reads in flight. (0 to disable scheduling).
+ * @return The old setting.
+ */
+LIBAFF4_API uint32_t setQueueDepth(uint32_t depth);
+
+/**
+ * Get the rate limit of reads of the given class. (system default is none).
+ * @param ioClass The I/O class.
+ * @return The rate limit in bytes per second. (0 for no limit).
+ */
+LIBAFF4_API uint64_t getRateLimit(IOClass ioClass);
+
+/**
+ * Set the rate limit of reads of the given class, across all containers.
+ * @param ioClass The I/O class.
+ * @param bytesPerSecond The rate limit in bytes per second. (0 for no limit).
+ * @return The old setting.
+ */
+LIBAFF4_API uint64_t setRateLimit(IOClass ioClass, uint64_t bytesPerSecond);
+
+/**
+ * @brief Set the I/O class of the calling thread for the lifetime of this object.
+ */
+class ScopedIOClass {
+public:
+	/**
+	 * Set the I/O class of the calling thread.
+	 * @param ioClass The I/O class.
+	 */
+	explicit ScopedIOClass(IOClass ioClass) :
+			previous(setIOClass(ioClass)) {
+	}
+
+	/**
+	 * Restore the previous I/O class of the calling thread.
+	 */
+	~ScopedIOClass() {
+		setIOClass(previous);
+	}
+
+	ScopedIOClass(const ScopedIOClass&) = delete;
+	ScopedIOClass& operator=(const ScopedIOClass&) = delete;
+private:
+	/**
+	 * The previous I/O class.
+	 */
+	IOClass previous;
+};
+
 }
 
 } /* namespace aff4 */
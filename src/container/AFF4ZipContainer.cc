@@ -16,33 +16,23 @@
  */
 
 #include "AFF4ZipContainer.h"
+#include "SharedImageStream.h"
 
 namespace aff4 {
 namespace container {
 
 AFF4ZipContainer::AFF4ZipContainer(const std::string& resource, std::unique_ptr<aff4::zip::Zip> parent) :
-		AFF4Resource(resource), parent(std::move(parent)) {
+		AFF4Resource(resource), parent(std::move(parent)), externalResolver(nullptr), metadataLoaded(false) {
 #if DEBUG
 	fprintf( aff4::getDebugOutput(), "%s[%d] : New AFF4 Zip Container: %s : %s \n", __FILE__, __LINE__,
 			this->parent->getFilename().c_str(), resource.c_str());
 #endif
-	// Set base properties
+	// Set base properties. (version.txt and the RDF model are loaded on first use).
 	setBasicProperties();
-	// Load version.txt
-	loadVersionInformation();
-	// Load the RDF model.
-	loadModel();
-	// Add information about THIS object to the object properties.
-	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> elements = model->getObjectInformation(resource);
-	if (!elements.empty()) {
-		for (auto it = elements.begin(); it != elements.end(); it++) {
-			addProperty(it->first, it->second);
-		}
-	}
 }
 
 AFF4ZipContainer::~AFF4ZipContainer() {
-	parent->close();
+	close();
 }
 
 void AFF4ZipContainer::setBasicProperties() noexcept {
@@ -50,6 +40,38 @@ void AFF4ZipContainer::setBasicProperties() noexcept {
 	addProperty(aff4::Lexicon::AFF4_STORED, aff4::rdf::RDFValue(parent->getFilename()));
 }
 
+void AFF4ZipContainer::loadMetadata() noexcept {
+	if (metadataLoaded) {
+		return;
+	}
+	try {
+		std::call_once(metadataFlag, [this]() {
+			// Load version.txt
+			loadVersionInformation();
+			// Load the RDF model.
+			loadModel();
+			// Add information about THIS object to the object properties.
+			std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> elements = //
+					aff4::rdf::Model::getSharedObjectInformation(model, getResourceID());
+			if (elements != nullptr) {
+				for (auto it = elements->begin(); it != elements->end(); it++) {
+					addProperty(it->first, it->second);
+				}
+			}
+			metadataLoaded = true;
+		});
+	} catch (...) {
+#if DEBUG
+		fprintf( aff4::getDebugOutput(), "%s[%d] : Failed to load metadata : %s\n", __FILE__, __LINE__,
+				parent->getFilename().c_str());
+#endif
+	}
+}
+
+bool AFF4ZipContainer::isMetadataLoaded() const noexcept {
+	return metadataLoaded;
+}
+
 void AFF4ZipContainer::loadVersionInformation() noexcept {
 	std::string version(AFF4_VERSIONDESCRIPTIONFILE);
 	std::shared_ptr<IAFF4Stream> stream = parent->getStream(version);
@@ -122,6 +144,7 @@ void AFF4ZipContainer::loadModel() noexcept {
 }
 
 std::shared_ptr<aff4::rdf::Model> AFF4ZipContainer::getRDFModel() noexcept {
+	loadMetadata();
 	return model;
 }
 
@@ -131,6 +154,11 @@ std::shared_ptr<IAFF4Stream> AFF4ZipContainer::getSegment(const std::string& seg
 	return stream;
 }
 
+std::shared_ptr<const uint8_t> AFF4ZipContainer::mapSegment(const std::string& segmentName, uint64_t& size) noexcept {
+	std::string res = sanitizeResource(segmentName);
+	return parent->mapSegment(res, size);
+}
+
 std::shared_ptr<aff4::zip::ZipEntry> AFF4ZipContainer::getSegmentEntry(const std::string& segmentName) noexcept {
 	std::string res = sanitizeResource(segmentName);
 	std::vector<std::shared_ptr<aff4::zip::ZipEntry>> entries = parent->getEntries();
@@ -169,42 +197,91 @@ std::shared_ptr<IAFF4Stream> AFF4ZipContainer::getImageStream(const std::string&
 	if (aff4::util::hasPrefix(resource, lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_SYMBOLIC_PREFIX))) {
 		return aff4::stream::createSymbolicStream(resource);
 	}
+	loadMetadata();
+	if (model == nullptr) {
+		return nullptr;
+	}
 	/*
 	 * Check for aff4:ImageStream contained in us.
 	 */
-	std::vector<std::string> availableStreams = model->getResourcesOfType(aff4::Lexicon::AFF4_IMAGESTREAM_TYPE);
-	for (std::string streamID : availableStreams) {
-		if (streamID == resource) {
-			// We have this stream in our model.
-			std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> properties = model->getObjectInformation(
-					resource);
-			auto entry = properties.find(aff4::Lexicon::AFF4_STORED);
-			if (entry != properties.end()) {
-				for (aff4::rdf::RDFValue v : entry->second) {
-					if (v.getXSDType() == aff4::rdf::XSDType::Resource) {
-						std::string value = v.getValue();
-						if (value == getResourceID()) {
-							// This stream is stored in us...
-							std::shared_ptr<aff4::stream::ImageStream> stream = //
-									std::make_shared<aff4::stream::ImageStream>(resource, this);
-							return stream;
-						}
-					}
-				}
-			} else {
-				// No stored property, instead look for resource index file in underlying zip container.
-				std::string res = sanitizeResource(resource + "/00000000.index");
-				if (parent->hasEntry(res)) {
-					std::shared_ptr<aff4::stream::ImageStream> stream = //
-							std::make_shared<aff4::stream::ImageStream>(resource, this);
-					return stream;
-				}
-			}
+	if (!model->isResourceOfType(resource, aff4::Lexicon::AFF4_IMAGESTREAM_TYPE)) {
+		return nullptr;
+	}
+	// We have this stream in our model, see if it is stored in us.
+	const std::vector<std::string>& storedStreams = model->getResourcesWithProperty(aff4::Lexicon::AFF4_STORED,
+			getResourceID());
+	if (std::binary_search(storedStreams.begin(), storedStreams.end(), resource)) {
+		return createImageStream(resource);
+	}
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties = //
+			aff4::rdf::Model::getSharedObjectInformation(model, resource);
+	if ((properties != nullptr) && (properties->find(aff4::Lexicon::AFF4_STORED) == properties->end())) {
+		// No stored property, instead look for resource index file in underlying zip container.
+		std::string res = sanitizeResource(resource + "/00000000.index");
+		if (parent->hasEntry(res)) {
+			return createImageStream(resource);
 		}
 	}
 	return nullptr;
 }
 
+std::shared_ptr<IAFF4Stream> AFF4ZipContainer::createImageStream(const std::string& resource) noexcept {
+	std::shared_ptr<aff4::stream::structs::SharedImageStream> stream = getSharedImageStream(resource);
+	if (stream == nullptr) {
+		return nullptr;
+	}
+	return std::make_shared<aff4::stream::ImageStream>(stream);
+}
+
+std::shared_ptr<aff4::stream::structs::SharedImageStream> AFF4ZipContainer::getSharedImageStream(
+		const std::string& resource) noexcept {
+	{
+		std::lock_guard<std::mutex> lock(imageStreamsLock);
+		auto it = imageStreams.find(resource);
+		if (it != imageStreams.end()) {
+			std::shared_ptr<aff4::stream::structs::SharedImageStream> stream = it->second.lock();
+			if ((stream != nullptr) && !stream->isClosed()) {
+				return stream;
+			}
+		}
+	}
+	// Construct outside of the lock, as the stream reads its bevvy information from us.
+	std::shared_ptr<aff4::stream::structs::SharedImageStream> stream =
+			std::make_shared<aff4::stream::structs::SharedImageStream>(resource, this);
+	std::lock_guard<std::mutex> lock(imageStreamsLock);
+	std::weak_ptr<aff4::stream::structs::SharedImageStream>& entry = imageStreams[resource];
+	std::shared_ptr<aff4::stream::structs::SharedImageStream> existing = entry.lock();
+	if ((existing != nullptr) && !existing->isClosed()) {
+		// Another consumer beat us to it.
+		return existing;
+	}
+	entry = stream;
+	// Drop registrations of streams no longer held by anyone.
+	for (auto it = imageStreams.begin(); it != imageStreams.end();) {
+		if (it->second.expired()) {
+			it = imageStreams.erase(it);
+		} else {
+			it++;
+		}
+	}
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : Registered aff4:ImageStream : %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+	return stream;
+}
+
+size_t AFF4ZipContainer::getLiveImageStreamCount() noexcept {
+	std::lock_guard<std::mutex> lock(imageStreamsLock);
+	size_t count = 0;
+	for (auto it = imageStreams.begin(); it != imageStreams.end(); it++) {
+		std::shared_ptr<aff4::stream::structs::SharedImageStream> stream = it->second.lock();
+		if ((stream != nullptr) && !stream->isClosed()) {
+			count++;
+		}
+	}
+	return count;
+}
+
 std::string AFF4ZipContainer::sanitizeResource(const std::string& resource) noexcept {
 	std::string res = resource;
 #if DEBUG
@@ -236,10 +313,11 @@ std::string AFF4ZipContainer::sanitizeResource(const std::string& resource) noex
 
 std::vector<std::shared_ptr<IAFF4Image>> AFF4ZipContainer::getImages() noexcept {
 	// Scan for images on first call, and cache created objects.
-	if (images.empty()) {
+	loadMetadata();
+	if (images.empty() && (model != nullptr)) {
 		// Look for all objects that have a RDFType of aff4:Image.
-		std::vector<std::string> resources = model->getResourcesOfType(aff4::Lexicon::AFF4_IMAGE_TYPE);
-		for (std::string resource : resources) {
+		const std::vector<std::string>& resources = model->getResourcesOfType(aff4::Lexicon::AFF4_IMAGE_TYPE);
+		for (const std::string& resource : resources) {
 			std::shared_ptr<aff4::image::AFF4Image> image = std::make_shared<aff4::image::AFF4Image>(resource, this);
 			images.push_back(image);
 		}
@@ -258,11 +336,9 @@ std::shared_ptr<IAFF4Image> AFF4ZipContainer::getImage(const std::string& resour
 }
 
 std::shared_ptr<IAFF4Map> AFF4ZipContainer::getMap(const std::string& resource) noexcept {
-	std::vector<std::string> objects = model->getResourcesOfType(aff4::Lexicon::AFF4_MAP_TYPE);
-	for (std::string object : objects) {
-		if (object.compare(resource) == 0) {
-			return std::make_shared<aff4::map::AFF4Map>(resource, this);
-		}
+	loadMetadata();
+	if ((model != nullptr) && model->isResourceOfType(resource, aff4::Lexicon::AFF4_MAP_TYPE)) {
+		return std::make_shared<aff4::map::AFF4Map>(resource, this);
 	}
 	return nullptr;
 }
@@ -276,7 +352,28 @@ IAFF4Resolver* AFF4ZipContainer::getResolver() noexcept {
 }
 
 void AFF4ZipContainer::close() noexcept {
+	// Close the streams still held by consumers first, waiting for their background loads to stop using our Zip.
+	std::vector<std::shared_ptr<aff4::stream::structs::SharedImageStream>> streams;
+	{
+		std::lock_guard<std::mutex> lock(imageStreamsLock);
+		for (auto it = imageStreams.begin(); it != imageStreams.end(); it++) {
+			std::shared_ptr<aff4::stream::structs::SharedImageStream> stream = it->second.lock();
+			if (stream != nullptr) {
+				streams.push_back(stream);
+			}
+		}
+		imageStreams.clear();
+	}
+	for (std::shared_ptr<aff4::stream::structs::SharedImageStream>& stream : streams) {
+		stream->close();
+	}
 	parent->close();
+	// Drop our references to the metadata, so the model arena is released once no opened object shares it.
+	std::call_once(metadataFlag, [this]() {
+		metadataLoaded = true;
+	});
+	images.clear();
+	model.reset();
 }
 
 /*
@@ -361,12 +458,24 @@ aff4::Lexicon AFF4ZipContainer::getBaseType() noexcept {
 }
 
 std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> AFF4ZipContainer::getProperties() noexcept {
+	loadMetadata();
 	return AFF4Resource::getProperties();
 }
 
 std::vector<aff4::rdf::RDFValue> AFF4ZipContainer::getProperty(aff4::Lexicon resource) noexcept {
+	loadMetadata();
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> AFF4ZipContainer::getPropertyMap() noexcept {
+	loadMetadata();
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> AFF4ZipContainer::getPropertyValues(aff4::Lexicon resource) noexcept {
+	loadMetadata();
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 } /* namespace container */
 } /* namespace aff4 */
@@ -33,8 +33,11 @@
 #include "aff4.h"
 
 #include <atomic>
+#include <mutex>
+#include <algorithm>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <string>
 #include <sstream>
 #include <memory>
@@ -48,6 +51,24 @@
 #include "ImageStream.h"
 #include "AFF4Map.h"
 
+#ifndef ImageStream
+namespace aff4 {
+namespace stream {
+class ImageStream;
+}
+}
+#endif
+
+#ifndef SharedImageStream
+namespace aff4 {
+namespace stream {
+namespace structs {
+class SharedImageStream;
+}
+}
+}
+#endif
+
 namespace aff4 {
 /**
  * @brief Base AFF4 Container implementations.
@@ -75,6 +96,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * From IAFF4Resolver
@@ -92,6 +115,8 @@ public:
 
 	/**
 	 * Get the RDF Model for this container.
+	 * <p>
+	 * The model (and version.txt) are loaded on the first call to any method that depends on container metadata.
 	 * @return The RDF model for this container.
 	 */
 	LIBAFF4_API std::shared_ptr<aff4::rdf::Model> getRDFModel() noexcept;
@@ -111,8 +136,22 @@ public:
 	 */
 	LIBAFF4_API std::shared_ptr<IAFF4Stream> getSegment(const std::string& segmentName) noexcept;
 
+	/**
+	 * Map the contents of the given stored (uncompressed) segment read only into memory.
+	 *
+	 * @param segmentName The name of the segment to map
+	 * @param size Set to the length of the segment.
+	 * @return The segment contents, or NULL if the segment doesn't exist, is compressed or can't be mapped.
+	 */
+	LIBAFF4_API std::shared_ptr<const uint8_t> mapSegment(const std::string& segmentName, uint64_t& size) noexcept;
+
 	/**
 	 * Create a readable image stream for the given aff4:ImageStream resource name.
+	 * <p>
+	 * Each call returns a new stream, but streams stored in this container share their caches: while any consumer
+	 * holds a stream for a resource, every stream opened on that resource reads through the same bevvy index cache,
+	 * chunk cache and compressed chunk cache. Closing a stream only closes that instance; closing the container
+	 * closes them all.
 	 *
 	 * @param resource The name of the aff4:ImageStream resource to open
 	 * @return A Stream, or NULL if segment doesn't exist or is unreadable.
@@ -143,6 +182,18 @@ public:
 	 * @return The number of bytes read. (0 indicates nothing read, or -1 indicates error.
 	 */
 	LIBAFF4_API int64_t fileRead(void *buf, uint64_t count, uint64_t offset) noexcept;
+
+	/**
+	 * Has the container metadata (version.txt and the RDF model) been loaded?
+	 * @return TRUE if the metadata has been loaded.
+	 */
+	LIBAFF4_API bool isMetadataLoaded() const noexcept;
+
+	/**
+	 * Get the number of aff4:ImageStreams whose caches are currently shared by consumers of this container.
+	 * @return The number of live image streams.
+	 */
+	LIBAFF4_API size_t getLiveImageStreamCount() noexcept;
 private:
 	/**
 	 * The parent zip container
@@ -160,6 +211,23 @@ private:
 	 * The RDF model.
 	 */
 	std::shared_ptr<aff4::rdf::Model> model;
+	/**
+	 * One time load of the container metadata.
+	 */
+	std::once_flag metadataFlag;
+	/**
+	 * Has the container metadata been loaded.
+	 */
+	std::atomic<bool> metadataLoaded;
+	/**
+	 * Registry of the shared state (caches) of opened aff4:ImageStreams, shared by all streams opened on a resource
+	 * while any are held.
+	 */
+	std::unordered_map<std::string, std::weak_ptr<aff4::stream::structs::SharedImageStream>> imageStreams;
+	/**
+	 * Lock for the image stream registry.
+	 */
+	std::mutex imageStreamsLock;
 	/**
 	 * The collection of base properties for this container.
 	 */
@@ -175,6 +243,28 @@ private:
 	 */
 	void loadModel() noexcept;
 
+	/**
+	 * Load version.txt and the RDF model, if not already loaded.
+	 */
+	void loadMetadata() noexcept;
+
+	/**
+	 * Create a new aff4:ImageStream for the given resource, reading through the resource's shared state.
+	 *
+	 * @param resource The name of the aff4:ImageStream resource stored in this container.
+	 * @return The image stream.
+	 */
+	std::shared_ptr<IAFF4Stream> createImageStream(const std::string& resource) noexcept;
+
+	/**
+	 * Get the shared state of the aff4:ImageStream for the given resource, creating (and registering) it if no
+	 * consumer holds it.
+	 *
+	 * @param resource The name of the aff4:ImageStream resource stored in this container.
+	 * @return The shared image stream state.
+	 */
+	std::shared_ptr<aff4::stream::structs::SharedImageStream> getSharedImageStream(const std::string& resource) noexcept;
+
 	/**
 	 * Attempt to sanitise the given resource string
 	 *
@@ -26,37 +26,24 @@ AFF4Image::AFF4Image(const std::string& resource, aff4::container::AFF4ZipContai
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Create Image? %s\n", __FILE__, __LINE__, resource.c_str());
 #endif
 	std::shared_ptr<aff4::rdf::Model> model = parent->getRDFModel();
-	// Add information about THIS object to the object properties.
-	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> elements = model->getObjectInformation(resource);
-	if (!elements.empty()) {
-		for (auto it = elements.begin(); it != elements.end(); it++) {
-			addProperty(it->first, it->second);
-		}
-	}
+	// Share the model's information about THIS object as the object properties.
+	setProperties(aff4::rdf::Model::getSharedObjectInformation(model, resource));
 	// Also look for aff4::CaseDetails where aff4:target == us.
-	std::vector<std::string> resources = model->getResourcesOfType(aff4::Lexicon::AFF4_CASE_DETAILS);
-	for (std::string res : resources) {
-		std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> elements = model->getObjectInformation(res);
-		if (!elements.empty()) {
-			for (auto it = elements.begin(); it != elements.end(); it++) {
-				if (it->first == aff4::Lexicon::AFF4_TARGET) {
-					std::vector<aff4::rdf::RDFValue> values = it->second;
-					for (aff4::rdf::RDFValue v : values) {
-						if ((v.getXSDType() == aff4::rdf::XSDType::Resource) && v.getValue() == resource) {
-							// The aff4:target property is us!
-							for (auto it2 = elements.begin(); it2 != elements.end(); it2++) {
-								if (it2->first == aff4::Lexicon::AFF4_CASE_NAME) {
-									addProperty(it2->first, it2->second);
-								} else if (it2->first == aff4::Lexicon::AFF4_CASE_DESCRIPTION) {
-									addProperty(it2->first, it2->second);
-								} else if (it2->first == aff4::Lexicon::AFF4_CASE_EXAMINER) {
-									addProperty(it2->first, it2->second);
-								}
-							}
-							break;
-						}
-					}
-				}
+	const std::vector<std::string>& resources = model->getResourcesWithProperty(aff4::Lexicon::AFF4_TARGET, resource);
+	for (const std::string& res : resources) {
+		if (!model->isResourceOfType(res, aff4::Lexicon::AFF4_CASE_DETAILS)) {
+			continue;
+		}
+		// The aff4:target property is us! (Only these case properties are copied into our own properties).
+		std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> elements = //
+				aff4::rdf::Model::getSharedObjectInformation(model, res);
+		for (auto it = elements->begin(); it != elements->end(); it++) {
+			if (it->first == aff4::Lexicon::AFF4_CASE_NAME) {
+				addProperty(it->first, it->second);
+			} else if (it->first == aff4::Lexicon::AFF4_CASE_DESCRIPTION) {
+				addProperty(it->first, it->second);
+			} else if (it->first == aff4::Lexicon::AFF4_CASE_EXAMINER) {
+				addProperty(it->first, it->second);
 			}
 		}
 	}
@@ -75,18 +62,17 @@ std::shared_ptr<aff4::IAFF4Map> AFF4Image::getMap() noexcept {
 #if DEBUG
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Open Map for Image. %s\n", __FILE__, __LINE__, getResourceID().c_str());
 #endif
-	std::vector<aff4::rdf::RDFValue> values = getProperty(aff4::Lexicon::AFF4_DATASTREAM);
-	if (!values.empty()) {
-		aff4::rdf::RDFValue v = values[0];
-		std::string resource = v.getValue();
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> dataStreams = getPropertyValues(aff4::Lexicon::AFF4_DATASTREAM);
+	if (!dataStreams->empty()) {
+		std::string resource = (*dataStreams)[0].getValue();
 		if (!resource.empty()) {
 			return std::make_shared<aff4::map::AFF4Map>(resource, parent);
 		}
 	}
 	// Recheck to see if we are a aff4:Map?
-	values = getProperty(aff4::Lexicon::AFF4_TYPE);
-	if (!values.empty()) {
-		for (aff4::rdf::RDFValue v : values) {
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> types = getPropertyValues(aff4::Lexicon::AFF4_TYPE);
+	if (!types->empty()) {
+		for (const aff4::rdf::RDFValue& v : *types) {
 			if (v.getType() == aff4::Lexicon::AFF4_MAP_TYPE) {
 				return std::make_shared<aff4::map::AFF4Map>(getResourceID(), parent);
 			}
@@ -118,5 +104,13 @@ std::vector<aff4::rdf::RDFValue> AFF4Image::getProperty(aff4::Lexicon resource)
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> AFF4Image::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> AFF4Image::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 } /* namespace image */
 } /* namespace aff4 */
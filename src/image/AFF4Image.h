@@ -81,6 +81,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * From IAFF4Image
@@ -26,27 +26,21 @@ AFF4Map::AFF4Map(const std::string& resource, aff4::container::AFF4ZipContainer*
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Create Map  %s \n", __FILE__, __LINE__, getResourceID().c_str());
 #endif
 
-	std::shared_ptr<aff4::rdf::Model> model = parent->getRDFModel();
-	// Add information about THIS object to the object properties.
-	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> elements = model->getObjectInformation(resource);
-	if (!elements.empty()) {
-		for (auto it = elements.begin(); it != elements.end(); it++) {
-			addProperty(it->first, it->second);
-		}
-	}
+	// Share the model's information about THIS object as the object properties.
+	setProperties(aff4::rdf::Model::getSharedObjectInformation(parent->getRDFModel(), resource));
 
 	/*
 	 * Get the length of the map according to the RDF model.
 	 */
-	std::vector<aff4::rdf::RDFValue> values = getProperty(aff4::Lexicon::AFF4_SIZE);
-	if (!values.empty()) {
-		if (values[0].getXSDType() == aff4::rdf::XSDType::Long) {
-			length = values[0].getLong();
-		} else if (values[0].getXSDType() == aff4::rdf::XSDType::Int) {
-			length = values[0].getInteger();
-		} else if (values[0].getXSDType() == aff4::rdf::XSDType::String) {
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> sizes = getPropertyValues(aff4::Lexicon::AFF4_SIZE);
+	if (!sizes->empty()) {
+		if ((*sizes)[0].getXSDType() == aff4::rdf::XSDType::Long) {
+			length = (*sizes)[0].getLong();
+		} else if ((*sizes)[0].getXSDType() == aff4::rdf::XSDType::Int) {
+			length = (*sizes)[0].getInteger();
+		} else if ((*sizes)[0].getXSDType() == aff4::rdf::XSDType::String) {
 			try {
-				length = (int64_t)std::stoll(values[0].getValue());
+				length = (int64_t)std::stoll((*sizes)[0].getValue());
 			} catch (...){
 				// ignore
 			}
@@ -59,14 +53,14 @@ AFF4Map::AFF4Map(const std::string& resource, aff4::container::AFF4ZipContainer*
 	/*
 	 * Get the map GapStream instance.
 	 */
-	values = getProperty(aff4::Lexicon::AFF4_MAP_GAP_STREAM);
-	if (!values.empty()) {
-		aff4::rdf::RDFValue v = values[0];
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> gapStreams = getPropertyValues(aff4::Lexicon::AFF4_MAP_GAP_STREAM);
+	if (!gapStreams->empty()) {
+		const aff4::rdf::RDFValue& v = (*gapStreams)[0];
 		if (v.getType() != aff4::Lexicon::UNKNOWN) {
 			std::string mapGPS = aff4::lexicon::getLexiconString(v.getType());
 			mapGapStreamOverride = parent->getImageStream(mapGPS);
 		} else {
-			mapGapStreamOverride = parent->getImageStream(values[0].getValue());
+			mapGapStreamOverride = parent->getImageStream((*gapStreams)[0].getValue());
 		}
 	}
 	// Set system default if nothing provided in the model.
@@ -76,8 +70,8 @@ AFF4Map::AFF4Map(const std::string& resource, aff4::container::AFF4ZipContainer*
 #if DEBUG
 	fprintf(aff4::getDebugOutput(), "%s[%d] : mapGapDefaultStream = %s\n", __FILE__, __LINE__, mapGapStreamOverride->getResourceID().c_str());
 #endif
-	values = getProperty(aff4::Lexicon::AFF4_DEPENDENT_STREAM);
-	if (values.empty()) {
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> dependentStreams = getPropertyValues(aff4::Lexicon::AFF4_DEPENDENT_STREAM);
+	if (dependentStreams->empty()) {
 		/*
 		 * No dependent streams provided. Load the idx file and extract from there.
 		 */
@@ -143,10 +137,15 @@ uint64_t AFF4Map::size() const {
 std::shared_ptr<IAFF4Stream> AFF4Map::getStream() noexcept {
 	std::lock_guard<std::recursive_mutex> lock(mapLock);
 	/*
-	 * Always generate a new map stream. Note: This is inline with the Java based reader as well.
+	 * Always generate a new map stream, but only parse the map, idx and dependent streams once.
 	 */
-	return std::make_shared<aff4::stream::MapStream>(getResourceID(), parent, length, unknownOverride,
-			mapGapStreamOverride);
+	if (table != nullptr) {
+		return std::make_shared<aff4::stream::MapStream>(getResourceID(), table);
+	}
+	std::shared_ptr<aff4::stream::MapStream> stream = std::make_shared<aff4::stream::MapStream>(getResourceID(), parent,
+			length, unknownOverride, mapGapStreamOverride);
+	table = stream->getTable();
+	return stream;
 }
 
 std::shared_ptr<IAFF4Stream> AFF4Map::getUnknownStreamOverride() noexcept {
@@ -157,6 +156,7 @@ std::shared_ptr<IAFF4Stream> AFF4Map::getUnknownStreamOverride() noexcept {
 void AFF4Map::setUnknownStreamOverride(std::shared_ptr<IAFF4Stream>& stream) noexcept {
 	std::lock_guard<std::recursive_mutex> lock(mapLock);
 	unknownOverride = stream;
+	table = nullptr;
 }
 
 std::shared_ptr<IAFF4Stream> AFF4Map::getMapGapStreamOverride() noexcept {
@@ -167,6 +167,7 @@ std::shared_ptr<IAFF4Stream> AFF4Map::getMapGapStreamOverride() noexcept {
 void AFF4Map::setMapGapStreamOverride(std::shared_ptr<IAFF4Stream>& stream) noexcept {
 	std::lock_guard<std::recursive_mutex> lock(mapLock);
 	mapGapStreamOverride = stream;
+	table = nullptr;
 }
 
 /*
@@ -189,5 +190,13 @@ std::vector<aff4::rdf::RDFValue> AFF4Map::getProperty(aff4::Lexicon resource) no
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> AFF4Map::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> AFF4Map::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 } /* namespace map */
 } /* namespace aff4 */
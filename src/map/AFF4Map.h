@@ -55,6 +55,14 @@ class AFF4ZipContainer;
 }
 #endif
 
+#ifndef MapTable
+namespace aff4 {
+namespace stream {
+struct MapTable;
+}
+}
+#endif
+
 namespace aff4 {
 
 /**
@@ -83,6 +91,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * From IAFF4Map
@@ -115,6 +125,10 @@ private:
 	 * Map Gap Stream override
 	 */
 	std::shared_ptr<IAFF4Stream> mapGapStreamOverride;
+	/**
+	 * The parsed map table, shared by all map streams created. (Rebuilt if an override changes).
+	 */
+	std::shared_ptr<const aff4::stream::MapTable> table;
 
 };
 
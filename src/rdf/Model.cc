@@ -16,10 +16,18 @@
  */
 
 #include "Model.h"
+#include "TurtleParser.h"
+
+#include <algorithm>
 
 namespace aff4 {
 namespace rdf {
 
+/**
+ * Empty result for index queries that have no matches.
+ */
+static const std::vector<std::string> emptyResources;
+
 /**
  * Global static statement handler
  * @param user_data The pointer to the Model object
@@ -31,23 +39,11 @@ static void statement_Handler(void* user_data, raptor_statement* statement) {
 }
 
 Model::Model() :
-		world(nullptr), parser(nullptr) {
-	world = raptor_new_world();
-	parser = raptor_new_parser(world, "turtle");
-
-	/*
-	 * Initialise raptor.
-	 */
-	raptor_parser_set_statement_handler(parser, this, statement_Handler);
-
-	// Dont talk to the internet
-	raptor_parser_set_option(parser, RAPTOR_OPTION_NO_NET, nullptr, 1);
-	raptor_parser_set_option(parser, RAPTOR_OPTION_ALLOW_RDF_TYPE_RDF_LIST, nullptr, 1);
-
-	raptor_uri* uri = raptor_new_uri(world, (const unsigned char*) ".");
-	raptor_parser_parse_start(parser, uri);
-	raptor_free_uri(uri);
-
+		world(nullptr), parser(nullptr), arena(std::make_shared<aff4::util::Arena>()), //
+		model(std::less<std::string>(), aff4::util::ArenaAllocator<ObjectEntry>(arena)), //
+		typeIndex(std::less<aff4::Lexicon>(), aff4::util::ArenaAllocator<ObjectEntry>(arena)), //
+		propertyIndex(std::less<aff4::Lexicon>(), aff4::util::ArenaAllocator<ObjectEntry>(arena)), //
+		interner(arena), currentSubject(nullptr), currentProperties(nullptr) {
 }
 
 Model::~Model() {
@@ -59,10 +55,111 @@ Model::~Model() {
 }
 
 int Model::parse(unsigned char* buffer, uint64_t size) {
+	// The native parser is all or nothing, so only attempt it on an empty model.
+	if ((buffer != nullptr) && (size > 0) && model.empty() && aff4::rdf::isNativeTurtleParserEnabled()) {
+		if (parseNative(reinterpret_cast<const char*>(buffer), size)) {
+			finaliseIndexes();
+			return 0;
+		}
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Native turtle parser failed, falling back to raptor\n", __FILE__,
+				__LINE__);
+#endif
+		clear();
+	}
+	int res = parseRaptor(buffer, size);
+	finaliseIndexes();
+	return res;
+}
+
+bool Model::parseNative(const char* buffer, uint64_t size) noexcept {
+	TurtleParser turtle(buffer, size,
+			[this](const std::string& subject, aff4::Lexicon property, const RDFValue& value) {
+				addStatement(subject, property, value);
+			});
+	return turtle.parse();
+}
+
+int Model::parseRaptor(unsigned char* buffer, uint64_t size) noexcept {
+	if (world == nullptr) {
+		world = raptor_new_world();
+		parser = raptor_new_parser(world, "turtle");
+		if (parser == nullptr) {
+			return -1;
+		}
+		/*
+		 * Initialise raptor.
+		 */
+		raptor_parser_set_statement_handler(parser, this, statement_Handler);
+
+		// Dont talk to the internet
+		raptor_parser_set_option(parser, RAPTOR_OPTION_NO_NET, nullptr, 1);
+		raptor_parser_set_option(parser, RAPTOR_OPTION_ALLOW_RDF_TYPE_RDF_LIST, nullptr, 1);
+
+		raptor_uri* uri = raptor_new_uri(world, (const unsigned char*) ".");
+		raptor_parser_parse_start(parser, uri);
+		raptor_free_uri(uri);
+	}
+	if (parser == nullptr) {
+		return -1;
+	}
 	return raptor_parser_parse_chunk(parser, buffer, (size_t) size, 1);
 }
 
-std::map<aff4::Lexicon, std::vector<RDFValue>> Model::getObjectInformation(const std::string& resource) {
+void Model::clear() noexcept {
+	model.clear();
+	typeIndex.clear();
+	propertyIndex.clear();
+	interner.clear();
+	currentSubject = nullptr;
+	currentProperties = nullptr;
+}
+
+void Model::addStatement(const std::string& subject, aff4::Lexicon property, const RDFValue& value) {
+	// Statements typically arrive grouped by subject, so avoid the model lookup for repeats.
+	if ((currentSubject == nullptr) || (*currentSubject != subject)) {
+		auto it = model.insert(std::make_pair(subject, std::map<aff4::Lexicon, std::vector<RDFValue>>())).first;
+		currentSubject = &it->first;
+		currentProperties = &it->second;
+	}
+	// Update the secondary indexes.
+	if (property == aff4::Lexicon::AFF4_TYPE) {
+		typeIndex[value.getType()].push_back(subject);
+	} else if (value.getXSDType() == XSDType::Resource) {
+		auto prop = propertyIndex.find(property);
+		if (prop == propertyIndex.end()) {
+			prop = propertyIndex.insert(std::make_pair(property,
+					ObjectIndex(0, std::hash<std::string>(), std::equal_to<std::string>(),
+							aff4::util::ArenaAllocator<ObjectIndexEntry>(arena)))).first;
+		}
+		prop->second[value.getValue()].push_back(subject);
+	}
+	// Add into the map, sharing any repeated strings.
+	std::vector<RDFValue>& values = (*currentProperties)[property];
+	values.push_back(value);
+	interner.intern(values.back());
+}
+
+void Model::finaliseIndexes() noexcept {
+	auto sortUnique = [](std::vector<std::string>& resources) {
+		std::sort(resources.begin(), resources.end());
+		resources.erase(std::unique(resources.begin(), resources.end()), resources.end());
+	};
+	for (auto it = typeIndex.begin(); it != typeIndex.end(); it++) {
+		sortUnique(it->second);
+	}
+	for (auto prop = propertyIndex.begin(); prop != propertyIndex.end(); prop++) {
+		for (auto it = prop->second.begin(); it != prop->second.end(); it++) {
+			sortUnique(it->second);
+		}
+	}
+}
+
+size_t Model::getInternedStringCount() const noexcept {
+	return interner.size();
+}
+
+std::map<aff4::Lexicon, std::vector<RDFValue>> Model::getObjectInformation(const std::string& resource) const {
 	auto obj = model.find(resource);
 	if (obj != model.end()) {
 		return obj->second;
@@ -71,130 +168,163 @@ std::map<aff4::Lexicon, std::vector<RDFValue>> Model::getObjectInformation(const
 	return empty;
 }
 
-LIBAFF4_API_LOCAL std::vector<std::string> Model::getResourcesOfType(aff4::Lexicon type) {
-	std::vector<std::string> results;
-	for (auto it = model.begin(); it != model.end(); it++) {
-		std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> properties = it->second;
-		for (auto prop = properties.begin(); prop != properties.end(); prop++) {
-			if (prop->first == aff4::Lexicon::AFF4_TYPE) {
-				std::vector<RDFValue> values = prop->second;
-				for (RDFValue v : values) {
-					if (v.getType() == type) {
-						results.push_back(it->first);
-						break;
-					}
-				}
-			}
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<RDFValue>>> Model::getSharedObjectInformation(
+		const std::shared_ptr<Model>& model, const std::string& resource) noexcept {
+	if (model == nullptr) {
+		return nullptr;
+	}
+	auto obj = model->model.find(resource);
+	if (obj == model->model.end()) {
+		return nullptr;
+	}
+	// Aliasing constructor, the view keeps the whole model alive.
+	return std::shared_ptr<const std::map<aff4::Lexicon, std::vector<RDFValue>>>(model, &obj->second);
+}
+
+const std::vector<std::string>& Model::getResourcesOfType(aff4::Lexicon type) const {
+	auto it = typeIndex.find(type);
+	if (it != typeIndex.end()) {
+		return it->second;
+	}
+	return emptyResources;
+}
+
+const std::vector<std::string>& Model::getResourcesWithProperty(aff4::Lexicon property,
+		const std::string& object) const {
+	auto prop = propertyIndex.find(property);
+	if (prop != propertyIndex.end()) {
+		auto it = prop->second.find(object);
+		if (it != prop->second.end()) {
+			return it->second;
 		}
 	}
-	return results;
+	return emptyResources;
 }
 
-std::unique_ptr<aff4::rdf::RDFValue> Model::getValueFromRaptorTerm(aff4::Lexicon property, raptor_term* term) noexcept {
-	if (term->type == RAPTOR_TERM_TYPE_URI) {
-		// Need to use URI to string, as internals of URI are hidden...
-		char* uri = reinterpret_cast<char*>(raptor_uri_to_string(term->value.uri));
-		std::string uriStr(uri);
-		raptor_free_memory(uri);
+bool Model::isResourceOfType(const std::string& resource, aff4::Lexicon type) const {
+	auto obj = model.find(resource);
+	if (obj == model.end()) {
+		return false;
+	}
+	auto types = obj->second.find(aff4::Lexicon::AFF4_TYPE);
+	if (types == obj->second.end()) {
+		return false;
+	}
+	for (const RDFValue& v : types->second) {
+		if (v.getType() == type) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::unique_ptr<aff4::rdf::RDFValue> Model::createResourceValue(aff4::Lexicon property, const char* uri,
+		size_t length) noexcept {
+	try {
 		// see if the URI maps to an AFF4 property.
-		aff4::Lexicon p = aff4::lexicon::getLexicon(uriStr);
+		aff4::Lexicon p = aff4::lexicon::getLexicon(uri, length);
 		if (p != aff4::Lexicon::UNKNOWN) {
 			return std::unique_ptr<RDFValue>(new RDFValue(p));
 		} else {
-			return std::unique_ptr<RDFValue>(new RDFValue(XSDType::Resource, property, uriStr));
+			return std::unique_ptr<RDFValue>(new RDFValue(XSDType::Resource, property, std::string(uri, length)));
 		}
+	} catch (...) {
+		return nullptr;
 	}
-	if (term->type == RAPTOR_TERM_TYPE_LITERAL) {
-		// Does it have a special data type?
-		if (term->value.literal.datatype) {
-			char* uri = reinterpret_cast<char*>(raptor_uri_to_string(term->value.literal.datatype));
-			std::string uriStr(uri);
-			XSDType type = getType(uriStr);
-			raptor_free_memory(uri);
-			if (type == XSDType::UNKNOWN) {
-				return nullptr;
-			}
-			// Raptor gives us everything as strings...
-			std::string value_string(reinterpret_cast<char*>(term->value.literal.string),
-					term->value.literal.string_len);
+}
+
+std::unique_ptr<aff4::rdf::RDFValue> Model::createLiteralValue(aff4::Lexicon property, const std::string& datatype,
+		const std::string& value_string) noexcept {
+	XSDType type = getType(datatype);
+	if (type == XSDType::UNKNOWN) {
+		return nullptr;
+	}
+	try {
+		switch (type) {
+		case String:
+			return std::unique_ptr<RDFValue>(new RDFValue(value_string));
+		case Int:
 			try {
-				switch (type) {
-				case String:
-					return std::unique_ptr<RDFValue>(new RDFValue(value_string));
-				case Int:
-					try {
-						return std::unique_ptr<RDFValue>(new RDFValue((int32_t)std::stoi(value_string)));
-					} catch (...){
-						// expected overflow.
-					}
-					return std::unique_ptr<RDFValue>(new RDFValue((int64_t)std::stoll(value_string)));
-				case Long:
-					// Use std::stoll() for conversion, as this should be 64bit Long on all platforms.
-					return std::unique_ptr<RDFValue>(new RDFValue((int64_t)std::stoll(value_string)));
-				case Float:
-					return std::unique_ptr<RDFValue>(new RDFValue(std::stof(value_string)));
-				case Literal:
-					return std::unique_ptr<RDFValue>(new RDFValue(getAFF4Type(uriStr), value_string));
-				case Resource:
-					return std::unique_ptr<RDFValue>(new RDFValue(XSDType::Resource, property, value_string));
-				case Boolean:
-					return std::unique_ptr<RDFValue>(new RDFValue(!value_string.compare("true")));
-				case XSDDateTime:
-					return std::unique_ptr<RDFValue>(new RDFValue(getTime(value_string)));
-					break;
-				case UNKNOWN:
-					break;
-				}
-			} catch (...) {
+				return std::unique_ptr<RDFValue>(new RDFValue((int32_t)std::stoi(value_string)));
+			} catch (...){
+				// expected overflow.
+			}
+			return std::unique_ptr<RDFValue>(new RDFValue((int64_t)std::stoll(value_string)));
+		case Long:
+			// Use std::stoll() for conversion, as this should be 64bit Long on all platforms.
+			return std::unique_ptr<RDFValue>(new RDFValue((int64_t)std::stoll(value_string)));
+		case Float:
+			return std::unique_ptr<RDFValue>(new RDFValue(std::stof(value_string)));
+		case Literal:
+			return std::unique_ptr<RDFValue>(new RDFValue(getAFF4Type(datatype), value_string));
+		case Resource:
+			return std::unique_ptr<RDFValue>(new RDFValue(XSDType::Resource, property, value_string));
+		case Boolean:
+			return std::unique_ptr<RDFValue>(new RDFValue(!value_string.compare("true")));
+		case XSDDateTime:
+			return std::unique_ptr<RDFValue>(new RDFValue(getTime(value_string)));
+			break;
+		case UNKNOWN:
+			break;
+		}
+	} catch (...) {
 #if DEBUG
-				fprintf( aff4::getDebugOutput(), "%s[%d] : RDFValue construction failed? %d : %s\n", __FILE__, __LINE__, type,
-						value_string.c_str());
+		fprintf( aff4::getDebugOutput(), "%s[%d] : RDFValue construction failed? %d : %s\n", __FILE__, __LINE__, type,
+				value_string.c_str());
 #endif
-			}
-			return nullptr;
+	}
+	return nullptr;
+}
 
-		} else {
-			// Basic String type - nothing special needed.
+std::unique_ptr<aff4::rdf::RDFValue> Model::getValueFromRaptorTerm(aff4::Lexicon property, raptor_term* term) noexcept {
+	if (term->type == RAPTOR_TERM_TYPE_URI) {
+		size_t length = 0;
+		const char* uri = reinterpret_cast<const char*>(raptor_uri_as_counted_string(term->value.uri, &length));
+		return createResourceValue(property, uri, length);
+	}
+	if (term->type == RAPTOR_TERM_TYPE_LITERAL) {
+		try {
+			// Raptor gives us everything as strings...
 			std::string value_string(reinterpret_cast<char*>(term->value.literal.string),
 					term->value.literal.string_len);
-
-			return std::unique_ptr<RDFValue>(new RDFValue(value_string));
+			// Does it have a special data type?
+			if (term->value.literal.datatype) {
+				size_t length = 0;
+				const char* uri = reinterpret_cast<const char*>(raptor_uri_as_counted_string(
+						term->value.literal.datatype, &length));
+				return createLiteralValue(property, std::string(uri, length), value_string);
+			} else {
+				// Basic String type - nothing special needed.
+				return std::unique_ptr<RDFValue>(new RDFValue(value_string));
+			}
+		} catch (...) {
+			return nullptr;
 		}
 	}
 	return nullptr;
 }
 
 void Model::statementHandler(raptor_statement* statement) {
-
 	if (statement->subject->type == RAPTOR_TERM_TYPE_URI && statement->predicate->type == RAPTOR_TERM_TYPE_URI) {
-		char* subject = reinterpret_cast<char*>(raptor_uri_to_string(statement->subject->value.uri));
-		char* predicate = reinterpret_cast<char*>(raptor_uri_to_string(statement->predicate->value.uri));
-		std::string subjectURN(subject);
-		std::string propertryURN(predicate);
-		aff4::Lexicon property = aff4::lexicon::getLexicon(propertryURN);
+		size_t length = 0;
+		const char* predicate = reinterpret_cast<const char*>(raptor_uri_as_counted_string(
+				statement->predicate->value.uri, &length));
+		aff4::Lexicon property = aff4::lexicon::getLexicon(predicate, length);
 		if (property != aff4::Lexicon::UNKNOWN) {
 			// Get the value.
 			std::unique_ptr<RDFValue> v = getValueFromRaptorTerm(property, statement->object);
 			if (v != nullptr) {
+				const char* subject = reinterpret_cast<const char*>(raptor_uri_as_counted_string(
+						statement->subject->value.uri, &length));
+				std::string subjectURN(subject, length);
 #if DEBUG
 				raptor_statement_print_as_ntriples(statement, aff4::getDebugOutput());
 				fprintf(aff4::getDebugOutput(), "\n%s[%d] :%s : %s : %s\n", __FILE__, __LINE__, subjectURN.c_str(),
-						propertryURN.c_str(), v->toString().c_str());
+						predicate, v->toString().c_str());
 #endif
-				// Add into the map.
-				std::map<aff4::Lexicon, std::vector<RDFValue>> properties = getObjectInformation(subjectURN);
-				std::vector<RDFValue> values;
-				auto it = properties.find(property);
-				if (it != properties.end()) {
-					values = it->second;
-				}
-				values.push_back(*v);
-				properties[property] = values;
-				model[subjectURN] = properties;
+				addStatement(subjectURN, property, *v);
 			}
 		}
-		raptor_free_memory(subject);
-		raptor_free_memory(predicate);
 	}
 }
 
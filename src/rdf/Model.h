@@ -30,6 +30,14 @@
 
 #include "aff4config.h"
 #include "aff4.h"
+#include "StringInterner.h"
+#include "Arena.h"
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <string>
+#include <memory>
 
 #ifdef _WIN32
 #include <raptor2.h>
@@ -62,17 +70,79 @@ public:
 
 	/**
 	 * Get a vector of all resources that have rdf:type
+	 * <p>
+	 * The returned vector is a view into the model's type index, sorted by resource URI, and remains valid for the
+	 * lifetime of this model.
 	 * @param type The object type to enquire
 	 * @return A vector of all resources that have the given rdf:type.
 	 */
-	LIBAFF4_API_LOCAL std::vector<std::string> getResourcesOfType(aff4::Lexicon type);
+	LIBAFF4_API_LOCAL const std::vector<std::string>& getResourcesOfType(aff4::Lexicon type) const;
+
+	/**
+	 * Get a vector of all resources that have the given property with the given resource as the object.
+	 * (eg, all resources with aff4:stored of the container URI).
+	 * <p>
+	 * Only resource valued properties are indexed. The returned vector is a view into the model's property index,
+	 * sorted by resource URI, and remains valid for the lifetime of this model.
+	 * @param property The property (predicate) to enquire
+	 * @param object The resource URI held by the property
+	 * @return A vector of all resources that have the given property / object pair.
+	 */
+	LIBAFF4_API_LOCAL const std::vector<std::string>& getResourcesWithProperty(aff4::Lexicon property,
+			const std::string& object) const;
+
+	/**
+	 * Determine if the given resource has the given rdf:type.
+	 * @param resource The resource URI
+	 * @param type The object type to enquire
+	 * @return TRUE if the resource has the given rdf:type.
+	 */
+	LIBAFF4_API_LOCAL bool isResourceOfType(const std::string& resource, aff4::Lexicon type) const;
+
+	/**
+	 * Get the number of unique strings held by values in this model.
+	 * @return The number of unique strings.
+	 */
+	LIBAFF4_API_LOCAL size_t getInternedStringCount() const noexcept;
 
 	/**
 	 * Get the object properties for the given object
 	 * @param resource The resource URI
 	 * @return A map of elements. (empty map for unknown object).
 	 */
-	LIBAFF4_API_LOCAL std::map<aff4::Lexicon, std::vector<RDFValue>> getObjectInformation(const std::string& resource);
+	LIBAFF4_API_LOCAL std::map<aff4::Lexicon, std::vector<RDFValue>> getObjectInformation(const std::string& resource) const;
+
+	/**
+	 * Get a shared, read only view of the object properties for the given object.
+	 * <p>
+	 * The properties are not copied; the returned pointer shares ownership of the model, so remains valid after
+	 * the container drops the model. The model must not be parsed into after views have been taken.
+	 * @param model The model
+	 * @param resource The resource URI
+	 * @return The object properties, or nullptr for an unknown object.
+	 */
+	LIBAFF4_API_LOCAL static std::shared_ptr<const std::map<aff4::Lexicon, std::vector<RDFValue>>> getSharedObjectInformation(
+			const std::shared_ptr<Model>& model, const std::string& resource) noexcept;
+
+	/**
+	 * Create the RDF value for a URI object.
+	 * @param property The RDF property.
+	 * @param uri The URI characters (need not be NULL terminated).
+	 * @param length The length of the URI.
+	 * @return The RDF Value (Lexicon value for known URIs, otherwise a Resource) or nullptr on error.
+	 */
+	LIBAFF4_API_LOCAL static std::unique_ptr<aff4::rdf::RDFValue> createResourceValue(aff4::Lexicon property,
+			const char* uri, size_t length) noexcept;
+
+	/**
+	 * Create the RDF value for a literal object with a datatype.
+	 * @param property The RDF property.
+	 * @param datatype The datatype URI.
+	 * @param value The lexical value.
+	 * @return The RDF Value or nullptr if unable to convert.
+	 */
+	LIBAFF4_API_LOCAL static std::unique_ptr<aff4::rdf::RDFValue> createLiteralValue(aff4::Lexicon property,
+			const std::string& datatype, const std::string& value) noexcept;
 
 	/**
 	 * Raptor 2 statement handler.
@@ -84,7 +154,7 @@ public:
 
 private:
 	/**
-	 * Raptor world
+	 * Raptor world (created on first use, as the native parser handles most documents).
 	 */
 	raptor_world* world;
 	/**
@@ -92,10 +162,85 @@ private:
 	 */
 	raptor_parser* parser;
 
+	/**
+	 * Object model, subject to properties.
+	 */
+	typedef std::pair<const std::string, std::map<aff4::Lexicon, std::vector<RDFValue>>> ObjectEntry;
+	typedef std::map<std::string, std::map<aff4::Lexicon, std::vector<RDFValue>>, std::less<std::string>,
+			aff4::util::ArenaAllocator<ObjectEntry>> ObjectMap;
+	/**
+	 * Object resource to subject resources.
+	 */
+	typedef std::pair<const std::string, std::vector<std::string>> ObjectIndexEntry;
+	typedef std::unordered_map<std::string, std::vector<std::string>, std::hash<std::string>, std::equal_to<std::string>,
+			aff4::util::ArenaAllocator<ObjectIndexEntry>> ObjectIndex;
+
+	/**
+	 * Arena for the model and index structures. (Declared first, so it is released last).
+	 */
+	std::shared_ptr<aff4::util::Arena> arena;
+
 	/**
 	 * Object model.
 	 */
-	std::map<std::string, std::map<aff4::Lexicon, std::vector<RDFValue>>> model;
+	ObjectMap model;
+
+	/**
+	 * Secondary index of rdf:type to resources.
+	 */
+	std::map<aff4::Lexicon, std::vector<std::string>, std::less<aff4::Lexicon>,
+			aff4::util::ArenaAllocator<std::pair<const aff4::Lexicon, std::vector<std::string>>>> typeIndex;
+
+	/**
+	 * Secondary index of property, object resource to subject resources.
+	 */
+	std::map<aff4::Lexicon, ObjectIndex, std::less<aff4::Lexicon>,
+			aff4::util::ArenaAllocator<std::pair<const aff4::Lexicon, ObjectIndex>>> propertyIndex;
+
+	/**
+	 * Shared storage for the resource URNs and literals held by values in the model.
+	 */
+	StringInterner interner;
+
+	/**
+	 * The subject of the last added statement, and its properties.
+	 */
+	const std::string* currentSubject;
+	std::map<aff4::Lexicon, std::vector<RDFValue>>* currentProperties;
+
+	/**
+	 * Parse the buffer with the native turtle parser.
+	 * @param buffer The buffer
+	 * @param size The size of the buffer.
+	 * @return TRUE if the whole document was parsed.
+	 */
+	bool parseNative(const char* buffer, uint64_t size) noexcept;
+
+	/**
+	 * Parse the buffer with raptor.
+	 * @param buffer The buffer
+	 * @param size The size of the buffer.
+	 * @return Non-zero on error.
+	 */
+	int parseRaptor(unsigned char* buffer, uint64_t size) noexcept;
+
+	/**
+	 * Add the statement to the model and indexes.
+	 * @param subject The subject URI.
+	 * @param property The property.
+	 * @param value The value.
+	 */
+	void addStatement(const std::string& subject, aff4::Lexicon property, const RDFValue& value);
+
+	/**
+	 * Remove all statements from the model.
+	 */
+	void clear() noexcept;
+
+	/**
+	 * Sort and remove duplicates from the secondary indexes. Called once parsing has completed.
+	 */
+	void finaliseIndexes() noexcept;
 
 	/**
 	 * Convert the raptor term into a RDFValue.
@@ -0,0 +1,62 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StringInterner.h"
+
+namespace aff4 {
+namespace rdf {
+
+StringInterner::StringInterner(const std::shared_ptr<aff4::util::Arena>& arena) :
+		strings(0, Hash(), Equal(), aff4::util::ArenaAllocator<SharedString*>(arena)) {
+}
+
+StringInterner::~StringInterner() {
+	clear();
+}
+
+void StringInterner::intern(RDFValue& value) {
+	if (!value.hasLiteral() || (value.value_literal == nullptr)) {
+		return;
+	}
+	auto it = strings.find(value.value_literal);
+	if (it == strings.end()) {
+		// First instance, so this becomes the shared copy.
+		value.value_literal->references++;
+		strings.insert(value.value_literal);
+	} else if (*it != value.value_literal) {
+		SharedString* shared = *it;
+		shared->references++;
+		value.releaseLiteral();
+		value.value_literal = shared;
+	}
+}
+
+size_t StringInterner::size() const noexcept {
+	return strings.size();
+}
+
+void StringInterner::clear() noexcept {
+	for (SharedString* s : strings) {
+		if (--s->references == 0) {
+			delete s;
+		}
+	}
+	strings.clear();
+}
+
+} /* namespace rdf */
+} /* namespace aff4 */
@@ -0,0 +1,123 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file StringInterner.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Shared string storage for RDF values.
+ */
+
+#ifndef SRC_RDF_STRINGINTERNER_H_
+#define SRC_RDF_STRINGINTERNER_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <atomic>
+#include <string>
+#include <unordered_set>
+
+#include "Arena.h"
+
+namespace aff4 {
+namespace rdf {
+
+/**
+ * @brief Reference counted immutable string, shared between RDFValue instances.
+ */
+struct SharedString {
+	/**
+	 * Create a new shared string, with a single reference.
+	 * @param value The string value.
+	 */
+	explicit SharedString(const std::string& value) :
+			references(1), value(value) {
+	}
+	/**
+	 * The number of RDFValue (and interner) references.
+	 */
+	std::atomic<uint32_t> references;
+	/**
+	 * The string value.
+	 */
+	const std::string value;
+};
+
+/**
+ * @brief De-duplicates the strings held by RDF values.
+ * <p>
+ * Each model owns an interner, so that repeated resource URNs and literals in the model share a single copy.
+ */
+class StringInterner {
+public:
+	/**
+	 * Create a new interner.
+	 * @param arena The arena to hold the interner's index. (The strings themselves are reference counted, as values
+	 * may outlive the interner).
+	 */
+	LIBAFF4_API_LOCAL explicit StringInterner(
+			const std::shared_ptr<aff4::util::Arena>& arena = std::make_shared<aff4::util::Arena>());
+	LIBAFF4_API_LOCAL ~StringInterner();
+
+	/**
+	 * Replace the string held by the value with the shared instance of an equal string.
+	 * @param value The value to intern. Values without a string are left untouched.
+	 */
+	LIBAFF4_API_LOCAL void intern(RDFValue& value);
+
+	/**
+	 * Get the number of unique strings held.
+	 * @return The number of unique strings.
+	 */
+	LIBAFF4_API_LOCAL size_t size() const noexcept;
+
+	/**
+	 * Release all held strings. (Values already interned keep their string).
+	 */
+	LIBAFF4_API_LOCAL void clear() noexcept;
+
+private:
+	/**
+	 * Hash the shared string value.
+	 */
+	struct Hash {
+		size_t operator()(const SharedString* s) const noexcept {
+			return std::hash<std::string>()(s->value);
+		}
+	};
+	/**
+	 * Compare the shared string values.
+	 */
+	struct Equal {
+		bool operator()(const SharedString* a, const SharedString* b) const noexcept {
+			return a->value == b->value;
+		}
+	};
+	/**
+	 * The unique strings. (Each holds a reference for the interner).
+	 */
+	std::unordered_set<SharedString*, Hash, Equal, aff4::util::ArenaAllocator<SharedString*>> strings;
+};
+
+} /* namespace rdf */
+} /* namespace aff4 */
+
+#endif /* SRC_RDF_STRINGINTERNER_H_ */
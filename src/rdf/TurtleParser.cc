@@ -0,0 +1,533 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TurtleParser.h"
+#include "Model.h"
+
+#include <cstring>
+
+namespace aff4 {
+namespace rdf {
+
+/**
+ * Is the character a letter?
+ */
+static inline bool isAlpha(char c) noexcept {
+	return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+}
+
+/**
+ * Is the character a digit?
+ */
+static inline bool isDigit(char c) noexcept {
+	return (c >= '0') && (c <= '9');
+}
+
+/**
+ * Is the character a hex digit?
+ */
+static inline int hexValue(char c) noexcept {
+	if (isDigit(c)) {
+		return c - '0';
+	}
+	if ((c >= 'a') && (c <= 'f')) {
+		return c - 'a' + 10;
+	}
+	if ((c >= 'A') && (c <= 'F')) {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+/**
+ * Is the character allowed within a (ASCII) prefixed name? ('.' is handled separately).
+ */
+static inline bool isNameChar(char c) noexcept {
+	return isAlpha(c) || isDigit(c) || (c == '_') || (c == '-');
+}
+
+/**
+ * Append the unicode code point to the string as UTF-8.
+ */
+static bool appendUTF8(std::string& value, uint32_t codePoint) {
+	if (codePoint < 0x80) {
+		value.push_back((char) codePoint);
+	} else if (codePoint < 0x800) {
+		value.push_back((char) (0xC0 | (codePoint >> 6)));
+		value.push_back((char) (0x80 | (codePoint & 0x3F)));
+	} else if (codePoint < 0x10000) {
+		value.push_back((char) (0xE0 | (codePoint >> 12)));
+		value.push_back((char) (0x80 | ((codePoint >> 6) & 0x3F)));
+		value.push_back((char) (0x80 | (codePoint & 0x3F)));
+	} else if (codePoint < 0x110000) {
+		value.push_back((char) (0xF0 | (codePoint >> 18)));
+		value.push_back((char) (0x80 | ((codePoint >> 12) & 0x3F)));
+		value.push_back((char) (0x80 | ((codePoint >> 6) & 0x3F)));
+		value.push_back((char) (0x80 | (codePoint & 0x3F)));
+	} else {
+		return false;
+	}
+	return true;
+}
+
+TurtleParser::TurtleParser(const char* buffer, uint64_t size, StatementHandler handler) :
+		cursor(buffer), end(buffer + size), handler(handler) {
+}
+
+TurtleParser::~TurtleParser() {
+	// NOP
+}
+
+bool TurtleParser::parse() noexcept {
+	try {
+		while (true) {
+			skipWhitespace();
+			if (cursor >= end) {
+				return true;
+			}
+			if (*cursor == '@') {
+				cursor++;
+				if (!consumeKeyword("prefix", false) || !parseDirective(false)) {
+					return false;
+				}
+			} else if (consumeKeyword("PREFIX", true)) {
+				if (!parseDirective(true)) {
+					return false;
+				}
+			} else if (!parseTriples()) {
+				return false;
+			}
+		}
+	} catch (...) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Turtle parsing failed\n", __FILE__, __LINE__);
+#endif
+	}
+	return false;
+}
+
+void TurtleParser::skipWhitespace() noexcept {
+	while (cursor < end) {
+		char c = *cursor;
+		if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n')) {
+			cursor++;
+		} else if (c == '#') {
+			while ((cursor < end) && (*cursor != '\n') && (*cursor != '\r')) {
+				cursor++;
+			}
+		} else {
+			return;
+		}
+	}
+}
+
+bool TurtleParser::consume(char c) noexcept {
+	if ((cursor < end) && (*cursor == c)) {
+		cursor++;
+		return true;
+	}
+	return false;
+}
+
+bool TurtleParser::atDelimiter(const char* position) const noexcept {
+	return (position >= end) || (!isNameChar(*position) && (*position != ':') && (*position != '%')
+			&& ((*position & 0x80) == 0));
+}
+
+bool TurtleParser::consumeKeyword(const char* keyword, bool caseInsensitive) noexcept {
+	size_t length = std::strlen(keyword);
+	if ((size_t) (end - cursor) < length) {
+		return false;
+	}
+	for (size_t i = 0; i < length; i++) {
+		char c = cursor[i];
+		if (caseInsensitive && (c >= 'a') && (c <= 'z')) {
+			c = c - 'a' + 'A';
+		}
+		if (c != keyword[i]) {
+			return false;
+		}
+	}
+	if (!atDelimiter(cursor + length)) {
+		return false;
+	}
+	cursor += length;
+	return true;
+}
+
+bool TurtleParser::parseDirective(bool sparql) {
+	skipWhitespace();
+	// Prefix name, (may be empty).
+	const char* start = cursor;
+	while ((cursor < end) && (isNameChar(*cursor) || (*cursor == '.'))) {
+		cursor++;
+	}
+	if (((cursor != start) && (!isAlpha(*start) || (cursor[-1] == '.'))) || !consume(':')) {
+		return false;
+	}
+	std::string prefix(start, cursor - start - 1);
+	skipWhitespace();
+	IRI iri;
+	if (!parseIRIRef(iri)) {
+		return false;
+	}
+	prefixes[prefix] = std::string(iri.value, iri.length);
+	if (!sparql) {
+		skipWhitespace();
+		return consume('.');
+	}
+	return true;
+}
+
+bool TurtleParser::parseTriples() {
+	IRI iri;
+	if (!parseIRI(iri)) {
+		return false;
+	}
+	subject.assign(iri.value, iri.length);
+	while (true) {
+		skipWhitespace();
+		if (cursor >= end) {
+			return false;
+		}
+		// Predicate
+		aff4::Lexicon property;
+		if ((*cursor == 'a') && atDelimiter(cursor + 1)) {
+			cursor++;
+			property = aff4::Lexicon::AFF4_TYPE;
+		} else {
+			if (!parseIRI(iri)) {
+				return false;
+			}
+			property = aff4::lexicon::getLexicon(iri.value, iri.length);
+		}
+		// Object list
+		do {
+			skipWhitespace();
+			if (!parseObject(property)) {
+				return false;
+			}
+			skipWhitespace();
+		} while (consume(','));
+		// Predicate list, or end of statement.
+		if (consume(';')) {
+			skipWhitespace();
+			while (consume(';')) {
+				skipWhitespace();
+			}
+			if (consume('.')) {
+				return true;
+			}
+			continue;
+		}
+		return consume('.');
+	}
+}
+
+bool TurtleParser::parseObject(aff4::Lexicon property) {
+	if (cursor >= end) {
+		return false;
+	}
+	char c = *cursor;
+	if ((c == '"') || (c == '\'')) {
+		if (!parseString()) {
+			return false;
+		}
+		if (consume('@')) {
+			// Language tag, treat as a plain string.
+			const char* start = cursor;
+			while ((cursor < end) && (isAlpha(*cursor) || (isDigit(*cursor) && (cursor != start))
+					|| ((*cursor == '-') && (cursor != start)))) {
+				cursor++;
+			}
+			if ((cursor == start) || !atDelimiter(cursor)) {
+				return false;
+			}
+		} else if (((end - cursor) >= 2) && (cursor[0] == '^') && (cursor[1] == '^')) {
+			cursor += 2;
+			IRI iri;
+			if (!parseIRI(iri)) {
+				return false;
+			}
+			datatype.assign(iri.value, iri.length);
+			emitLiteral(property);
+			return true;
+		}
+		if (property != aff4::Lexicon::UNKNOWN) {
+			emit(property, RDFValue(literal));
+		}
+		return true;
+	}
+	if (isDigit(c) || (c == '+') || (c == '-') || (c == '.')) {
+		return parseNumber(property);
+	}
+	bool isTrue = consumeKeyword("true", false);
+	if (isTrue || consumeKeyword("false", false)) {
+		literal = isTrue ? "true" : "false";
+		datatype = AFF4_XSD_PREFIX "boolean";
+		emitLiteral(property);
+		return true;
+	}
+	IRI iri;
+	if (!parseIRI(iri)) {
+		return false;
+	}
+	if (property != aff4::Lexicon::UNKNOWN) {
+		std::unique_ptr<RDFValue> value = Model::createResourceValue(property, iri.value, iri.length);
+		if (value != nullptr) {
+			emit(property, *value);
+		}
+	}
+	return true;
+}
+
+bool TurtleParser::parseIRI(IRI& iri) {
+	if (cursor >= end) {
+		return false;
+	}
+	if (*cursor == '<') {
+		return parseIRIRef(iri);
+	}
+	if ((*cursor == ':') || isAlpha(*cursor)) {
+		return parsePrefixedName(iri);
+	}
+	// Blank nodes, collections, etc.
+	return false;
+}
+
+bool TurtleParser::parseIRIRef(IRI& iri) noexcept {
+	if (!consume('<')) {
+		return false;
+	}
+	const char* start = cursor;
+	while (cursor < end) {
+		char c = *cursor;
+		if (c == '>') {
+			break;
+		}
+		if (((uint8_t) c <= 0x20) || (c == '<') || (c == '"') || (c == '{') || (c == '}') || (c == '|')
+				|| (c == '^') || (c == '`') || (c == '\\')) {
+			return false;
+		}
+		cursor++;
+	}
+	if (cursor >= end) {
+		return false;
+	}
+	// Only absolute IRIs, (scheme ':' ...), relative IRIs need resolving against the base.
+	const char* scheme = start;
+	if ((scheme == cursor) || !isAlpha(*scheme)) {
+		return false;
+	}
+	while ((scheme < cursor)
+			&& (isAlpha(*scheme) || isDigit(*scheme) || (*scheme == '+') || (*scheme == '-') || (*scheme == '.'))) {
+		scheme++;
+	}
+	if ((scheme == cursor) || (*scheme != ':')) {
+		return false;
+	}
+	iri.value = start;
+	iri.length = cursor - start;
+	cursor++;
+	return true;
+}
+
+bool TurtleParser::parsePrefixedName(IRI& iri) {
+	const char* start = cursor;
+	while ((cursor < end) && (isNameChar(*cursor) || ((*cursor == '.') && (cursor + 1 < end) && (isNameChar(cursor[1]))))) {
+		cursor++;
+	}
+	if ((cursor >= end) || (*cursor != ':')) {
+		return false;
+	}
+	auto it = prefixes.find(std::string(start, cursor - start));
+	if (it == prefixes.end()) {
+		return false;
+	}
+	cursor++;
+	name = it->second;
+	const char* local = cursor;
+	while (cursor < end) {
+		char c = *cursor;
+		if (isNameChar(c) || (c == ':')) {
+			cursor++;
+		} else if ((c == '.') && (cursor + 1 < end) && (isNameChar(cursor[1]) || (cursor[1] == ':'))) {
+			cursor++;
+		} else if (c == '%') {
+			if ((end - cursor < 3) || (hexValue(cursor[1]) < 0) || (hexValue(cursor[2]) < 0)) {
+				return false;
+			}
+			cursor += 3;
+		} else if ((c == '\\') || (c & 0x80)) {
+			// Escaped or non-ASCII local names.
+			return false;
+		} else {
+			break;
+		}
+	}
+	name.append(local, cursor - local);
+	iri.value = name.data();
+	iri.length = name.length();
+	return true;
+}
+
+bool TurtleParser::parseString() {
+	const char quote = *cursor;
+	bool isLong = ((end - cursor) >= 3) && (cursor[1] == quote) && (cursor[2] == quote);
+	cursor += isLong ? 3 : 1;
+	literal.clear();
+	const char* run = cursor;
+	while (cursor < end) {
+		char c = *cursor;
+		if (c == quote) {
+			if (!isLong) {
+				literal.append(run, cursor - run);
+				cursor++;
+				return true;
+			}
+			if (((end - cursor) >= 3) && (cursor[1] == quote) && (cursor[2] == quote)) {
+				literal.append(run, cursor - run);
+				cursor += 3;
+				// A long string may end with up to 2 additional quotes.
+				while ((cursor < end) && (*cursor == quote)) {
+					literal.push_back(quote);
+					cursor++;
+				}
+				return true;
+			}
+			cursor++;
+		} else if (((c == '\n') || (c == '\r')) && !isLong) {
+			return false;
+		} else if (c == '\\') {
+			literal.append(run, cursor - run);
+			if (end - cursor < 2) {
+				return false;
+			}
+			char e = cursor[1];
+			cursor += 2;
+			switch (e) {
+			case 't':
+				literal.push_back('\t');
+				break;
+			case 'b':
+				literal.push_back('\b');
+				break;
+			case 'n':
+				literal.push_back('\n');
+				break;
+			case 'r':
+				literal.push_back('\r');
+				break;
+			case 'f':
+				literal.push_back('\f');
+				break;
+			case '"':
+			case '\'':
+			case '\\':
+				literal.push_back(e);
+				break;
+			case 'u':
+			case 'U': {
+				int digits = (e == 'u') ? 4 : 8;
+				if (end - cursor < digits) {
+					return false;
+				}
+				uint32_t codePoint = 0;
+				for (int i = 0; i < digits; i++) {
+					int v = hexValue(cursor[i]);
+					if (v < 0) {
+						return false;
+					}
+					codePoint = (codePoint << 4) | (uint32_t) v;
+				}
+				cursor += digits;
+				if (!appendUTF8(literal, codePoint)) {
+					return false;
+				}
+				break;
+			}
+			default:
+				return false;
+			}
+			run = cursor;
+		} else {
+			cursor++;
+		}
+	}
+	return false;
+}
+
+bool TurtleParser::parseNumber(aff4::Lexicon property) {
+	const char* start = cursor;
+	if ((*cursor == '+') || (*cursor == '-')) {
+		cursor++;
+	}
+	bool digits = false;
+	while ((cursor < end) && isDigit(*cursor)) {
+		cursor++;
+		digits = true;
+	}
+	const char* type = AFF4_XSD_PREFIX "integer";
+	if ((cursor + 1 < end) && (*cursor == '.') && isDigit(cursor[1])) {
+		cursor++;
+		while ((cursor < end) && isDigit(*cursor)) {
+			cursor++;
+		}
+		digits = true;
+		type = AFF4_XSD_PREFIX "decimal";
+	}
+	if (!digits) {
+		return false;
+	}
+	if ((cursor < end) && ((*cursor == 'e') || (*cursor == 'E'))) {
+		cursor++;
+		if ((cursor < end) && ((*cursor == '+') || (*cursor == '-'))) {
+			cursor++;
+		}
+		if ((cursor >= end) || !isDigit(*cursor)) {
+			return false;
+		}
+		while ((cursor < end) && isDigit(*cursor)) {
+			cursor++;
+		}
+		type = AFF4_XSD_PREFIX "double";
+	}
+	if (!atDelimiter(cursor)) {
+		return false;
+	}
+	literal.assign(start, cursor - start);
+	datatype = type;
+	emitLiteral(property);
+	return true;
+}
+
+void TurtleParser::emitLiteral(aff4::Lexicon property) {
+	if (property == aff4::Lexicon::UNKNOWN) {
+		return;
+	}
+	std::unique_ptr<RDFValue> value = Model::createLiteralValue(property, datatype, literal);
+	if (value != nullptr) {
+		emit(property, *value);
+	}
+}
+
+void TurtleParser::emit(aff4::Lexicon property, const RDFValue& value) {
+	handler(subject, property, value);
+}
+
+} /* namespace rdf */
+} /* namespace aff4 */
@@ -0,0 +1,138 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file TurtleParser.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Native parser for the subset of Turtle written by AFF4 implementations.
+ */
+
+#ifndef SRC_RDF_TURTLEPARSER_H_
+#define SRC_RDF_TURTLEPARSER_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <functional>
+#include <map>
+#include <string>
+
+namespace aff4 {
+namespace rdf {
+
+/**
+ * @brief Single pass parser for the subset of Turtle produced by AFF4 writers.
+ * <p>
+ * Supported: @prefix/PREFIX directives, absolute IRIs, prefixed names, the 'a' keyword, predicate (;) and object (,)
+ * lists, short and long string literals with escapes, language tags, datatyped literals, and numeric and boolean
+ * literals.
+ * <p>
+ * Anything else (blank nodes, collections, @base and relative IRIs, escaped local names, non-ASCII names) causes
+ * parse() to fail, so the caller can fall back to a full Turtle parser.
+ * <p>
+ * The parser works directly over the supplied buffer. IRIs are resolved to aff4::Lexicon values as they are read, and
+ * statements with predicates that are not part of the AFF4 lexicon are skipped without constructing their values.
+ */
+class TurtleParser {
+public:
+	/**
+	 * Statement callback.
+	 * <p>
+	 * The subject and value are only valid for the duration of the call.
+	 */
+	typedef std::function<void(const std::string& subject, aff4::Lexicon property, const RDFValue& value)> StatementHandler;
+
+	/**
+	 * Create a new parser over the given buffer.
+	 * @param buffer The buffer holding the Turtle document.
+	 * @param size The size of the buffer.
+	 * @param handler The handler to call for each statement with a known AFF4 predicate.
+	 */
+	LIBAFF4_API_LOCAL TurtleParser(const char* buffer, uint64_t size, StatementHandler handler);
+	virtual ~TurtleParser();
+
+	/**
+	 * Parse the document.
+	 * <p>
+	 * Statements are delivered to the handler as they are parsed, so on failure the handler may already have been
+	 * called for part of the document.
+	 * @return TRUE if the whole document was parsed, FALSE if it contains unsupported or invalid syntax.
+	 */
+	LIBAFF4_API_LOCAL bool parse() noexcept;
+
+private:
+	/**
+	 * The current position.
+	 */
+	const char* cursor;
+	/**
+	 * The end of the buffer.
+	 */
+	const char* end;
+	/**
+	 * The statement handler.
+	 */
+	StatementHandler handler;
+	/**
+	 * Declared prefixes.
+	 */
+	std::map<std::string, std::string> prefixes;
+	/**
+	 * The current subject.
+	 */
+	std::string subject;
+	/**
+	 * Scratch buffers for expanded prefixed names, literal values and datatypes.
+	 */
+	std::string name;
+	std::string literal;
+	std::string datatype;
+
+	/**
+	 * An IRI, either a range within the buffer or the expanded name buffer.
+	 */
+	struct IRI {
+		const char* value;
+		size_t length;
+	};
+
+	void skipWhitespace() noexcept;
+	bool consume(char c) noexcept;
+	bool consumeKeyword(const char* keyword, bool caseInsensitive) noexcept;
+	bool atDelimiter(const char* position) const noexcept;
+
+	bool parseDirective(bool sparql);
+	bool parseTriples();
+	bool parseObject(aff4::Lexicon property);
+	bool parseIRI(IRI& iri);
+	bool parseIRIRef(IRI& iri) noexcept;
+	bool parsePrefixedName(IRI& iri);
+	bool parseString();
+	bool parseNumber(aff4::Lexicon property);
+
+	void emitLiteral(aff4::Lexicon property);
+	void emit(aff4::Lexicon property, const RDFValue& value);
+};
+
+} /* namespace rdf */
+} /* namespace aff4 */
+
+#endif /* SRC_RDF_TURTLEPARSER_H_ */
@@ -181,5 +181,13 @@ std::vector<aff4::rdf::RDFValue> LightResolver::getProperty(aff4::Lexicon resour
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> LightResolver::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> LightResolver::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 } /* namespace resolver */
 } /* namespace aff4 */
@@ -81,6 +81,10 @@ public:
 
 	LIBAFF4_API std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
 
+	LIBAFF4_API std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+
+	LIBAFF4_API std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
+
 	/*
 	 * From IAFF4Resolver
 	 */
@@ -19,12 +19,23 @@
 
 namespace aff4 {
 
+/**
+ * Empty result for properties that are not set.
+ */
+static const std::vector<aff4::rdf::RDFValue> emptyValues;
+
 AFF4Resource::AFF4Resource(const std::string& resource) noexcept //
 		:resource(resource) {
 }
 
 AFF4Resource::AFF4Resource(const std::string& resource,
 		std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>& properties) noexcept //
+				:resource(resource) {
+	this->properties = std::make_shared<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>(properties);
+}
+
+AFF4Resource::AFF4Resource(const std::string& resource,
+		std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties) noexcept //
 				:resource(resource), properties(properties) {
 }
 
@@ -33,32 +44,54 @@ std::string AFF4Resource::getResourceID() const noexcept {
 }
 
 std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> AFF4Resource::getProperties() noexcept {
-	return properties;
+	return *AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> AFF4Resource::getPropertyMap() noexcept {
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> current = std::atomic_load(&properties);
+	if (current == nullptr) {
+		static const std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> emptyProperties =
+				std::make_shared<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>();
+		return emptyProperties;
+	}
+	return current;
 }
 
 aff4::Lexicon AFF4Resource::getBaseType() noexcept {
-	std::vector<aff4::rdf::RDFValue> properties = getProperty(aff4::Lexicon::AFF4_TYPE);
-	if (!properties.empty()) {
-		for (aff4::rdf::RDFValue v : properties) {
-			if (v.getType() != aff4::Lexicon::UNKNOWN) {
-				return v.getType();
-			}
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> values = getPropertyValues(aff4::Lexicon::AFF4_TYPE);
+	for (const aff4::rdf::RDFValue& v : *values) {
+		if (v.getType() != aff4::Lexicon::UNKNOWN) {
+			return v.getType();
 		}
 	}
 	return aff4::Lexicon::UNKNOWN;
 }
 
 std::vector<aff4::rdf::RDFValue> AFF4Resource::getProperty(aff4::Lexicon resource) noexcept {
-	auto it = properties.find(resource);
-	if (it != properties.end()) {
-		return it->second;
+	return *AFF4Resource::getPropertyValues(resource);
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> AFF4Resource::getPropertyValues(aff4::Lexicon resource) noexcept {
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> current = AFF4Resource::getPropertyMap();
+	auto it = current->find(resource);
+	if (it != current->end()) {
+		return std::shared_ptr<const std::vector<aff4::rdf::RDFValue>>(current, &it->second);
 	}
 	// Empty vector.
-	return std::vector<aff4::rdf::RDFValue>();
+	return std::shared_ptr<const std::vector<aff4::rdf::RDFValue>>(current, &emptyValues);
 }
 
-void AFF4Resource::addProperty(aff4::Lexicon property, std::vector<aff4::rdf::RDFValue>& values) noexcept {
-	properties[property] = values;
+void AFF4Resource::addProperty(aff4::Lexicon property, const std::vector<aff4::rdf::RDFValue>& values) noexcept {
+	// Published maps are never modified, so copy on every write.
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> current = std::atomic_load(&properties);
+	std::shared_ptr<std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> updated;
+	if (current != nullptr) {
+		updated = std::make_shared<std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>(*current);
+	} else {
+		updated = std::make_shared<std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>();
+	}
+	(*updated)[property] = values;
+	std::atomic_store(&properties, std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>(updated));
 }
 
 void AFF4Resource::addProperty(aff4::Lexicon property, aff4::rdf::RDFValue value) noexcept {
@@ -67,4 +100,9 @@ void AFF4Resource::addProperty(aff4::Lexicon property, aff4::rdf::RDFValue value
 	addProperty(property, values);
 }
 
+void AFF4Resource::setProperties(
+		std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties) noexcept {
+	std::atomic_store(&this->properties, properties);
+}
+
 } /* namespace aff4 */
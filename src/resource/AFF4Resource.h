@@ -32,6 +32,8 @@
 
 #include "IAFF4Resource.h"
 
+#include <memory>
+
 namespace aff4 {
 
 /**
@@ -53,6 +55,15 @@ public:
 	 */
 	explicit AFF4Resource(const std::string& resource,
 			std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>& properties) noexcept;
+	/**
+	 * Create a new AFF4 Resource sharing the given read only aff4 properties map.
+	 * <p>
+	 * The map is not modified; properties later added to this resource are added to a copy.
+	 * @param resource The resource identifier
+	 * @param properties The shared properites map.
+	 */
+	explicit AFF4Resource(const std::string& resource,
+			std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties) noexcept;
 
 	virtual ~AFF4Resource() {
 	}
@@ -65,6 +76,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * By default we just compare resource id.
@@ -83,13 +96,18 @@ protected:
 	 * @param property The property
 	 * @param values The collection of values.
 	 */
-	void addProperty(aff4::Lexicon property, std::vector<aff4::rdf::RDFValue>& values) noexcept;
+	void addProperty(aff4::Lexicon property, const std::vector<aff4::rdf::RDFValue>& values) noexcept;
 	/**
 	 * Add the given property
 	 * @param property The property
 	 * @param value The value.
 	 */
 	void addProperty(aff4::Lexicon property, aff4::rdf::RDFValue value) noexcept;
+	/**
+	 * Replace all properties with the given shared, read only properties map.
+	 * @param properties The shared properties map.
+	 */
+	void setProperties(std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties) noexcept;
 
 private:
 	/**
@@ -97,9 +115,10 @@ private:
 	 */
 	const std::string resource;
 	/**
-	 * The properties map.
+	 * The properties map. (may be shared with the RDF model, or nullptr for no properties). Never modified once set;
+	 * addProperty() replaces it with an updated copy.
 	 */
-	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> properties;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties;
 };
 
 } /* namespace aff4 */
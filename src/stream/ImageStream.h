@@ -34,6 +34,9 @@
 #include "aff4.h"
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <set>
 #include <vector>
 #include <map>
 #include <string>
@@ -58,6 +61,24 @@ namespace stream {
  */
 typedef typename std::pair<std::shared_ptr<uint8_t>, uint32_t> cacheBuffer_t;
 
+/**
+ * @brief A single range of a batched (scatter/gather) read.
+ */
+struct ScatterRead {
+	/**
+	 * The buffer to read into.
+	 */
+	void* buffer;
+	/**
+	 * The number of bytes to read.
+	 */
+	uint64_t count;
+	/**
+	 * The offset from the start of the stream.
+	 */
+	uint64_t offset;
+};
+
 }
 }
 
@@ -71,31 +92,11 @@ class AFF4ZipContainer;
 }
 #endif
 
-#ifndef BevvyIndex
+#ifndef SharedImageStream
 namespace aff4 {
 namespace stream {
 namespace structs {
-class BevvyIndex;
-}
-}
-}
-#endif
-
-#ifndef BevvyIndexLoader
-namespace aff4 {
-namespace stream {
-namespace structs {
-class BevvyIndexLoader;
-}
-}
-}
-#endif
-
-#ifndef ChunkLoader
-namespace aff4 {
-namespace stream {
-namespace structs {
-class ChunkLoader;
+class SharedImageStream;
 }
 }
 }
@@ -109,15 +110,17 @@ namespace stream {
  *
  * This implementation provides a lightweight LRU cache for data chunks.
  * To set the cache size for the materialised stream see {@link aff4::stream::setImageStreamCacheSize()}.
+ * <p>
+ * Each instance is a lightweight handle on the stream's shared state (its caches), which is shared by all instances
+ * opened on the same stream of a container. Closing an instance only closes that instance.
  */
 class ImageStream: public AFF4Resource, public IAFF4Stream {
 public:
 	/**
-	 * Create a new image stream for contents backed by a AFF4 Zip container
-	 * @param resource The resource
-	 * @param parent The parent container.
+	 * Create a new image stream reading the given shared stream state.
+	 * @param stream The shared stream state.
 	 */
-	LIBAFF4_API_LOCAL ImageStream(const std::string& resource, aff4::container::AFF4ZipContainer* parent);
+	LIBAFF4_API_LOCAL ImageStream(std::shared_ptr<aff4::stream::structs::SharedImageStream> stream);
 	virtual ~ImageStream();
 
 	/*
@@ -127,6 +130,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * IAFF4Stream
@@ -135,52 +140,67 @@ public:
 	void close() noexcept;
 	int64_t read(void *buf, uint64_t count, uint64_t offset) noexcept;
 
-private:
 	/**
-	 * Parent container.
+	 * Load the chunks covering the given range into the chunk cache on the library executor.
+	 * <p>
+	 * Chunks already cached or already queued are skipped, and at most half the chunk cache is requested so a
+	 * prefetch does not evict the chunks it was issued for.
+	 *
+	 * @param offset The offset from the start of the stream.
+	 * @param count The length of the range.
+	 * @param priority The urgency of the hint.
 	 */
-	aff4::container::AFF4ZipContainer* parent;
+	void prefetch(uint64_t offset, uint64_t count, aff4::PrefetchPriority priority = aff4::PREFETCH_NORMAL) noexcept;
+	void evict(uint64_t offset, uint64_t count) noexcept;
 	/**
-	 * Closed flag
+	 * Read a number of ranges in a single call.
+	 * <p>
+	 * The distinct chunks backing the ranges are determined first. Chunks not cached are loaded as runs of
+	 * consecutive chunks (a single container read for chunks stored back to back), with runs loaded in parallel on
+	 * the library executor.
+	 *
+	 * @param requests The ranges to read. The result of each is set.
+	 * @param count The number of ranges.
+	 * @return The total number of bytes read, or -1 if any range failed to read.
 	 */
-	std::atomic<bool> closed;
-	/**
-	 * The length of the stream.
-	 */
-	uint64_t length;
+	int64_t readv(aff4::ReadRequest* requests, size_t count) noexcept;
 
 	/**
-	 * The chunkSize
+	 * Has this stream been closed?
+	 * @return TRUE if the stream has been closed.
 	 */
-	uint32_t chunkSize;
+	LIBAFF4_API_LOCAL bool isClosed() const noexcept;
 
 	/**
-	 * The number of chunks in each segment/bevvy.
-	 */
-	uint32_t chunksInSegment;
-	/**
-	 * Compression codec.
-	 */
-	std::shared_ptr<aff4::codec::CompressionCodec> codec;
-	/**
-	 * Cache of Bevvy Indexes.
+	 * Read a batch of ranges in a single call.
+	 * <p>
+	 * Consecutive ranges within the same chunk share a single chunk cache lookup, so batching the small, adjacent
+	 * ranges of a fragmented map avoids a cache lookup per range.
+	 *
+	 * @param reads The ranges to read.
+	 * @param count The number of ranges.
+	 * @return The total number of bytes read, or -1 if any range failed to read.
 	 */
-	std::shared_ptr<aff4::util::cache<uint32_t, std::shared_ptr<aff4::stream::structs::BevvyIndex>>> bevvyIndexCache;
+	LIBAFF4_API_LOCAL int64_t readScatter(const ScatterRead* reads, size_t count) noexcept;
 
 	/**
-	 * Bevvy Index loader.
+	 * Get the number of bytes of compressed chunks held behind the chunk cache.
+	 * <p>
+	 * A chunk evicted from the chunk cache but still held compressed is decompressed again without reading the
+	 * container. See aff4::stream::setImageStreamCompressedCacheSize().
+	 * @return The number of bytes held.
 	 */
-	std::unique_ptr<aff4::stream::structs::BevvyIndexLoader> bevvyLoader;
+	LIBAFF4_API_LOCAL uint64_t getCompressedCacheSize() noexcept;
 
+private:
 	/**
-	 * Cache of Bevvy Indexes.
+	 * The shared stream state.
 	 */
-	std::shared_ptr<aff4::util::cache<uint64_t, cacheBuffer_t>> chunkCache;
-
+	std::shared_ptr<aff4::stream::structs::SharedImageStream> stream;
 	/**
-	 * Chunk loader. (handles decompression).
+	 * Closed flag
 	 */
-	std::unique_ptr<aff4::stream::structs::ChunkLoader> chunkLoader;
+	std::atomic<bool> closed;
 };
 
 } /* namespace stream */
@@ -16,6 +16,7 @@
  */
 
 #include "ImageStreamFactory.h"
+#include "StringUtil.h"
 namespace aff4 {
 namespace stream {
 
@@ -65,5 +66,23 @@ std::shared_ptr<IAFF4Stream> createSymbolicStream(uint8_t symbol) {
 	return std::make_shared<SymbolicImageStream>(resource, symbol);
 }
 
+aff4::ExtentType getExtentType(const std::string& resource) {
+	if (resource.compare(aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_ZERO)) == 0) {
+		return aff4::ExtentType::EXTENT_ZERO;
+	}
+	if (resource.compare(aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_UNKNOWN)) == 0) {
+		return aff4::ExtentType::EXTENT_UNKNOWN;
+	}
+	if (resource.compare(aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_UNREADABLE)) == 0) {
+		return aff4::ExtentType::EXTENT_UNREADABLE;
+	}
+	std::string prefix = aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_SYMBOLIC_PREFIX);
+	if (aff4::util::hasPrefix(resource, prefix)) {
+		return (resource.compare(prefix.size(), std::string::npos, "00") == 0) ?
+				aff4::ExtentType::EXTENT_ZERO : aff4::ExtentType::EXTENT_SYMBOLIC;
+	}
+	return aff4::ExtentType::EXTENT_DATA;
+}
+
 } /* namespace stream */
 } /* namespace aff4 */
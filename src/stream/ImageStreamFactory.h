@@ -87,6 +87,14 @@ namespace stream {
 	 */
 	LIBAFF4_API std::shared_ptr<IAFF4Stream> createSymbolicStream(const std::string& resource);
 
+	/**
+	 * Get the type of content read from the stream of the given resource, from the resource name alone.
+	 *
+	 * @param resource The stream resource.
+	 * @return The extent type for symbolic stream resources, otherwise EXTENT_DATA.
+	 */
+	LIBAFF4_API aff4::ExtentType getExtentType(const std::string& resource);
+
 } /* namespace stream */
 } /* namespace aff4 */
 
@@ -17,8 +17,11 @@
 
 #include "MapStream.h"
 #include "PortableEndian.h"
+#include "Executor.h"
 
 #include <algorithm>
+#include <atomic>
+#include <functional>
 
 using namespace aff4::stream::structs;
 
@@ -27,14 +30,42 @@ namespace stream {
 
 MapStream::MapStream(const std::string& resource, aff4::container::AFF4ZipContainer* parent, uint64_t size,
 		std::shared_ptr<aff4::IAFF4Stream>& unknownOverride, std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) :
-		AFF4Resource(resource), parent(parent), closed(false), length(size) {
+		AFF4Resource(resource), closed(false), length(size), cursor(0), nextReadOffset(0), prefetchedTo(0) {
 
 	// Add default properties for this stream type.
 	addProperty(aff4::Lexicon::AFF4_TYPE, aff4::rdf::RDFValue(aff4::Lexicon::AFF4_IMAGESTREAM_TYPE));
 	addProperty(aff4::Lexicon::AFF4_SIZE, aff4::rdf::RDFValue((int64_t) length));
 
-	initStreamVector(unknownOverride);
-	initMap(mapGapStream);
+	std::shared_ptr<MapTable> newTable = std::make_shared<MapTable>();
+	newTable->length = size;
+	newTable->parent = parent;
+	initStreamVector(parent, *newTable, unknownOverride);
+	initMap(parent, *newTable, mapGapStream);
+	newTable->imageStreams.resize(newTable->streams.size(), nullptr);
+	// Type of content of each target stream.
+	for (size_t streamID = 0; streamID < newTable->streams.size(); streamID++) {
+		aff4::ExtentType type = aff4::ExtentType::EXTENT_UNKNOWN;
+		if (streamID == newTable->gapStreamID) {
+			type = aff4::ExtentType::EXTENT_GAP;
+		} else if (streamID < newTable->streamNames.size()) {
+			type = aff4::stream::getExtentType(newTable->streamNames[streamID]);
+		}
+		newTable->streamTypes.push_back(type);
+	}
+	length = newTable->length;
+	table = newTable;
+	if (length == 0) {
+		close();
+	}
+}
+
+MapStream::MapStream(const std::string& resource, const std::shared_ptr<const MapTable>& table) :
+		AFF4Resource(resource), closed(false), length(table->length), table(table), cursor(0), nextReadOffset(0), prefetchedTo(
+				0) {
+
+	// Add default properties for this stream type.
+	addProperty(aff4::Lexicon::AFF4_TYPE, aff4::rdf::RDFValue(aff4::Lexicon::AFF4_IMAGESTREAM_TYPE));
+	addProperty(aff4::Lexicon::AFF4_SIZE, aff4::rdf::RDFValue((int64_t) length));
 	if (length == 0) {
 		close();
 	}
@@ -53,9 +84,7 @@ void MapStream::close() noexcept {
 #if DEBUG
 		fprintf(aff4::getDebugOutput(), "%s[%d] : Close aff4:Map %s \n", __FILE__, __LINE__, getResourceID().c_str());
 #endif
-		parent = nullptr;
-		streams.clear();
-		externalContainers.clear();
+		std::atomic_store(&table, std::shared_ptr<const MapTable>());
 	}
 }
 
@@ -87,54 +116,404 @@ int64_t MapStream::read(void *buf, uint64_t count, uint64_t offset) noexcept {
 	uint64_t actualRead = 0;
 	uint8_t* buffer = static_cast<uint8_t*>(buf);
 	MapEntryPoint entry;
+	// Hold the table for the duration of the read, in case of a concurrent close.
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if (current == nullptr) {
+		errno = EPERM;
+		return -1;
+	}
+	const MapIndex& map = current->map;
+	size_t index = cursor.load(std::memory_order_relaxed);
+
+	// Large reads spanning several target streams read each target stream concurrently.
+	uint64_t concurrentThreshold = aff4::map::getConcurrentReadThreshold();
+	if ((concurrentThreshold != 0) && (count >= concurrentThreshold)) {
+		int64_t res = readConcurrent(*current, buffer, count, offset, index);
+		cursor.store(index, std::memory_order_relaxed);
+		if (res > 0) {
+			readAhead(*current, offset, offset + res);
+		}
+		return res;
+	}
 
+	// Consecutive entries in the same target stream are read as one batch.
+	ScatterRead batch[AFF4_MAP_READ_BATCH_SIZE];
+	size_t batchSize = 0;
+	uint32_t batchStreamID = 0;
 	while (leftToRead > 0) {
-		// Get the map entry for the current offset;
-
-		/*
-		 * map.lower_bound() will match either exact entry (offset = key), or get the next entry greater than offset.
-		 * if offset != key, we need the entry prior, hence the check of entry offset.
-		 */
-		auto mapIt = map.lower_bound(offset);
-		if (mapIt != map.end()) {
-			entry = mapIt->second;
-			if (entry.offset > offset) {
-				// We have gone 1 entry too far, so get the prior map entry.
-				mapIt--;
-				entry = mapIt->second;
+		// Get the map entry for the current offset. (Checks the last entry used and the one after first).
+		index = map.find(offset, index);
+		entry = map.get(index);
+
+		if ((batchSize == AFF4_MAP_READ_BATCH_SIZE) || ((batchSize > 0) && (entry.streamID != batchStreamID))) {
+			if (!readBatch(*current, batchStreamID, batch, batchSize)) {
+				return -1;
 			}
-		} else {
-			// past last, get last entry.
-			auto endIt = map.rbegin();
-			entry = endIt->second;
+			batchSize = 0;
 		}
-
-		std::shared_ptr<aff4::IAFF4Stream> stream = streams[entry.streamID];
 		// Offset into the lower stream
 		uint64_t streamReadOffset = entry.streamOffset + (offset - entry.offset);
 		uint64_t streadReadLength = std::min<uint64_t>(leftToRead, (entry.length - (offset - entry.offset)));
-		int64_t res = stream->read(buffer, streadReadLength, streamReadOffset);
-		if (res <= 0) {
-			// fail it.
-#if DEBUG
-			fprintf(aff4::getDebugOutput(), "%s[%d] : Reading %s %" PRIx64 " : %" PRIx64 " FAILED READ \n", __FILE__, __LINE__, 
-				stream->getResourceID().c_str(), streamReadOffset, streadReadLength);
-#endif
-			return -1;
-		}
+		batchStreamID = entry.streamID;
+		batch[batchSize].buffer = buffer;
+		batch[batchSize].count = streadReadLength;
+		batch[batchSize].offset = streamReadOffset;
+		batchSize++;
+
 		actualRead += streadReadLength;
 		offset += streadReadLength;
 		leftToRead -= streadReadLength;
 		buffer += streadReadLength;
 	}
+	if ((batchSize > 0) && !readBatch(*current, batchStreamID, batch, batchSize)) {
+		return -1;
+	}
+	cursor.store(index, std::memory_order_relaxed);
 #if DEBUG
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Completed Read  %" PRIx64 " : %" PRIx64 " => %" PRIx64 " \n", __FILE__, __LINE__, offset - actualRead, count, actualRead);
 #endif
+	readAhead(*current, offset - actualRead, offset);
 	return actualRead;
 }
 
-void MapStream::initStreamVector(std::shared_ptr<aff4::IAFF4Stream>& unknownOverride) {
+int64_t MapStream::readv(aff4::ReadRequest* requests, size_t count) noexcept {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if (closed || (current == nullptr)) {
+		for (size_t i = 0; i < count; i++) {
+			requests[i].result = -1;
+		}
+		errno = EPERM;
+		return -1;
+	}
+	// Split the ranges by target stream, so each target stream is given all of its ranges in one call.
+	const MapIndex& map = current->map;
+	std::vector<std::vector<aff4::ReadRequest>> groups;
+	std::vector<std::vector<size_t>> owners;
+	std::vector<uint32_t> groupStreamIDs;
+	std::map<uint32_t, size_t> groupIndex;
+	size_t index = cursor.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < count; i++) {
+		requests[i].result = 0;
+		uint64_t offset = requests[i].offset;
+		if ((offset >= length) || (requests[i].count == 0)) {
+			continue;
+		}
+		uint64_t leftToRead = std::min<uint64_t>(requests[i].count, length - offset);
+		uint8_t* buffer = static_cast<uint8_t*>(requests[i].buffer);
+		while (leftToRead > 0) {
+			index = map.find(offset, index);
+			MapEntryPoint entry = map.get(index);
+			uint64_t delta = offset - entry.offset;
+			uint64_t runLength = std::min<uint64_t>(leftToRead, entry.length - delta);
+			uint32_t streamID = entry.streamID;
+			auto it = groupIndex.find(streamID);
+			if (it == groupIndex.end()) {
+				it = groupIndex.emplace(streamID, groups.size()).first;
+				groups.emplace_back();
+				owners.emplace_back();
+				groupStreamIDs.push_back(streamID);
+			}
+			aff4::ReadRequest request = { buffer, runLength, entry.streamOffset + delta, 0 };
+			groups[it->second].push_back(request);
+			owners[it->second].push_back(i);
+			offset += runLength;
+			leftToRead -= runLength;
+			buffer += runLength;
+		}
+	}
+
+	std::function<void(size_t)> readGroup = [&current, &groups, &groupStreamIDs](size_t group) {
+		const std::shared_ptr<aff4::IAFF4Stream>& stream = getStream(*current, groupStreamIDs[group]);
+		if (stream == nullptr) {
+			for (aff4::ReadRequest& request : groups[group]) {
+				request.result = -1;
+			}
+			return;
+		}
+		stream->readv(groups[group].data(), groups[group].size());
+	};
+
+	// Stored data streams are read in parallel on the library executor, the rest on this thread.
+	std::vector<size_t> dataGroups;
+	for (size_t i = 0; i < groups.size(); i++) {
+		if (current->streamTypes[groupStreamIDs[i]] == aff4::ExtentType::EXTENT_DATA) {
+			dataGroups.push_back(i);
+		} else {
+			readGroup(i);
+		}
+	}
+	aff4::util::Executor::getDefault().parallel(dataGroups.size(), [&readGroup, &dataGroups](size_t i) {
+		readGroup(dataGroups[i]);
+	});
+	cursor.store(index, std::memory_order_relaxed);
+
+	// Gather the results of each range.
+	for (size_t group = 0; group < groups.size(); group++) {
+		for (size_t i = 0; i < groups[group].size(); i++) {
+			aff4::ReadRequest& request = requests[owners[group][i]];
+			if (groups[group][i].result < 0) {
+				request.result = -1;
+			} else if (request.result >= 0) {
+				request.result += groups[group][i].result;
+			}
+		}
+	}
+	int64_t actualRead = 0;
+	bool failed = false;
+	for (size_t i = 0; i < count; i++) {
+		if (requests[i].result < 0) {
+			failed = true;
+		} else {
+			actualRead += requests[i].result;
+		}
+	}
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Completed Vectored Read of %" PRIu64 " ranges over %" PRIu64 " streams => %" PRIx64 " \n",
+			__FILE__, __LINE__, (uint64_t) count, (uint64_t) groups.size(), actualRead);
+#endif
+	return failed ? -1 : actualRead;
+}
+
+void MapStream::readAhead(const MapTable& table, uint64_t offset, uint64_t end) noexcept {
+	uint64_t window = aff4::map::getPrefetchWindow();
+	if (window == 0) {
+		return;
+	}
+	if (nextReadOffset.exchange(end) != offset) {
+		// Random access, so drop any read ahead state.
+		prefetchedTo.store(end);
+		return;
+	}
+	// Top up the read ahead once less than half the window remains.
+	uint64_t from = std::max<uint64_t>(prefetchedTo.load(), end);
+	uint64_t to = std::min<uint64_t>(end + window, length);
+	if ((from >= to) || (from - end > window / 2)) {
+		return;
+	}
+	prefetchedTo.store(to);
+	// Read ahead is speculative, so gives way to explicit hints.
+	forwardHint(table, from, to, false, aff4::PREFETCH_LOW);
+}
+
+void MapStream::prefetch(uint64_t offset, uint64_t count, aff4::PrefetchPriority priority) noexcept {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if ((current == nullptr) || (offset >= length) || (count == 0)) {
+		return;
+	}
+	forwardHint(*current, offset, offset + std::min<uint64_t>(count, length - offset), false, priority);
+}
+
+void MapStream::evict(uint64_t offset, uint64_t count) noexcept {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if ((current == nullptr) || (offset >= length) || (count == 0)) {
+		return;
+	}
+	forwardHint(*current, offset, offset + std::min<uint64_t>(count, length - offset), true, aff4::PREFETCH_NORMAL);
+}
+
+void MapStream::forwardHint(const MapTable& table, uint64_t offset, uint64_t end, bool evict,
+		aff4::PrefetchPriority priority) noexcept {
+	// Collect the target stream ranges backing [offset, end), per stored data stream.
+	std::map<uint32_t, std::vector<std::pair<uint64_t, uint64_t>>> ranges;
+	const MapIndex& map = table.map;
+	size_t index = map.find(offset);
+	while ((offset < end) && (index < map.size())) {
+		const MapEntryPoint& entry = map.get(index);
+		uint32_t streamID = entry.streamID;
+		uint64_t delta = offset - entry.offset;
+		uint64_t runLength = std::min<uint64_t>(end - offset, entry.length - delta);
+		if (table.streamTypes[streamID] == aff4::ExtentType::EXTENT_DATA) {
+			ranges[streamID].push_back(std::make_pair(entry.streamOffset + delta, runLength));
+		}
+		offset += runLength;
+		index++;
+	}
+	for (auto& it : ranges) {
+		const std::shared_ptr<aff4::IAFF4Stream>& stream = getStream(table, it.first);
+		if (stream == nullptr) {
+			continue;
+		}
+		// Merge the ranges that are adjacent or overlap in the target stream.
+		std::vector<std::pair<uint64_t, uint64_t>>& targets = it.second;
+		std::sort(targets.begin(), targets.end());
+		auto hint = [&stream, evict, priority](uint64_t start, uint64_t stop) {
+			if (evict) {
+				stream->evict(start, stop - start);
+			} else {
+				stream->prefetch(start, stop - start, priority);
+			}
+		};
+		uint64_t start = targets[0].first;
+		uint64_t stop = start + targets[0].second;
+		for (size_t i = 1; i < targets.size(); i++) {
+			if (targets[i].first > stop) {
+				hint(start, stop);
+				start = targets[i].first;
+			}
+			stop = std::max<uint64_t>(stop, targets[i].first + targets[i].second);
+		}
+		hint(start, stop);
+	}
+}
+
+std::vector<aff4::StreamExtent> MapStream::getExtents(uint64_t offset, uint64_t count) noexcept {
+	std::vector<aff4::StreamExtent> extents;
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if ((current == nullptr) || (offset >= length) || (count == 0)) {
+		return extents;
+	}
+	count = std::min<uint64_t>(count, length - offset);
+	const MapIndex& map = current->map;
+	size_t index = map.find(offset);
+	uint64_t end = offset + count;
+	uint32_t lastStreamID = 0;
+	while ((offset < end) && (index < map.size())) {
+		const MapEntryPoint& entry = map.get(index);
+		uint32_t streamID = entry.streamID;
+		uint64_t delta = offset - entry.offset;
+		uint64_t runLength = std::min<uint64_t>(end - offset, entry.length - delta);
+		uint64_t targetOffset = entry.streamOffset + delta;
+		aff4::ExtentType type = current->streamTypes[streamID];
+		// Extend the last run if this entry continues it. (Runs without stored data need not be contiguous in the target).
+		if (!extents.empty() && (lastStreamID == streamID)) {
+			aff4::StreamExtent& last = extents.back();
+			if ((type != aff4::ExtentType::EXTENT_DATA) || (last.targetOffset + last.length == targetOffset)) {
+				last.length += runLength;
+				offset += runLength;
+				index++;
+				continue;
+			}
+		}
+		aff4::StreamExtent extent = { offset, runLength, type, getStreamResource(*current, streamID), targetOffset };
+		extents.push_back(extent);
+		lastStreamID = streamID;
+		offset += runLength;
+		index++;
+	}
+	return extents;
+}
+
+uint64_t MapStream::nextData(uint64_t offset) noexcept {
+	return nextExtent(offset, true);
+}
+
+uint64_t MapStream::nextHole(uint64_t offset) noexcept {
+	return nextExtent(offset, false);
+}
+
+uint64_t MapStream::nextExtent(uint64_t offset, bool data) noexcept {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if ((current == nullptr) || (offset >= length)) {
+		return length;
+	}
+	const MapIndex& map = current->map;
+	for (size_t index = map.find(offset); index < map.size(); index++) {
+		const MapEntryPoint& entry = map.get(index);
+		if (entry.offset >= length) {
+			break;
+		}
+		uint32_t streamID = entry.streamID;
+		if ((current->streamTypes[streamID] == aff4::ExtentType::EXTENT_DATA) == data) {
+			return std::max<uint64_t>(entry.offset, offset);
+		}
+	}
+	return length;
+}
+
+std::string MapStream::getStreamResource(const MapTable& table, uint32_t streamID) noexcept {
+	if (streamID < table.streamNames.size()) {
+		return table.streamNames[streamID];
+	}
+	// Streams not listed in idx are opened with the map.
+	return table.streams[streamID]->getResourceID();
+}
+
+bool MapStream::readBatch(const MapTable& table, uint32_t streamID, const ScatterRead* reads, size_t count) noexcept {
+	const std::shared_ptr<aff4::IAFF4Stream>& stream = getStream(table, streamID);
+	if (stream == nullptr) {
+		errno = EIO;
+		return false;
+	}
+	// aff4:ImageStreams read the whole batch in one call.
+	ImageStream* imageStream = (streamID < table.imageStreams.size()) ? table.imageStreams[streamID] : nullptr;
+	if (imageStream != nullptr) {
+		if (imageStream->readScatter(reads, count) <= 0) {
+#if DEBUG
+			fprintf(aff4::getDebugOutput(), "%s[%d] : Reading %s %" PRIu64 " ranges FAILED READ \n", __FILE__, __LINE__,
+					stream->getResourceID().c_str(), (uint64_t) count);
+#endif
+			return false;
+		}
+		return true;
+	}
+	for (size_t i = 0; i < count; i++) {
+		if (stream->read(reads[i].buffer, reads[i].count, reads[i].offset) <= 0) {
+			// fail it.
+#if DEBUG
+			fprintf(aff4::getDebugOutput(), "%s[%d] : Reading %s %" PRIx64 " : %" PRIx64 " FAILED READ \n", __FILE__, __LINE__,
+					stream->getResourceID().c_str(), reads[i].offset, reads[i].count);
+#endif
+			return false;
+		}
+	}
+	return true;
+}
+
+int64_t MapStream::readConcurrent(const MapTable& table, uint8_t* buffer, uint64_t count, uint64_t offset,
+		size_t& index) noexcept {
+	const MapIndex& map = table.map;
+	// Split the read by target stream, keeping the order of the reads for each target stream.
+	std::vector<std::vector<ScatterRead>> groups;
+	std::vector<uint32_t> groupStreamIDs;
+	std::map<uint32_t, size_t> groupIndex;
+	uint64_t leftToRead = count;
+	while (leftToRead > 0) {
+		index = map.find(offset, index);
+		MapEntryPoint entry = map.get(index);
+		uint64_t delta = offset - entry.offset;
+		uint64_t length = std::min<uint64_t>(leftToRead, entry.length - delta);
+		uint32_t streamID = entry.streamID;
+		auto it = groupIndex.find(streamID);
+		if (it == groupIndex.end()) {
+			it = groupIndex.emplace(streamID, groups.size()).first;
+			groups.emplace_back();
+			groupStreamIDs.push_back(streamID);
+		}
+		ScatterRead read = { buffer, length, entry.streamOffset + delta };
+		groups[it->second].push_back(read);
+		offset += length;
+		leftToRead -= length;
+		buffer += length;
+	}
+
+	std::function<bool(size_t)> readGroup = [&table, &groups, &groupStreamIDs](size_t group) {
+		return readBatch(table, groupStreamIDs[group], groups[group].data(), groups[group].size());
+	};
+
+	if (groups.size() == 1) {
+		// A single target stream is read in turn on the calling thread.
+		return readGroup(0) ? (int64_t) count : -1;
+	}
+
+	// The target streams are read in parallel on the library executor.
+	std::atomic<bool> success(true);
+	aff4::util::Executor::getDefault().parallel(groups.size(), [&readGroup, &success](size_t i) {
+		if (!readGroup(i)) {
+			success = false;
+		}
+	});
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Completed Concurrent Read  %" PRIx64 " : %" PRIx64 " over %" PRIu64 " streams \n",
+			__FILE__, __LINE__, offset - count, count, (uint64_t) groups.size());
+#endif
+	return success ? (int64_t) count : -1;
+}
+
+void MapStream::initStreamVector(aff4::container::AFF4ZipContainer* parent, MapTable& table,
+		std::shared_ptr<aff4::IAFF4Stream>& unknownOverride) {
+	std::vector<std::shared_ptr<aff4::IAFF4Stream>>& streams = table.streams;
 	streams.clear();
+	table.streamNames.clear();
 	// Get a ZipSegmentStream and compare the results.
 	std::string segmentName = getResourceID() + "/idx";
 	std::shared_ptr<aff4::IAFF4Stream> stream = parent->getSegment(segmentName);
@@ -159,45 +538,26 @@ void MapStream::initStreamVector(std::shared_ptr<aff4::IAFF4Stream>& unknownOver
 #if DEBUG
 				fprintf( aff4::getDebugOutput(), "%s[%d] : Stream : %s\n", __FILE__, __LINE__, line.c_str());
 #endif
+				// The stream itself is opened on first use.
 				std::shared_ptr<IAFF4Stream> stream;
 				if ((line.compare(aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_UNKNOWN)) == 0)
 						&& (unknownOverride != nullptr)) {
 					stream = unknownOverride;
-				} else {
-					stream = parent->getImageStream(line);
-				}
-				// We have this stream from the parent container
-				if (stream != nullptr) {
-#if DEBUG
-					fprintf(aff4::getDebugOutput(), "%s[%d] : Local for Stream %s \n", __FILE__, __LINE__, line.c_str());
-#endif
-					streams.push_back(stream);
-				} else {
-					// look at the resolver for this stream.
-#if DEBUG
-					fprintf(aff4::getDebugOutput(), "%s[%d] : Query Resolver for Stream %s \n", __FILE__, __LINE__, line.c_str());
-#endif
-					stream = queryResolver(parent->getResolver(), line);
-					if (stream != nullptr) {
-#if DEBUG
-						fprintf(aff4::getDebugOutput(), "%s[%d] : Resolver provided Stream %s \n", __FILE__, __LINE__, line.c_str());
-#endif
-						streams.push_back(stream);
-					} else {
-						// Nothing from the resolver.
-#if DEBUG
-						fprintf(aff4::getDebugOutput(), "%s[%d] : Resolver FAILED to locate Stream %s \n", __FILE__, __LINE__, line.c_str());
-#endif
-						streams.push_back(aff4::stream::createUnknownStream(line));
-					}
 				}
+				table.streamNames.push_back(line);
+				streams.push_back(stream);
 			}
 		}
 	}
+	table.streamFlags.reset(new std::once_flag[table.streamNames.size()]);
 }
 
-void MapStream::initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
-	map.clear();
+void MapStream::initMap(aff4::container::AFF4ZipContainer* parent, MapTable& table,
+		std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
+	std::vector<std::shared_ptr<aff4::IAFF4Stream>>& streams = table.streams;
+	uint64_t& length = table.length;
+	// Map of entries, while building. (upper map offset = map point entry(lower stream)).
+	std::map<uint64_t, MapEntryPoint> map;
 	std::string segmentName = getResourceID() + "/map";
 	std::shared_ptr<aff4::IAFF4Stream> stream = parent->getSegment(segmentName);
 	if (stream == nullptr) {
@@ -209,6 +569,15 @@ void MapStream::initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
 		return;
 	}
 	uint64_t streamSize = stream->size();
+#if !defined(__BYTE_ORDER) || (__BYTE_ORDER == __LITTLE_ENDIAN)
+	// Large maps are used in place if possible.
+	uint64_t entryCount = streamSize / sizeof(MapEntryPoint);
+	if ((entryCount > 0) && (entryCount >= aff4::map::getMapInPlaceThreshold())
+			&& initMappedMap(parent, table, segmentName, entryCount, mapGapStream)) {
+		stream->close();
+		return;
+	}
+#endif
 	std::unique_ptr<MapEntryPoint[]> buffer;
 	uint64_t size = 0;
 	if (streamSize > 0) {
@@ -224,6 +593,7 @@ void MapStream::initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
 	}
 	// Add the mapGapStream to the vector of streams.
 	size_t mapGPSid = streams.size();
+	table.gapStreamID = (uint32_t) mapGPSid;
 	streams.push_back(mapGapStream);
 
 #if __BYTE_ORDER == __BIG_ENDIAN
@@ -247,6 +617,7 @@ void MapStream::initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
 	}
 	// Sort all map entries
 	std::sort(points.begin(), points.end(), ::aff4::stream::structs::mapEntryPointCompare);
+	table.statistics.storedEntries = size;
 
 	// Construct the map.
 	for (uint32_t i = 0; i < size; i++) {
@@ -268,6 +639,7 @@ void MapStream::initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
 					__FILE__, __LINE__, sparseRegion.offset, sparseRegion.length, sparseRegion.streamOffset, sparseRegion.streamID);
 #endif
 			map[offset] = sparseRegion;
+			table.statistics.sparseEntries++;
 			offset = mapPoint.offset;
 		}
 		if (mapPoint.streamID >= streams.size()) {
@@ -294,19 +666,133 @@ void MapStream::initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
 				__FILE__, __LINE__, sparseRegion.offset, sparseRegion.length, sparseRegion.streamOffset, sparseRegion.streamID);
 #endif
 		map[offset] = sparseRegion;
+		table.statistics.sparseEntries++;
 	}
 	// If length not given then use the next expected offset as the stream length.
 	if (length == 0) {
 		length = offset;
 	}
+	// Flatten into the lookup index, coalescing entries contiguous in both the map and the same target stream.
+	std::vector<MapEntryPoint> entries;
+	entries.reserve(map.size());
+	for (auto it = map.begin(); it != map.end(); it++) {
+		const MapEntryPoint& mapPoint = it->second;
+		if (!entries.empty()) {
+			MapEntryPoint& last = entries.back();
+			if ((last.streamID == mapPoint.streamID) && (last.offset + last.length == mapPoint.offset)
+					&& (last.streamOffset + last.length == mapPoint.streamOffset)) {
+				last.length += mapPoint.length;
+				table.statistics.coalescedEntries++;
+				continue;
+			}
+		}
+		entries.push_back(mapPoint);
+	}
+	map.clear();
+	table.statistics.entries = entries.size();
+	table.map = MapIndex(std::move(entries));
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : aff4:Map %s entries %" PRIu64 " => %" PRIu64 " \n", __FILE__, __LINE__,
+			segmentName.c_str(), table.statistics.storedEntries, table.statistics.entries);
+#endif
 #if DEBUG
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Created aff4:Map %s on length %" PRIu64 " \n", __FILE__, __LINE__, segmentName.c_str(), length);
 #endif
 
 }
 
-std::shared_ptr<aff4::IAFF4Stream> MapStream::queryResolver(aff4::IAFF4Resolver* resolver,
+bool MapStream::initMappedMap(aff4::container::AFF4ZipContainer* parent, MapTable& table,
+		const std::string& segmentName, uint64_t count, std::shared_ptr<aff4::IAFF4Stream>& mapGapStream) {
+	uint64_t mappedSize = 0;
+	std::shared_ptr<const uint8_t> mapping = parent->mapSegment(segmentName, mappedSize);
+	if ((mapping == nullptr) || (mappedSize / sizeof(MapEntryPoint) != count)) {
+		return false;
+	}
+	// Check the entries are sorted and contiguous, and reference known streams (or the map gap stream).
+	const MapEntryPoint* points = reinterpret_cast<const MapEntryPoint*>(mapping.get());
+	size_t streamCount = table.streams.size() + 1;
+	uint64_t offset = 0;
+	for (uint64_t i = 0; i < count; i++) {
+		const MapEntryPoint& mapPoint = points[i];
+		if ((mapPoint.offset != offset) || (mapPoint.length == 0) || (mapPoint.streamID >= streamCount)) {
+#if DEBUG
+			fprintf(aff4::getDebugOutput(), "%s[%d] : aff4:Map %s can't be used in place, entry %" PRIu64 " \n", __FILE__,
+					__LINE__, segmentName.c_str(), i);
+#endif
+			return false;
+		}
+		offset += mapPoint.length;
+	}
+	if (offset < table.length) {
+		// Needs a sparse region at the end.
+		return false;
+	}
+	if (table.length == 0) {
+		table.length = offset;
+	}
+	table.gapStreamID = (uint32_t) table.streams.size();
+	table.streams.push_back(mapGapStream);
+	table.map = MapIndex(mapping, (size_t) count);
+	table.statistics.storedEntries = count;
+	table.statistics.entries = count;
+	table.statistics.mapped = true;
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : aff4:Map %s used in place, %" PRIu64 " entries \n", __FILE__, __LINE__,
+			segmentName.c_str(), count);
+#endif
+	return true;
+}
+
+const std::shared_ptr<aff4::IAFF4Stream>& MapStream::getStream(const MapTable& table, uint32_t streamID) noexcept {
+	if (streamID < table.streamNames.size()) {
+		try {
+			std::call_once(table.streamFlags[streamID], [&table, streamID]() {
+				if (table.streams[streamID] == nullptr) {
+					table.streams[streamID] = openStream(table, table.streamNames[streamID]);
+					table.openedStreams++;
+				}
+				table.imageStreams[streamID] = dynamic_cast<ImageStream*>(table.streams[streamID].get());
+			});
+		} catch (...) {
+#if DEBUG
+			fprintf(aff4::getDebugOutput(), "%s[%d] : Failed to open Stream %s \n", __FILE__, __LINE__,
+					table.streamNames[streamID].c_str());
+#endif
+		}
+	}
+	return table.streams[streamID];
+}
+
+std::shared_ptr<aff4::IAFF4Stream> MapStream::openStream(const MapTable& table, const std::string& resource) noexcept {
+	std::shared_ptr<IAFF4Stream> stream = table.parent->getImageStream(resource);
+	// We have this stream from the parent container
+	if (stream != nullptr) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Local for Stream %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+		return stream;
+	}
+	// look at the resolver for this stream.
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Query Resolver for Stream %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+	stream = queryResolver(table, table.parent->getResolver(), resource);
+	if (stream != nullptr) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Resolver provided Stream %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+		return stream;
+	}
+	// Nothing from the resolver.
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Resolver FAILED to locate Stream %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+	return aff4::stream::createUnknownStream(resource);
+}
+
+std::shared_ptr<aff4::IAFF4Stream> MapStream::queryResolver(const MapTable& table, aff4::IAFF4Resolver* resolver,
 		const std::string& resource) {
+	aff4::container::AFF4ZipContainer* parent = table.parent;
 	if (resolver == nullptr) {
 #if DEBUG
 		fprintf(aff4::getDebugOutput(), "%s[%d] : No resolver? \n", __FILE__, __LINE__);
@@ -324,14 +810,15 @@ std::shared_ptr<aff4::IAFF4Stream> MapStream::queryResolver(aff4::IAFF4Resolver*
 	}
 	// The resolver doesn't know it, so attempt to get it's parent.
 	std::shared_ptr<aff4::rdf::Model> model = parent->getRDFModel();
-	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> object = model->getObjectInformation(resource);
-	if (!object.empty()) {
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> object = //
+			aff4::rdf::Model::getSharedObjectInformation(model, resource);
+	if (object != nullptr) {
 		// We know of this at least.
-		auto objIt = object.find(aff4::Lexicon::AFF4_STORED);
-		if (objIt != object.end()) {
-			std::vector<aff4::rdf::RDFValue> properties = objIt->second;
+		auto objIt = object->find(aff4::Lexicon::AFF4_STORED);
+		if (objIt != object->end()) {
+			const std::vector<aff4::rdf::RDFValue>& properties = objIt->second;
 			if (!properties.empty()) {
-				aff4::rdf::RDFValue value = properties[0];
+				const aff4::rdf::RDFValue& value = properties[0];
 				std::string parentResource = value.getValue();
 				if (resolver->hasResource(parentResource)) {
 					// resolver has the parent;
@@ -339,7 +826,10 @@ std::shared_ptr<aff4::IAFF4Stream> MapStream::queryResolver(aff4::IAFF4Resolver*
 					// see if our resource has a type property of ImageStream;
 					if (res->getBaseType() == aff4::Lexicon::AFF4_ZIP_TYPE) {
 						std::shared_ptr<aff4::IAFF4Container> container = std::static_pointer_cast<aff4::IAFF4Container>(res);
-						externalContainers.push_back(container);
+						{
+							std::lock_guard<std::mutex> lock(table.externalContainersLock);
+							table.externalContainers.push_back(container);
+						}
 						if (container->hasResource(resource)) {
 							std::shared_ptr<aff4::IAFF4Resource> childStream = container->open(resource);
 							// see if our resource has a type property of ImageStream;
@@ -379,16 +869,51 @@ std::vector<aff4::rdf::RDFValue> MapStream::getProperty(aff4::Lexicon resource)
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> MapStream::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> MapStream::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 /*
 * Internal API
 */
 
-std::vector<std::shared_ptr<aff4::IAFF4Stream>>*  MapStream::getStreams() {
-	return &streams;
+std::vector<std::shared_ptr<aff4::IAFF4Stream>> MapStream::getStreams() {
+	std::vector<std::shared_ptr<aff4::IAFF4Stream>> streams;
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if (current == nullptr) {
+		return streams;
+	}
+	// Open all streams.
+	for (size_t streamID = 0; streamID < current->streams.size(); streamID++) {
+		streams.push_back(getStream(*current, (uint32_t) streamID));
+	}
+	return streams;
+}
+
+std::shared_ptr<const aff4::stream::structs::MapIndex> MapStream::getMap() {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	if (current == nullptr) {
+		return nullptr;
+	}
+	return std::shared_ptr<const aff4::stream::structs::MapIndex>(current, &current->map);
+}
+
+MapStatistics MapStream::getStatistics() noexcept {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	return (current == nullptr) ? MapStatistics() : current->statistics;
+}
+
+std::shared_ptr<const MapTable> MapStream::getTable() noexcept {
+	return std::atomic_load(&table);
 }
 
-std::map<uint64_t, aff4::stream::structs::MapEntryPoint>*  MapStream::getMap() {
-	return &map;
+size_t MapStream::getOpenedStreamCount() noexcept {
+	std::shared_ptr<const MapTable> current = std::atomic_load(&table);
+	return (current == nullptr) ? 0 : current->openedStreams.load();
 }
 
 
@@ -34,6 +34,7 @@
 #include "aff4.h"
 
 #include <atomic>
+#include <mutex>
 #include <vector>
 #include <map>
 #include <string>
@@ -44,6 +45,8 @@
 #include "AFF4ZipContainer.h"
 #include "AFF4Lexicon.h"
 #include "MapEntryPoint.h"
+#include "MapIndex.h"
+#include "ImageStream.h"
 
 #ifndef AFF4ZipContainer
 namespace aff4 {
@@ -53,10 +56,113 @@ class AFF4ZipContainer;
 }
 #endif
 
+#ifndef ImageStream
+namespace aff4 {
+namespace stream {
+class ImageStream;
+struct ScatterRead;
+}
+}
+#endif
+
 
 namespace aff4 {
 namespace stream {
 
+/**
+ * @brief Entry counts of a parsed aff4:Map.
+ */
+struct MapStatistics {
+	/**
+	 * The number of entries stored in the map segment.
+	 */
+	uint64_t storedEntries;
+	/**
+	 * The number of entries added to fill sparse regions. (Before coalescing).
+	 */
+	uint64_t sparseEntries;
+	/**
+	 * The number of entries merged into the prior entry, as contiguous in both the map and the target stream.
+	 */
+	uint64_t coalescedEntries;
+	/**
+	 * The number of entries held for lookups.
+	 */
+	uint64_t entries;
+	/**
+	 * Are the entries used in place from a memory mapping of the map segment?
+	 */
+	bool mapped;
+
+	MapStatistics() :
+			storedEntries(0), sparseEntries(0), coalescedEntries(0), entries(0), mapped(false) {
+	}
+};
+
+/**
+ * @brief Parsed aff4:Map table.
+ * <p>
+ * Immutable once built, and shared by every MapStream created from the same AFF4Map.
+ */
+struct MapTable {
+	/**
+	 * The length of the stream.
+	 */
+	uint64_t length;
+	/**
+	 * The parent container, used to open the streams listed in idx.
+	 */
+	aff4::container::AFF4ZipContainer* parent;
+	/**
+	 * The resources listed in idx, in stream ID order. These streams are opened on first use.
+	 */
+	std::vector<std::string> streamNames;
+	/**
+	 * One time open of each stream listed in idx.
+	 */
+	std::unique_ptr<std::once_flag[]> streamFlags;
+	/**
+	 * Vector of streams used by this map. (Streams listed in idx are NULL until first used).
+	 */
+	mutable std::vector<std::shared_ptr<aff4::IAFF4Stream>> streams;
+	/**
+	 * The aff4:ImageStream of each opened stream, for batched reads. (NULL for other stream types).
+	 */
+	mutable std::vector<aff4::stream::ImageStream*> imageStreams;
+	/**
+	 * The type of content of each stream. (Known without opening the stream).
+	 */
+	std::vector<aff4::ExtentType> streamTypes;
+	/**
+	 * The stream ID of the map gap stream.
+	 */
+	uint32_t gapStreamID;
+	/**
+	 * Index of entries, in upper map offset order. (Sparse regions are filled).
+	 */
+	aff4::stream::structs::MapIndex map;
+	/**
+	 * Collection of external containers for streams not contained in parent;
+	 */
+	mutable std::vector<std::shared_ptr<aff4::IAFF4Container>> externalContainers;
+	/**
+	 * Lock for the external containers.
+	 */
+	mutable std::mutex externalContainersLock;
+	/**
+	 * The number of streams listed in idx that have been opened.
+	 */
+	mutable std::atomic<size_t> openedStreams;
+	/**
+	 * Entry counts.
+	 */
+	MapStatistics statistics;
+
+	MapTable() :
+			length(0), parent(nullptr), gapStreamID(UINT32_MAX), openedStreams(0) {
+	}
+};
+
 /**
  * @brief Base AFF4 Map Stream.
  */
@@ -73,6 +179,13 @@ public:
 	 */
 	LIBAFF4_API_LOCAL MapStream(const std::string& resource, aff4::container::AFF4ZipContainer* parent, uint64_t size,
 			std::shared_ptr<aff4::IAFF4Stream>& unknownOverride, std::shared_ptr<aff4::IAFF4Stream>& mapGapStream);
+
+	/**
+	 * Create a new map based stream over an already parsed map table.
+	 * @param resource The resource of the map
+	 * @param table The map table, as returned by getTable() of another stream for the same map.
+	 */
+	LIBAFF4_API_LOCAL MapStream(const std::string& resource, const std::shared_ptr<const MapTable>& table);
 	virtual ~MapStream();
 
 	/*
@@ -82,6 +195,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * IAFF4Stream
@@ -89,6 +204,12 @@ public:
 	uint64_t size() noexcept;
 	void close() noexcept;
 	int64_t read(void *buf, uint64_t count, uint64_t offset) noexcept;
+	int64_t readv(aff4::ReadRequest* requests, size_t count) noexcept;
+	std::vector<aff4::StreamExtent> getExtents(uint64_t offset, uint64_t count) noexcept;
+	uint64_t nextData(uint64_t offset) noexcept;
+	uint64_t nextHole(uint64_t offset) noexcept;
+	void prefetch(uint64_t offset, uint64_t count, aff4::PrefetchPriority priority = aff4::PREFETCH_NORMAL) noexcept;
+	void evict(uint64_t offset, uint64_t count) noexcept;
 
 	/*
 	* Internal API
@@ -99,23 +220,41 @@ public:
 	* <p>
 	* <b>THIS IS INTERNAL API AND MAY CHANGE AT ANY TIME</b>
 	*
-	* @return A pointer to the internal vector of stream instances.
+	* @return The stream instances, opening any not yet used. (empty if closed).
 	*/
-	LIBAFF4_API std::vector<std::shared_ptr<aff4::IAFF4Stream>>* getStreams();
+	LIBAFF4_API std::vector<std::shared_ptr<aff4::IAFF4Stream>> getStreams();
 	/**
 	* Get the map.
 	* <p>
 	* <b>THIS IS INTERNAL API AND MAY CHANGE AT ANY TIME</b>
 	*
-	* @return A pointer to the internal map.
+	* @return The map index, which keeps the map table it belongs to alive. (NULL if closed).
+	*/
+	LIBAFF4_API std::shared_ptr<const aff4::stream::structs::MapIndex> getMap();
+	/**
+	* Get the entry counts of the map.
+	*
+	* @return The map statistics. (All 0 if closed).
 	*/
-	LIBAFF4_API std::map<uint64_t, aff4::stream::structs::MapEntryPoint>* getMap();
+	LIBAFF4_API MapStatistics getStatistics() noexcept;
+	/**
+	* Get the shared map table.
+	* <p>
+	* <b>THIS IS INTERNAL API AND MAY CHANGE AT ANY TIME</b>
+	*
+	* @return The map table. (NULL if closed).
+	*/
+	LIBAFF4_API_LOCAL std::shared_ptr<const MapTable> getTable() noexcept;
+	/**
+	* Get the number of streams listed in idx that have been opened.
+	* <p>
+	* Streams are opened on first read of a region that references them.
+	*
+	* @return The number of opened streams. (0 if closed).
+	*/
+	LIBAFF4_API size_t getOpenedStreamCount() noexcept;
 
 private:
-	/**
-	 * Parent container.
-	 */
-	aff4::container::AFF4ZipContainer* parent;
 	/**
 	 * Closed flag
 	 */
@@ -125,41 +264,156 @@ private:
 	 */
 	uint64_t length;
 	/**
-	 * Vector of streams used by this map.
+	 * The parsed map table.
 	 */
-	std::vector<std::shared_ptr<aff4::IAFF4Stream>> streams;
+	std::shared_ptr<const MapTable> table;
 	/**
-	 * Map of entries. (upper map offset = map point entry(lower stream)).
+	 * The map entry used by the last read, so sequential reads avoid a search.
 	 */
-	std::map<uint64_t, aff4::stream::structs::MapEntryPoint> map;
+	std::atomic<size_t> cursor;
 	/**
-	 * Collection of external containers for streams not contained in parent;
+	 * The offset following the last read, to detect sequential reads.
+	 */
+	std::atomic<uint64_t> nextReadOffset;
+	/**
+	 * The offset up to which read ahead has been issued.
+	 */
+	std::atomic<uint64_t> prefetchedTo;
+
+	/**
+	 * Issue read ahead of the target streams, if reads are sequential.
+	 * <p>
+	 * The map entries following the read are walked in map order, so the chunks loaded are those the next reads
+	 * will use, wherever they are in the target streams.
+	 *
+	 * @param table The map table.
+	 * @param offset The offset of the completed read.
+	 * @param end The offset following the completed read.
+	 */
+	void readAhead(const MapTable& table, uint64_t offset, uint64_t end) noexcept;
+
+	/**
+	 * Forward a prefetch or evict hint to the ranges of the stored data streams backing the given range.
+	 *
+	 * @param table The map table.
+	 * @param offset The offset from the start of the stream.
+	 * @param end The offset following the range.
+	 * @param evict TRUE to evict the ranges, FALSE to prefetch them.
+	 * @param priority The urgency of a prefetch.
+	 */
+	static void forwardHint(const MapTable& table, uint64_t offset, uint64_t end, bool evict,
+			aff4::PrefetchPriority priority) noexcept;
+
+	/**
+	 * Get the resource of the given target stream, without opening it.
+	 *
+	 * @param table The map table.
+	 * @param streamID The stream ID.
+	 * @return The stream resource.
+	 */
+	static std::string getStreamResource(const MapTable& table, uint32_t streamID) noexcept;
+
+	/**
+	 * Find the next map entry at or after offset whose target either is or isn't stored data.
+	 *
+	 * @param offset The offset from the start of the stream.
+	 * @param data TRUE to find stored data, FALSE to find regions without stored data.
+	 * @return The offset found, or the stream size if none.
 	 */
-	std::vector<std::shared_ptr<aff4::IAFF4Container>> externalContainers;
+	uint64_t nextExtent(uint64_t offset, bool data) noexcept;
+
+	/**
+	 * Read a batch of ranges from a single target stream. aff4:ImageStreams read the batch with a single call.
+	 *
+	 * @param table The map table.
+	 * @param streamID The stream ID of the target stream.
+	 * @param reads The ranges to read from the target stream.
+	 * @param count The number of ranges.
+	 * @return TRUE if all ranges were read.
+	 */
+	static bool readBatch(const MapTable& table, uint32_t streamID, const ScatterRead* reads, size_t count) noexcept;
+
+	/**
+	 * Read from the target streams of the map, reading the target streams in parallel on the library executor.
+	 * <p>
+	 * A read touching a single target stream is read on the calling thread.
+	 *
+	 * @param table The map table.
+	 * @param buffer The buffer to read into.
+	 * @param count The number of bytes to read. (Must be within the stream).
+	 * @param offset The offset to read from.
+	 * @param index The map entry to start searching from, updated with the last map entry used.
+	 * @return The number of bytes read, or -1 if any target stream read failed.
+	 */
+	static int64_t readConcurrent(const MapTable& table, uint8_t* buffer, uint64_t count, uint64_t offset,
+			size_t& index) noexcept;
 	/**
 	 * Read the idx file and create the vector of streams.
 	 *
-	 * This will also attempt to look for stream using the parent and resolver if present.
+	 * Streams are not opened here, see getStream().
 	 *
+	 * @param parent The parent container
+	 * @param table The table being built.
 	 * @param unknownOverride The stream to use to override the set Unknown Stream if used.
 	 */
-	void initStreamVector(std::shared_ptr<aff4::IAFF4Stream>& unknownOverride);
+	void initStreamVector(aff4::container::AFF4ZipContainer* parent, MapTable& table,
+			std::shared_ptr<aff4::IAFF4Stream>& unknownOverride);
 	/**
 	 * Read the map file and create the map of streams for this map instance.
 	 *
 	 * This will also attempt to sanitise any input (eg missing streams).
+	 * @param parent The parent container
+	 * @param table The table being built.
 	 * @param mapGapStream The stream to use to fill in sparse regions in the map.
 	 */
-	void initMap(std::shared_ptr<aff4::IAFF4Stream>& mapGapStream);
+	void initMap(aff4::container::AFF4ZipContainer* parent, MapTable& table,
+			std::shared_ptr<aff4::IAFF4Stream>& mapGapStream);
+
+	/**
+	 * Attempt to use the map segment in place, from a memory mapping.
+	 * <p>
+	 * This requires the segment to be stored uncompressed, with sorted, contiguous entries that cover the map length.
+	 * @param parent The parent container
+	 * @param table The table being built.
+	 * @param segmentName The name of the map segment.
+	 * @param count The number of entries in the segment.
+	 * @param mapGapStream The stream to use to fill in sparse regions in the map.
+	 * @return TRUE if the map is used in place, FALSE if it must be loaded.
+	 */
+	bool initMappedMap(aff4::container::AFF4ZipContainer* parent, MapTable& table, const std::string& segmentName,
+			uint64_t count, std::shared_ptr<aff4::IAFF4Stream>& mapGapStream);
+
+	/**
+	 * Get the stream for the given stream ID, opening it on first use.
+	 * <p>
+	 * This will look for the stream using the parent and resolver if present. Streams that can't be located are
+	 * replaced with an unknown stream.
+	 *
+	 * @param table The map table.
+	 * @param streamID The stream ID.
+	 * @return The stream.
+	 */
+	static const std::shared_ptr<aff4::IAFF4Stream>& getStream(const MapTable& table, uint32_t streamID) noexcept;
+
+	/**
+	 * Locate the stream for the given resource listed in idx.
+	 *
+	 * @param table The map table.
+	 * @param resource The resource to locate.
+	 * @return The stream.
+	 */
+	static std::shared_ptr<aff4::IAFF4Stream> openStream(const MapTable& table, const std::string& resource) noexcept;
 
 	/**
 	 * Query an external resolver for this resource.
 	 *
+	 * @param table The map table.
 	 * @param resolver The resolver to use.
 	 * @param resource The resource to query for.
 	 * @return The AFF4 object requested or NULL if not found
 	 */
-	std::shared_ptr<aff4::IAFF4Stream> queryResolver(aff4::IAFF4Resolver* resolver, const std::string& resource);
+	static std::shared_ptr<aff4::IAFF4Stream> queryResolver(const MapTable& table, aff4::IAFF4Resolver* resolver,
+			const std::string& resource);
 };
 
 } /* namespace stream */
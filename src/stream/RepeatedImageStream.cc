@@ -70,6 +70,18 @@ std::string  RepeatedImageStream::getSymbol() noexcept {
 	return symbol;
 }
 
+std::vector<aff4::StreamExtent> RepeatedImageStream::getExtents(uint64_t offset, uint64_t count) noexcept {
+	std::vector<aff4::StreamExtent> extents;
+	uint64_t length = size();
+	if ((offset < length) && (count > 0)) {
+		aff4::ExtentType type = (getResourceID().compare(aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGESTREAM_UNREADABLE)) == 0) ?
+				aff4::ExtentType::EXTENT_UNREADABLE : aff4::ExtentType::EXTENT_UNKNOWN;
+		aff4::StreamExtent extent = { offset, std::min<uint64_t>(count, length - offset), type, getResourceID(), offset };
+		extents.push_back(extent);
+	}
+	return extents;
+}
+
 int64_t RepeatedImageStream::read(void *buf, uint64_t count, uint64_t offset) noexcept {
 	if ((count == 0) || (buf == nullptr)) {
 		return 0;
@@ -119,5 +131,13 @@ std::vector<aff4::rdf::RDFValue> RepeatedImageStream::getProperty(aff4::Lexicon
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> RepeatedImageStream::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> RepeatedImageStream::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 } /* namespace stream */
 } /* namespace aff4 */
@@ -66,6 +66,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 	/*
 	 * IAFF4Stream
@@ -73,6 +75,7 @@ public:
 	uint64_t size() noexcept;
 	void close() noexcept;
 	int64_t read(void *buf, uint64_t count, uint64_t offset) noexcept;
+	std::vector<aff4::StreamExtent> getExtents(uint64_t offset, uint64_t count) noexcept;
 
 private:
 	/**
@@ -71,6 +71,17 @@ void SymbolicImageStream::close() noexcept {
 	// NOP
 }
 
+std::vector<aff4::StreamExtent> SymbolicImageStream::getExtents(uint64_t offset, uint64_t count) noexcept {
+	std::vector<aff4::StreamExtent> extents;
+	uint64_t length = size();
+	if ((offset < length) && (count > 0)) {
+		aff4::ExtentType type = (symbol == 0) ? aff4::ExtentType::EXTENT_ZERO : aff4::ExtentType::EXTENT_SYMBOLIC;
+		aff4::StreamExtent extent = { offset, std::min<uint64_t>(count, length - offset), type, getResourceID(), offset };
+		extents.push_back(extent);
+	}
+	return extents;
+}
+
 int64_t SymbolicImageStream::read(void *buf, uint64_t count, uint64_t offset) noexcept {
 	(void) offset;
 	if ((count == 0) || (buf == nullptr)) {
@@ -106,5 +117,13 @@ std::vector<aff4::rdf::RDFValue> SymbolicImageStream::getProperty(aff4::Lexicon
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> SymbolicImageStream::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> SymbolicImageStream::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 } /* namespace stream */
 } /* namespace aff4 */
@@ -16,7 +16,10 @@
  */
 
 #include "ChunkLoader.h"
+#include "ChunkStore.h"
+#include <algorithm>
 #include <inttypes.h>
+#include <string.h>
 
 namespace aff4 {
 namespace stream {
@@ -24,9 +27,20 @@ namespace structs {
 
 ChunkLoader::ChunkLoader(const std::string& resource, aff4::container::AFF4ZipContainer* parent,
 		std::shared_ptr<aff4::util::cache<uint32_t, std::shared_ptr<aff4::stream::structs::BevvyIndex>>>& bevvyCache,
-		uint32_t chunkSize, uint32_t chunksInSegment, std::shared_ptr<aff4::codec::CompressionCodec>& codec) :
+		uint32_t chunkSize, uint32_t chunksInSegment, std::shared_ptr<aff4::codec::CompressionCodec>& codec,
+		uint64_t compressedCacheSize) :
 		resource(resource), parent(parent), bevvyCache(bevvyCache), chunkSize(chunkSize), chunksInSegment(
-				chunksInSegment), codec(codec) {
+				chunksInSegment), codec(codec), codecResource(codec->getResourceID()), sharing(
+				aff4::stream::isImageStreamChunkSharingEnabled()) {
+	if (compressedCacheSize != 0) {
+		// Only ever filled with insert().
+		compressedCache = std::unique_ptr<aff4::util::cache<uint64_t, cacheBuffer_t>>(
+				new aff4::util::cache<uint64_t, cacheBuffer_t>(compressedCacheSize, [](uint64_t) {
+					return std::make_pair(std::shared_ptr<uint8_t>(), (uint32_t) 0);
+				}, [](const cacheBuffer_t& chunk) {
+					return (uint64_t) chunk.second;
+				}));
+	}
 }
 
 ChunkLoader::~ChunkLoader() {
@@ -39,6 +53,10 @@ cacheBuffer_t ChunkLoader::load(uint64_t offset) {
 #if DEBUG
 	fprintf( aff4::getDebugOutput(), "%s[%d] : Loading Buffer: %" PRIu64 " \n", __FILE__, __LINE__, offset);
 #endif
+	cacheBuffer_t compressed;
+	if ((compressedCache != nullptr) && compressedCache->find(offset, compressed)) {
+		return decode(compressed.first, compressed.second);
+	}
 
 	// Determine the bevvy ID.
 	uint64_t bevvyID = (offset / chunkSize) / chunksInSegment;
@@ -80,12 +98,92 @@ cacheBuffer_t ChunkLoader::load(uint64_t offset) {
 
 	// Create a buffer to read in our compressed data block.
 	std::shared_ptr<uint8_t> buffer(new uint8_t[chunkLength], std::default_delete<uint8_t[]>());
-	uint64_t toRead = chunkLength;
-	uint8_t* buf = buffer.get();
+	if (readFully(buffer.get(), chunkLength, chunkOffset) && (compressedCache != nullptr) && (chunkLength != chunkSize)) {
+		compressedCache->insert(offset, std::make_pair(buffer, (uint32_t) chunkLength));
+	}
+	return decode(buffer, chunkLength);
+}
+
+std::vector<cacheBuffer_t> ChunkLoader::loadRun(uint64_t offset, uint32_t count) {
+	std::vector<cacheBuffer_t> chunks(count, std::make_pair(nullptr, 0));
+	uint64_t bevvyID = (offset / chunkSize) / chunksInSegment;
+	std::shared_ptr<BevvyIndex> index = bevvyCache->get((uint32_t) bevvyID);
+	if (index == nullptr) {
+		return chunks;
+	}
+	uint32_t firstChunkID = (uint32_t) ((offset / chunkSize) % chunksInSegment);
+	count = std::min<uint32_t>(count, chunksInSegment - firstChunkID);
+	uint64_t firstOffset = (offset / chunkSize) * chunkSize;
+	std::vector<ImageStreamPoint> points(count);
+	for (uint32_t i = 0; i < count; i++) {
+		points[i] = index->getPoint(firstChunkID + i);
+		cacheBuffer_t compressed;
+		if ((points[i].length != 0) && (compressedCache != nullptr)
+				&& compressedCache->find(firstOffset + (uint64_t) i * chunkSize, compressed)) {
+			// Held compressed, so needs no read.
+			chunks[i] = decode(compressed.first, compressed.second);
+			points[i].length = 0;
+		}
+	}
+	uint32_t i = 0;
+	while (i < count) {
+		if (points[i].length == 0) {
+			i++;
+			continue;
+		}
+		// Extend the span over the following chunks stored back to back.
+		uint32_t last = i;
+		uint64_t spanLength = points[i].length;
+		while ((last + 1 < count) && (points[last + 1].length != 0)
+				&& (points[last + 1].offset == points[last].offset + points[last].length)) {
+			last++;
+			spanLength += points[last].length;
+		}
+#if DEBUG
+		fprintf( aff4::getDebugOutput(), "%s[%d] : Reading Chunk Run [%" PRIu64 ":%" PRIu64 "] for %" PRIu32 " Buffers \n",
+		__FILE__, __LINE__, index->getDataOffset() + points[i].offset, spanLength, last - i + 1);
+#endif
+		std::unique_ptr<uint8_t[]> span(new uint8_t[spanLength]);
+		bool complete = readFully(span.get(), spanLength, index->getDataOffset() + points[i].offset);
+		uint64_t position = 0;
+		for (; i <= last; i++) {
+			uint64_t chunkLength = points[i].length;
+			if ((chunkLength != chunkSize) && complete && (compressedCache != nullptr)) {
+				// Kept in the compressed chunk cache, so needs its own buffer.
+				std::shared_ptr<uint8_t> buffer(new uint8_t[chunkLength], std::default_delete<uint8_t[]>());
+				::memcpy(buffer.get(), span.get() + position, chunkLength);
+				compressedCache->insert(firstOffset + (uint64_t) i * chunkSize, std::make_pair(buffer, (uint32_t) chunkLength));
+				chunks[i] = decode(buffer, chunkLength);
+			} else if (chunkLength != chunkSize) {
+				// Decompressed straight from the span. (Non owning, as decode() doesn't retain compressed chunks).
+				chunks[i] = decode(std::shared_ptr<uint8_t>(std::shared_ptr<uint8_t>(), span.get() + position), chunkLength);
+			} else {
+				// Stored chunks are cached as is, so need their own buffer.
+				std::shared_ptr<uint8_t> buffer(new uint8_t[chunkLength], std::default_delete<uint8_t[]>());
+				::memcpy(buffer.get(), span.get() + position, chunkLength);
+				chunks[i] = decode(buffer, chunkLength);
+			}
+			position += chunkLength;
+		}
+	}
+	return chunks;
+}
+
+void ChunkLoader::evict(uint64_t offset) noexcept {
+	if (compressedCache != nullptr) {
+		compressedCache->evict(offset);
+	}
+}
+
+uint64_t ChunkLoader::getCompressedCacheSize() noexcept {
+	return (compressedCache != nullptr) ? compressedCache->getWeight() : 0;
+}
+
+bool ChunkLoader::readFully(uint8_t* buf, uint64_t toRead, uint64_t chunkOffset) {
 	while (toRead > 0) {
 #if DEBUG
-		fprintf( aff4::getDebugOutput(), "%s[%d] : Reading Chunk [%" PRIu64 ":%" PRIu64 "] for Buffer: %" PRIu64 " \n",
-		__FILE__, __LINE__, chunkOffset, toRead, offset);
+		fprintf( aff4::getDebugOutput(), "%s[%d] : Reading Chunk [%" PRIu64 ":%" PRIu64 "] \n",
+		__FILE__, __LINE__, chunkOffset, toRead);
 #endif
 		// In all typical circumstances this should be a single read, but be careful otherwise.
 		uint64_t res = parent->fileRead(buf, toRead, chunkOffset);
@@ -96,6 +194,18 @@ cacheBuffer_t ChunkLoader::load(uint64_t offset) {
 		chunkOffset += res;
 		buf += res;
 	}
+	return toRead == 0;
+}
+
+cacheBuffer_t ChunkLoader::decode(std::shared_ptr<uint8_t> buffer, uint64_t chunkLength) {
+	if ((chunkLength != chunkSize) && sharing) {
+		// Identical compressed chunks share one decompressed buffer.
+		std::shared_ptr<uint8_t> shared = ChunkStore::getDefault().find(codecResource, chunkSize,
+				buffer.get(), (uint32_t) chunkLength);
+		if (shared != nullptr) {
+			return std::make_pair(shared, chunkSize);
+		}
+	}
 	if (chunkLength != chunkSize) {
 		// decompress
 #if DEBUG
@@ -108,13 +218,20 @@ cacheBuffer_t ChunkLoader::load(uint64_t offset) {
 		fprintf(aff4::getDebugOutput(), "%s[%d] : Decompressed Chunk  [%" PRIu32 " : %" PRIu64 "] => %" PRIu64 " \n",
 			__FILE__, __LINE__, chunkSize, chunkLength, decSize);
 #endif
+		if (sharing) {
+			dest = ChunkStore::getDefault().share(codecResource, chunkSize, buffer.get(), (uint32_t) chunkLength,
+					dest);
+		}
 		return std::make_pair(dest, chunkSize);
 	}
 #if DEBUG
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Stored Chunk  [%" PRIu32 " : %" PRIu64 "] \n",
 		__FILE__, __LINE__, chunkSize, chunkLength);
 #endif
-	// No decompression needed, just return.
+	// No decompression needed, just return. (Stored chunks of zeros still share the zero page).
+	if (sharing && ChunkStore::isZero(buffer.get(), chunkSize)) {
+		return std::make_pair(ChunkStore::getZeroPage(chunkSize), chunkSize);
+	}
 	return std::make_pair(buffer, chunkSize);
 }
 
@@ -53,20 +53,47 @@ public:
 	 * @param chunkSize The chunk size of the image stream.
 	 * @param chunksInSegment The number of chunks per segment
 	 * @param codec The compression codec.
+	 * @param compressedCacheSize The size (in bytes) of the cache of compressed chunks. (0 to disable).
 	 */
 	LIBAFF4_API_LOCAL ChunkLoader(const std::string& resource, aff4::container::AFF4ZipContainer* parent,
 			std::shared_ptr<aff4::util::cache<uint32_t, std::shared_ptr<aff4::stream::structs::BevvyIndex>>>& bevvyCache,
-			uint32_t chunkSize, uint32_t chunksInSegment, std::shared_ptr<aff4::codec::CompressionCodec>& codec);
+			uint32_t chunkSize, uint32_t chunksInSegment, std::shared_ptr<aff4::codec::CompressionCodec>& codec,
+			uint64_t compressedCacheSize = 0);
 
 	virtual ~ChunkLoader();
 
 	/**
 	 * Load the given data chunk instance
+	 * <p>
+	 * Compressed chunks held in the compressed chunk cache are decompressed without reading the container.
 	 * @param offset The offset into the Image Stream to acquire.
 	 * @return A cache buffer entry.
 	 */
 	LIBAFF4_API cacheBuffer_t load(uint64_t offset);
 
+	/**
+	 * Load a run of consecutive data chunks within a single bevvy.
+	 * <p>
+	 * Chunks stored back to back in the container are read with a single read.
+	 *
+	 * @param offset The offset into the Image Stream of the first chunk.
+	 * @param count The number of chunks.
+	 * @return A cache buffer entry for each chunk. (Failed chunks have a 0 length).
+	 */
+	LIBAFF4_API_LOCAL std::vector<cacheBuffer_t> loadRun(uint64_t offset, uint32_t count);
+
+	/**
+	 * Drop the given chunk from the compressed chunk cache.
+	 * @param offset The offset into the Image Stream of the chunk.
+	 */
+	LIBAFF4_API_LOCAL void evict(uint64_t offset) noexcept;
+
+	/**
+	 * Get the number of bytes of compressed chunks held in the compressed chunk cache.
+	 * @return The number of bytes held.
+	 */
+	LIBAFF4_API_LOCAL uint64_t getCompressedCacheSize() noexcept;
+
 private:
 	/**
 	 * The name resource of this stream
@@ -92,6 +119,35 @@ private:
 	 * The compression codec in use.
 	 */
 	std::shared_ptr<aff4::codec::CompressionCodec> codec;
+	/**
+	 * Cache of compressed chunks as read, weighed by their length. (nullptr if disabled).
+	 */
+	std::unique_ptr<aff4::util::cache<uint64_t, cacheBuffer_t>> compressedCache;
+	/**
+	 * The resource ID of the compression codec.
+	 */
+	std::string codecResource;
+	/**
+	 * Share identical chunks through the library chunk store.
+	 */
+	bool sharing;
+
+	/**
+	 * Read from the parent container, retrying short reads.
+	 * @param buffer The buffer to read into.
+	 * @param length The number of bytes to read.
+	 * @param offset The offset in the container.
+	 * @return TRUE if all bytes were read.
+	 */
+	bool readFully(uint8_t* buffer, uint64_t length, uint64_t offset);
+
+	/**
+	 * Decompress the given chunk, if compressed.
+	 * @param buffer The chunk as stored.
+	 * @param chunkLength The stored length of the chunk.
+	 * @return A cache buffer entry.
+	 */
+	cacheBuffer_t decode(std::shared_ptr<uint8_t> buffer, uint64_t chunkLength);
 };
 
 } /* namespace structs */
@@ -0,0 +1,127 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ChunkStore.h"
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string.h>
+
+namespace aff4 {
+namespace stream {
+namespace structs {
+
+ChunkStore::ChunkStore(uint64_t maxEntries) noexcept :
+		entries(maxEntries, [](uint64_t) {
+			return std::shared_ptr<Entry>();
+		}) {
+}
+
+ChunkStore& ChunkStore::getDefault() noexcept {
+	static ChunkStore store;
+	return store;
+}
+
+std::shared_ptr<uint8_t> ChunkStore::getZeroPage(uint32_t size) noexcept {
+	static std::mutex zeroPagesLock;
+	static std::map<uint32_t, std::shared_ptr<uint8_t>> zeroPages;
+	std::lock_guard<std::mutex> lock(zeroPagesLock);
+	std::shared_ptr<uint8_t>& page = zeroPages[size];
+	if (page == nullptr) {
+		page = std::shared_ptr<uint8_t>(new uint8_t[size](), std::default_delete<uint8_t[]>());
+	}
+	return page;
+}
+
+bool ChunkStore::isZero(const uint8_t* buffer, uint64_t length) noexcept {
+	uint64_t i = 0;
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t word;
+		::memcpy(&word, buffer + i, sizeof(uint64_t));
+		if (word != 0) {
+			return false;
+		}
+	}
+	for (; i < length; i++) {
+		if (buffer[i] != 0) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::shared_ptr<uint8_t> ChunkStore::find(const std::string& codec, uint32_t chunkSize, const uint8_t* payload,
+		uint32_t length) noexcept {
+	if (length > AFF4_IMAGE_STREAM_SHARED_PAYLOAD_SIZE) {
+		return nullptr;
+	}
+	std::shared_ptr<Entry> entry;
+	if (!entries.find(hash(codec, chunkSize, payload, length), entry) || (entry == nullptr)) {
+		return nullptr;
+	}
+	if ((entry->chunkSize != chunkSize) || (entry->payload.size() != length) || (entry->codec != codec)
+			|| (::memcmp(entry->payload.data(), payload, length) != 0)) {
+		// Hash collision.
+		return nullptr;
+	}
+	return entry->chunk.lock();
+}
+
+std::shared_ptr<uint8_t> ChunkStore::share(const std::string& codec, uint32_t chunkSize, const uint8_t* payload,
+		uint32_t length, std::shared_ptr<uint8_t> chunk) noexcept {
+	if (isZero(chunk.get(), chunkSize)) {
+		chunk = getZeroPage(chunkSize);
+	}
+	if (length <= AFF4_IMAGE_STREAM_SHARED_PAYLOAD_SIZE) {
+		std::shared_ptr<Entry> entry = std::make_shared<Entry>();
+		entry->codec = codec;
+		entry->chunkSize = chunkSize;
+		entry->payload.assign(payload, payload + length);
+		entry->chunk = chunk;
+		// Replaces an expired entry, or one for colliding contents.
+		uint64_t key = hash(codec, chunkSize, payload, length);
+		entries.evict(key);
+		entries.insert(key, entry);
+	}
+	return chunk;
+}
+
+uint64_t ChunkStore::size() noexcept {
+	return entries.size();
+}
+
+uint64_t ChunkStore::hash(const std::string& codec, uint32_t chunkSize, const uint8_t* payload, uint32_t length) noexcept {
+	const uint64_t multiplier = 0x9E3779B97F4A7C15ULL;
+	uint64_t h = std::hash<std::string>()(codec) ^ (((uint64_t) chunkSize << 32) | length);
+	uint32_t i = 0;
+	for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+		uint64_t word;
+		::memcpy(&word, payload + i, sizeof(uint64_t));
+		h = (h ^ word) * multiplier;
+		h ^= h >> 32;
+	}
+	for (; i < length; i++) {
+		h = (h ^ payload[i]) * multiplier;
+		h ^= h >> 32;
+	}
+	return h;
+}
+
+} /* namespace structs */
+} /* namespace stream */
+} /* namespace aff4 */
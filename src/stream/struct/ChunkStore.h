@@ -0,0 +1,145 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file ChunkStore.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Content addressed store of decompressed chunks.
+ *
+ * This class allows image streams to share a single decompressed buffer for chunks with identical compressed contents.
+ */
+#ifndef SRC_STREAM_STRUCT_CHUNKSTORE_H_
+#define SRC_STREAM_STRUCT_CHUNKSTORE_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AFF4Defaults.h"
+#include "Cache.h"
+
+namespace aff4 {
+namespace stream {
+namespace structs {
+
+/**
+ * @brief Content addressed store of decompressed chunks.
+ * <p>
+ * Chunks are keyed by a hash of their compressed contents, length, codec and chunk size, and matched by comparing the
+ * compressed contents, so a hash collision is never shared. The store does not own the decompressed buffers: an
+ * entry is only found while some cache still holds its buffer. Chunks that decompress to all zeros are replaced by a
+ * single static zero page, which is always held.
+ * <p>
+ * Base implementation is MT-SAFE.
+ */
+class ChunkStore {
+public:
+	/**
+	 * Create a new chunk store.
+	 * @param maxEntries The number of compressed chunk contents to remember.
+	 */
+	ChunkStore(uint64_t maxEntries = AFF4_IMAGE_STREAM_SHARED_CHUNKS) noexcept;
+
+	/**
+	 * Get the chunk store shared by all image streams.
+	 * @return The library chunk store.
+	 */
+	static ChunkStore& getDefault() noexcept;
+
+	/**
+	 * Get the zero page of the given size. (The same buffer is returned for all calls with the same size).
+	 * @param size The size of the zero page.
+	 * @return The zero page.
+	 */
+	static std::shared_ptr<uint8_t> getZeroPage(uint32_t size) noexcept;
+
+	/**
+	 * Is the given buffer all zeros?
+	 * @param buffer The buffer.
+	 * @param length The length of the buffer.
+	 * @return TRUE if all bytes are zero.
+	 */
+	static bool isZero(const uint8_t* buffer, uint64_t length) noexcept;
+
+	/**
+	 * Find the decompressed chunk for the given compressed contents.
+	 * @param codec The resource ID of the codec.
+	 * @param chunkSize The decompressed chunk size.
+	 * @param payload The compressed contents.
+	 * @param length The length of the compressed contents.
+	 * @return The decompressed chunk, or nullptr if not held.
+	 */
+	std::shared_ptr<uint8_t> find(const std::string& codec, uint32_t chunkSize, const uint8_t* payload,
+			uint32_t length) noexcept;
+
+	/**
+	 * Record the decompressed chunk for the given compressed contents.
+	 * @param codec The resource ID of the codec.
+	 * @param chunkSize The decompressed chunk size.
+	 * @param payload The compressed contents.
+	 * @param length The length of the compressed contents.
+	 * @param chunk The decompressed chunk.
+	 * @return The chunk to use in place of the given chunk. (The zero page if the chunk is all zeros).
+	 */
+	std::shared_ptr<uint8_t> share(const std::string& codec, uint32_t chunkSize, const uint8_t* payload,
+			uint32_t length, std::shared_ptr<uint8_t> chunk) noexcept;
+
+	/**
+	 * Get the number of compressed chunk contents remembered.
+	 * @return The number of entries.
+	 */
+	uint64_t size() noexcept;
+
+private:
+	/**
+	 * A remembered compressed chunk.
+	 */
+	struct Entry {
+		std::string codec;
+		uint32_t chunkSize;
+		std::vector<uint8_t> payload;
+		std::weak_ptr<uint8_t> chunk;
+	};
+
+	/**
+	 * Hash the given compressed contents.
+	 * @param codec The resource ID of the codec.
+	 * @param chunkSize The decompressed chunk size.
+	 * @param payload The compressed contents.
+	 * @param length The length of the compressed contents.
+	 * @return The hash.
+	 */
+	static uint64_t hash(const std::string& codec, uint32_t chunkSize, const uint8_t* payload, uint32_t length) noexcept;
+
+	/**
+	 * The remembered chunks, by hash. (Only ever filled with insert()).
+	 */
+	aff4::util::cache<uint64_t, std::shared_ptr<Entry>> entries;
+};
+
+} /* namespace structs */
+} /* namespace stream */
+} /* namespace aff4 */
+
+#endif /* SRC_STREAM_STRUCT_CHUNKSTORE_H_ */
@@ -0,0 +1,143 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapIndex.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace aff4 {
+namespace stream {
+namespace structs {
+
+/**
+ * Count the trailing zero bits of a non-zero value.
+ */
+static inline unsigned int countTrailingZeros(uint64_t value) {
+#if defined(__GNUC__)
+	return (unsigned int) __builtin_ctzll(value);
+#elif defined(_MSC_VER) && defined(_WIN64)
+	unsigned long index;
+	_BitScanForward64(&index, value);
+	return (unsigned int) index;
+#else
+	unsigned int count = 0;
+	while ((value & 1) == 0) {
+		value >>= 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+MapIndex::MapIndex() noexcept :
+		count(0) {
+}
+
+MapIndex::MapIndex(std::vector<MapEntryPoint>&& points) :
+		entries(std::move(points)), count(entries.size()) {
+	if (entries.size() >= std::numeric_limits<uint32_t>::max()) {
+		// Too large for the rank table, use binary search over the entries.
+		return;
+	}
+	tree.resize(entries.size() + 1);
+	ranks.resize(entries.size() + 1);
+	size_t rank = 0;
+	build(rank, 1);
+}
+
+MapIndex::MapIndex(const std::shared_ptr<const uint8_t>& mapping, size_t count) noexcept :
+		mapping(mapping), count(count) {
+}
+
+void MapIndex::build(size_t& rank, size_t node) noexcept {
+	// In-order traversal of the implicit tree assigns the sorted entries. (Depth is log2 of the entry count).
+	if (node < tree.size()) {
+		build(rank, 2 * node);
+		tree[node] = entries[rank].offset;
+		ranks[node] = (uint32_t) rank;
+		rank++;
+		build(rank, 2 * node + 1);
+	}
+}
+
+size_t MapIndex::size() const noexcept {
+	return count;
+}
+
+const MapEntryPoint& MapIndex::get(size_t index) const noexcept {
+	return getEntries()[index];
+}
+
+const MapEntryPoint* MapIndex::getEntries() const noexcept {
+	if (mapping != nullptr) {
+		return reinterpret_cast<const MapEntryPoint*>(mapping.get());
+	}
+	return entries.data();
+}
+
+bool MapIndex::isMapped() const noexcept {
+	return mapping != nullptr;
+}
+
+size_t MapIndex::find(uint64_t offset) const noexcept {
+	size_t upper;
+	if (tree.empty()) {
+		const MapEntryPoint* points = getEntries();
+		upper = std::upper_bound(points, points + count, offset, //
+				[](uint64_t value, const MapEntryPoint& entry) {
+					return value < entry.offset;
+				}) - points;
+	} else {
+		const uint64_t* nodes = tree.data();
+		size_t node = 1;
+		while (node <= count) {
+#if defined(__GNUC__)
+			// Fetch the descendants 4 levels down ahead of time.
+			__builtin_prefetch(nodes + 16 * node);
+#endif
+			node = 2 * node + (nodes[node] <= offset);
+		}
+		// Strip the trailing right turns and the final left turn, to get the first node greater than offset.
+		node >>= countTrailingZeros(~((uint64_t) node)) + 1;
+		upper = (node == 0) ? count : ranks[node];
+	}
+	return (upper == 0) ? 0 : upper - 1;
+}
+
+size_t MapIndex::find(uint64_t offset, size_t cursor) const noexcept {
+	const MapEntryPoint* points = getEntries();
+	if ((cursor < count) && (points[cursor].offset <= offset)) {
+		// Same entry?
+		if ((cursor + 1 == count) || (offset < points[cursor + 1].offset)) {
+			return cursor;
+		}
+		// Next entry?
+		if ((cursor + 2 == count) || (offset < points[cursor + 2].offset)) {
+			return cursor + 1;
+		}
+	}
+	return find(offset);
+}
+
+} /* namespace structs */
+} /* namespace stream */
+} /* namespace aff4 */
@@ -0,0 +1,151 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file MapIndex.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief AFF4 Map lookup index.
+ *
+ * This class provides offset lookup over a sorted, flat array of map entries.
+ */
+#ifndef SRC_STREAM_STRUCT_MAPINDEX_H_
+#define SRC_STREAM_STRUCT_MAPINDEX_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <memory>
+#include <vector>
+
+#include "MapEntryPoint.h"
+
+namespace aff4 {
+namespace stream {
+namespace structs {
+
+/**
+ * @brief Flat lookup index of the entries of an aff4:Map.
+ * <p>
+ * The entries are held in one contiguous array, sorted by offset. Lookups search a copy of the entry offsets held in
+ * Eytzinger (breadth first) order, so the first levels of the search share cache lines, and the search loop is
+ * branch free. Lookups given the result of a prior lookup (a cursor) check the same and following entry first, so
+ * sequential access is O(1).
+ * <p>
+ * Alternatively the entries may be used in place, from a memory mapped map segment. In this case no copies are made,
+ * and lookups binary search the entries directly.
+ * <p>
+ * Immutable once constructed, and MT-SAFE.
+ */
+class MapIndex {
+public:
+	/**
+	 * Create an empty index.
+	 */
+	LIBAFF4_API_LOCAL MapIndex() noexcept;
+	/**
+	 * Create an index over the given entries.
+	 * @param entries The map entries, sorted by offset.
+	 */
+	LIBAFF4_API_LOCAL explicit MapIndex(std::vector<MapEntryPoint>&& entries);
+	/**
+	 * Create an index using the given entries in place.
+	 * @param mapping The packed little endian entries, sorted by offset. (Shared, so kept while the index exists).
+	 * @param count The number of entries.
+	 */
+	LIBAFF4_API_LOCAL MapIndex(const std::shared_ptr<const uint8_t>& mapping, size_t count) noexcept;
+
+	/**
+	 * Get the number of entries.
+	 * @return The number of entries.
+	 */
+	LIBAFF4_API_LOCAL size_t size() const noexcept;
+
+	/**
+	 * Get the entry at the given index.
+	 * @param index The entry index. (must be less than size()).
+	 * @return The entry.
+	 */
+	LIBAFF4_API_LOCAL const MapEntryPoint& get(size_t index) const noexcept;
+
+	/**
+	 * Get all entries, in offset order.
+	 * @return The entries. (size() in length).
+	 */
+	LIBAFF4_API_LOCAL const MapEntryPoint* getEntries() const noexcept;
+
+	/**
+	 * Are the entries used in place from a memory mapping?
+	 * @return TRUE if the entries are used in place.
+	 */
+	LIBAFF4_API_LOCAL bool isMapped() const noexcept;
+
+	/**
+	 * Find the entry that contains the given offset. (The last entry that starts at or before the offset).
+	 *
+	 * @param offset The map offset.
+	 * @return The entry index, or 0 if the offset is before all entries. (Undefined if the index is empty).
+	 */
+	LIBAFF4_API_LOCAL size_t find(uint64_t offset) const noexcept;
+
+	/**
+	 * Find the entry that contains the given offset, starting with the result of a prior lookup.
+	 *
+	 * @param offset The map offset.
+	 * @param cursor The entry index returned by a prior lookup. (Any value is accepted).
+	 * @return The entry index, or 0 if the offset is before all entries. (Undefined if the index is empty).
+	 */
+	LIBAFF4_API_LOCAL size_t find(uint64_t offset, size_t cursor) const noexcept;
+
+private:
+	/**
+	 * The entries, sorted by offset.
+	 */
+	std::vector<MapEntryPoint> entries;
+	/**
+	 * The memory mapped entries, if used in place.
+	 */
+	std::shared_ptr<const uint8_t> mapping;
+	/**
+	 * The number of entries.
+	 */
+	size_t count;
+	/**
+	 * The entry offsets in Eytzinger order. (1 based, element 0 is unused).
+	 */
+	std::vector<uint64_t> tree;
+	/**
+	 * The entry index of each tree node.
+	 */
+	std::vector<uint32_t> ranks;
+
+	/**
+	 * Fill the tree in order.
+	 * @param rank The next entry index to place.
+	 * @param node The tree node to fill.
+	 */
+	void build(size_t& rank, size_t node) noexcept;
+};
+
+} /* namespace structs */
+} /* namespace stream */
+} /* namespace aff4 */
+
+#endif /* SRC_STREAM_STRUCT_MAPINDEX_H_ */
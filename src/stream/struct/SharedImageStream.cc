@@ -0,0 +1,547 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SharedImageStream.h"
+#include "Executor.h"
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <inttypes.h>
+
+namespace aff4 {
+namespace stream {
+namespace structs {
+
+/**
+ * The next image stream identifier. (0 marks an unused per-thread cache entry).
+ */
+static std::atomic<uint64_t> nextStreamID(1);
+
+/**
+ * An entry of the per-thread chunk cache.
+ */
+struct L1Entry {
+	/**
+	 * The stream identifier, or 0 if unused.
+	 */
+	uint64_t streamID;
+	/**
+	 * The stream epoch when cached.
+	 */
+	uint64_t epoch;
+	/**
+	 * The offset of the chunk.
+	 */
+	uint64_t chunkOffset;
+	/**
+	 * The chunk.
+	 */
+	cacheBuffer_t chunk;
+};
+
+/**
+ * Per-thread direct mapped cache of recently used chunks, in front of the stream chunk caches.
+ * <p>
+ * An entry keeps its chunk alive after the stream evicts or closes it, until the thread next misses on that entry. So
+ * each thread holds at most AFF4_IMAGE_STREAM_L1_ENTRIES stale chunks.
+ */
+static thread_local L1Entry l1Cache[AFF4_IMAGE_STREAM_L1_ENTRIES];
+static_assert((AFF4_IMAGE_STREAM_L1_ENTRIES & (AFF4_IMAGE_STREAM_L1_ENTRIES - 1)) == 0,
+		"AFF4_IMAGE_STREAM_L1_ENTRIES must be a power of 2");
+
+/**
+ * Get the values of the given property.
+ * @param properties The properties.
+ * @param property The property.
+ * @return The values. (empty collection if the property is not set).
+ */
+static const std::vector<aff4::rdf::RDFValue>& getPropertyValues(
+		const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>& properties, aff4::Lexicon property) {
+	static const std::vector<aff4::rdf::RDFValue> empty;
+	auto it = properties.find(property);
+	return (it != properties.end()) ? it->second : empty;
+}
+
+SharedImageStream::SharedImageStream(const std::string& resource, aff4::container::AFF4ZipContainer* parent) :
+		parent(parent), resource(resource), closed(false), length(0), chunkSize(AFF4_DEFAULT_CHUNK_SIZE), chunksInSegment(
+		AFF4_DEFAULT_CHUNKS_PER_SEGMENT), chunkCacheEntries(0), streamID(nextStreamID++), epoch(0), prefetchRunning(0) {
+
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : Create Image Stream  %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+
+	// Share the model's information about THIS object as the object properties.
+	properties = aff4::rdf::Model::getSharedObjectInformation(this->parent->getRDFModel(), resource);
+	if (properties == nullptr) {
+		// set base type.
+		std::shared_ptr<std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> elements = //
+				std::make_shared<std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>>();
+		(*elements)[aff4::Lexicon::AFF4_TYPE].push_back(aff4::rdf::RDFValue(aff4::Lexicon::AFF4_IMAGESTREAM_TYPE));
+		(*elements)[aff4::Lexicon::AFF4_SIZE].push_back(aff4::rdf::RDFValue((int64_t) 0));
+		properties = elements;
+	}
+
+	// Get the length according the RDF metadata.
+	const std::vector<aff4::rdf::RDFValue>& sizes = getPropertyValues(*properties, aff4::Lexicon::AFF4_SIZE);
+	if (sizes.size() > 0) {
+		if (sizes[0].getXSDType() == aff4::rdf::XSDType::Long) {
+			length = sizes[0].getLong();
+		} else {
+			length = sizes[0].getInteger();
+		}
+	}
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : Length %" PRIu64 " (%" PRIx64 ") \n", __FILE__, __LINE__, length, length);
+#endif
+	// Get the chunksize
+	const std::vector<aff4::rdf::RDFValue>& chunkSizes = getPropertyValues(*properties, aff4::Lexicon::AFF4_STREAM_CHUNK_SIZE);
+	if (chunkSizes.size() > 0) {
+		if (chunkSizes[0].getXSDType() == aff4::rdf::XSDType::Long) {
+			chunkSize = (uint32_t)chunkSizes[0].getLong();
+		} else if (chunkSizes[0].getXSDType() == aff4::rdf::XSDType::Int) {
+			chunkSize = chunkSizes[0].getInteger();
+		} else if (chunkSizes[0].getXSDType() == aff4::rdf::XSDType::String) {
+			try {
+				chunkSize = (uint32_t)std::stoi(chunkSizes[0].getValue());
+			} catch (...){
+				// ignore
+			}
+		}
+	}
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : ChunkSize  %" PRIu32 " (%" PRIx32 ")\n", __FILE__, __LINE__, chunkSize, chunkSize);
+#endif
+	// Get the chunksInSegments value.
+	const std::vector<aff4::rdf::RDFValue>& chunksPerSegment = getPropertyValues(*properties, aff4::Lexicon::AFF4_STREAM_CHUNKS_PER_SEGMENT);
+	if (chunksPerSegment.size() > 0) {
+		if (chunksPerSegment[0].getXSDType() == aff4::rdf::XSDType::Long) {
+			chunksInSegment = (uint32_t)chunksPerSegment[0].getLong();
+		} else if (chunksPerSegment[0].getXSDType() == aff4::rdf::XSDType::Int) {
+			chunksInSegment = chunksPerSegment[0].getInteger();
+		} else if (chunksPerSegment[0].getXSDType() == aff4::rdf::XSDType::String) {
+			try {
+				chunksInSegment = (uint32_t)std::stoi(chunksPerSegment[0].getValue());
+			} catch (...){
+				// ignore
+			}
+		}
+	}
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : ChunksInSegment  %" PRIu32 " (%" PRIx32 ") \n", __FILE__, __LINE__, chunksInSegment, chunksInSegment);
+#endif
+	// Get the compression algorithm
+	const std::vector<aff4::rdf::RDFValue>& compression = getPropertyValues(*properties, aff4::Lexicon::AFF4_IMAGE_COMPRESSION);
+	if (compression.size() > 0) {
+		if (compression[0].getXSDType() != aff4::rdf::XSDType::Resource) {
+			std::string codecResource = compression[0].getValue();
+			codec = aff4::codec::getCodec(codecResource, chunkSize);
+		} else {
+			aff4::Lexicon codecResource = compression[0].getType();
+			codec = aff4::codec::getCodec(codecResource, chunkSize);
+		}
+	} else {
+		// Compression not defined, set as stored.
+		codec = aff4::codec::getCodec(aff4::Lexicon::AFF4_IMAGE_COMPRESSION_STORED, chunkSize);
+	}
+
+	if (codec == nullptr) {
+		length = 0;
+		close();
+		return;
+	}
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : Compression  %s \n", __FILE__, __LINE__, codec->getResourceID().c_str());
+#endif
+
+	/**
+	 * Set our bevvy index cache.
+	 */
+	bevvyLoader = std::unique_ptr<aff4::stream::structs::BevvyIndexLoader>(
+			new aff4::stream::structs::BevvyIndexLoader(resource, parent));
+
+	std::function<std::shared_ptr<aff4::stream::structs::BevvyIndex>(uint32_t)> bevvyLoaderFunction = std::bind(
+			&aff4::stream::structs::BevvyIndexLoader::load, bevvyLoader.get(), std::placeholders::_1);
+
+	bevvyIndexCache = std::make_shared<aff4::util::cache<uint32_t, std::shared_ptr<aff4::stream::structs::BevvyIndex>>>(
+	AFF4_IMAGE_STREAM_BEVVY_INDEX_CACHE_SIZE, bevvyLoaderFunction);
+
+	/**
+	 * Set our data chunk cache.
+	 */
+	chunkLoader = std::unique_ptr<aff4::stream::structs::ChunkLoader>(
+			new aff4::stream::structs::ChunkLoader(resource, parent, bevvyIndexCache, chunkSize, chunksInSegment,
+					codec, aff4::stream::getImageStreamCompressedCacheSize()));
+
+	std::function<cacheBuffer_t(uint64_t)> chunkLoaderFunction = std::bind(&aff4::stream::structs::ChunkLoader::load,
+			chunkLoader.get(), std::placeholders::_1);
+
+	// determine cache size;
+	uint64_t cacheSize = aff4::stream::getImageStreamCacheSize() / chunkSize;
+	chunkCacheEntries = cacheSize;
+#if DEBUG
+	fprintf( aff4::getDebugOutput(), "%s[%d] : Number of Chunk Cache Entries %" PRIu64 " \n", __FILE__, __LINE__, cacheSize);
+#endif
+	chunkCache = std::make_shared<aff4::util::cache<uint64_t, cacheBuffer_t>>(cacheSize, chunkLoaderFunction);
+}
+
+SharedImageStream::~SharedImageStream() {
+	close();
+}
+
+std::string SharedImageStream::getResourceID() const noexcept {
+	return resource;
+}
+
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> SharedImageStream::getProperties() noexcept {
+	return properties;
+}
+
+bool SharedImageStream::isClosed() const noexcept {
+	return closed;
+}
+
+uint64_t SharedImageStream::size() noexcept {
+	return length;
+}
+
+void SharedImageStream::close() noexcept {
+	if (!closed.exchange(true)) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Close aff4:ImageStream %s \n", __FILE__, __LINE__, resource.c_str());
+#endif
+		// Wait for any prefetch loads using the parent.
+		std::unique_lock<std::mutex> lock(prefetchLock);
+		prefetchDone.wait(lock, [this]() {
+			return prefetchRunning == 0;
+		});
+		prefetchPending.clear();
+		parent = nullptr;
+		epoch.fetch_add(1, std::memory_order_release);
+	}
+}
+
+/**
+ * Floor the given offset to multiple of chunkSize.
+ * @param offset The offset
+ * @param size The chunkSize
+ * @return The offset floored to multiple of chunkSize.
+ */
+inline uint64_t floor(uint64_t offset, uint64_t size) {
+	return (offset / size) * size;
+}
+
+int64_t SharedImageStream::readScatter(const ScatterRead* reads, size_t count) noexcept {
+	if (closed) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Reading %" PRIu64 " ranges on Closed Stream \n", __FILE__, __LINE__, (uint64_t) count);
+#endif
+		errno = EPERM;
+		return -1;
+	}
+	uint64_t actualRead = 0;
+	// The chunk used for the last range, reused while following ranges stay within it.
+	uint64_t currentChunk = UINT64_MAX;
+	const uint8_t* chunkData = nullptr;
+	uint32_t chunkLength = 0;
+
+	for (size_t i = 0; i < count; i++) {
+		uint64_t offset = reads[i].offset;
+		uint64_t leftToRead = reads[i].count;
+		// If offset beyond end, skip.
+		if (offset > size()) {
+#if DEBUG
+			fprintf(aff4::getDebugOutput(), "%s[%d] : Reading  %" PRIu64 " : %" PRIu64 "? Offset Greater than Stream size \n", __FILE__, __LINE__, offset, leftToRead);
+#endif
+			continue;
+		}
+		// If offset + count, will go beyond end, truncate count.
+		if (offset + leftToRead > size()) {
+			leftToRead -= ((offset + leftToRead) - size());
+		}
+
+#if DEBUG
+		fprintf( aff4::getDebugOutput(), "%s[%d] : Reading  %" PRIx64 " : %" PRIx64 " \n", __FILE__, __LINE__, offset, leftToRead);
+#endif
+
+		uint8_t* buffer = static_cast<uint8_t*>(reads[i].buffer);
+
+		while (leftToRead > 0) {
+
+			// Load our chunk.
+			uint64_t chunkOffset = floor(offset, chunkSize);
+			if (chunkOffset != currentChunk) {
+				chunkData = getChunk(chunkOffset, chunkLength);
+				if (chunkData == nullptr) {
+					// failed to read.
+#if DEBUG
+					fprintf(aff4::getDebugOutput(), "%s[%d] : Reading  %" PRIx64 " : %" PRIx64 " => %" PRIx64 " FAILED READ \n", __FILE__, __LINE__, offset, leftToRead, chunkOffset);
+#endif
+					return -1;
+				}
+				currentChunk = chunkOffset;
+			}
+			uint64_t delta = offset - chunkOffset;
+			uint64_t toCopy = std::min(chunkLength - delta, leftToRead);
+			::memcpy(buffer, chunkData + delta, toCopy);
+
+			actualRead += toCopy;
+			offset += toCopy;
+			leftToRead -= toCopy;
+			buffer += toCopy;
+		}
+	}
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Completed Read of %" PRIu64 " ranges => %" PRIx64 " \n", __FILE__, __LINE__, (uint64_t) count, actualRead);
+#endif
+	return actualRead;
+}
+
+const uint8_t* SharedImageStream::getChunk(uint64_t chunkOffset, uint32_t& chunkLength) noexcept {
+	uint64_t currentEpoch = epoch.load(std::memory_order_acquire);
+	L1Entry& slot = l1Cache[((chunkOffset / chunkSize) ^ (streamID * 0x9E3779B97F4A7C15ULL))
+			& (AFF4_IMAGE_STREAM_L1_ENTRIES - 1)];
+	if ((slot.streamID == streamID) && (slot.chunkOffset == chunkOffset) && (slot.epoch == currentEpoch)) {
+		chunkLength = slot.chunk.second;
+		return slot.chunk.first.get();
+	}
+	// Release the entry's chunk (possibly stale, or of another stream) before loading, and keep it released if the
+	// load fails.
+	slot.streamID = 0;
+	slot.chunk = cacheBuffer_t();
+	cacheBuffer_t chunk = chunkCache->get(chunkOffset);
+	if (chunk.second == 0) {
+		return nullptr;
+	}
+	slot.streamID = streamID;
+	slot.epoch = currentEpoch;
+	slot.chunkOffset = chunkOffset;
+	slot.chunk = std::move(chunk);
+	chunkLength = slot.chunk.second;
+	return slot.chunk.first.get();
+}
+
+void SharedImageStream::prefetch(uint64_t offset, uint64_t count, aff4::PrefetchPriority priority) noexcept {
+	if (closed || (offset >= size()) || (count == 0)) {
+		return;
+	}
+	if (offset + count > size()) {
+		count = size() - offset;
+	}
+	std::weak_ptr<SharedImageStream> self;
+	try {
+		self = shared_from_this();
+	} catch (...) {
+		// Not owned by a shared_ptr, so can't be safely referenced from the background threads.
+		return;
+	}
+	aff4::util::Executor& executor = aff4::util::Executor::getDefault();
+	// Claim the chunks to load.
+	std::vector<uint64_t> chunks;
+	uint64_t limit = chunkCacheEntries / 2;
+	for (uint64_t chunkOffset = floor(offset, chunkSize); (chunkOffset < offset + count) && (chunks.size() < limit);
+			chunkOffset += chunkSize) {
+		if (chunkCache->exists(chunkOffset)) {
+			continue;
+		}
+		std::lock_guard<std::mutex> lock(prefetchLock);
+		if (closed) {
+			break;
+		}
+		if (prefetchPending.insert(chunkOffset).second) {
+			chunks.push_back(chunkOffset);
+		}
+	}
+	// Low priority work is dropped once its queue is full. Only urgent hints are read at the caller's I/O class.
+	aff4::executor::Priority taskPriority = (priority == aff4::PREFETCH_HIGH) ? aff4::executor::PRIORITY_HIGH :
+			((priority == aff4::PREFETCH_LOW) ? aff4::executor::PRIORITY_LOW : aff4::executor::PRIORITY_NORMAL);
+	aff4::io::IOClass ioClass = (priority == aff4::PREFETCH_HIGH) ? aff4::io::getIOClass() :
+			((priority == aff4::PREFETCH_LOW) ? aff4::io::IO_SPECULATIVE : aff4::io::IO_BACKGROUND);
+	size_t queued = 0;
+	for (; queued < chunks.size(); queued++) {
+		uint64_t chunkOffset = chunks[queued];
+		bool submitted = executor.submit([self, chunkOffset, ioClass]() {
+			std::shared_ptr<SharedImageStream> stream = self.lock();
+			if (stream != nullptr) {
+				aff4::io::ScopedIOClass scope(ioClass);
+				stream->loadPrefetch(chunkOffset);
+			}
+		}, taskPriority);
+		if (!submitted) {
+			break;
+		}
+	}
+	if (queued < chunks.size()) {
+		// Queue full, release the rest of the range.
+		std::lock_guard<std::mutex> lock(prefetchLock);
+		for (size_t i = queued; i < chunks.size(); i++) {
+			prefetchPending.erase(chunks[i]);
+		}
+	}
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Prefetch %" PRIx64 " : %" PRIx64 " => %" PRIu64 " chunks \n", __FILE__, __LINE__, offset, count, (uint64_t) queued);
+#endif
+}
+
+int64_t SharedImageStream::readv(aff4::ReadRequest* requests, size_t count) noexcept {
+	if (closed) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Reading %" PRIu64 " ranges on Closed Stream \n", __FILE__, __LINE__, (uint64_t) count);
+#endif
+		for (size_t i = 0; i < count; i++) {
+			requests[i].result = -1;
+		}
+		errno = EPERM;
+		return -1;
+	}
+	// The distinct chunks needed, in offset order.
+	std::vector<uint64_t> needed;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t offset = requests[i].offset;
+		if ((offset >= size()) || (requests[i].count == 0)) {
+			continue;
+		}
+		uint64_t end = offset + std::min<uint64_t>(requests[i].count, size() - offset);
+		for (uint64_t chunkOffset = floor(offset, chunkSize); chunkOffset < end; chunkOffset += chunkSize) {
+			needed.push_back(chunkOffset);
+		}
+	}
+	std::sort(needed.begin(), needed.end());
+	needed.erase(std::unique(needed.begin(), needed.end()), needed.end());
+
+	// Group the chunks not cached into runs of consecutive chunks within a bevvy.
+	uint64_t bevvySize = (uint64_t) chunkSize * chunksInSegment;
+	uint32_t maxRun = std::max<uint32_t>(1, AFF4_READV_MAX_RUN / chunkSize);
+	std::vector<std::pair<uint64_t, uint32_t>> runs;
+	for (uint64_t chunkOffset : needed) {
+		if (chunkCache->exists(chunkOffset)) {
+			continue;
+		}
+		if (!runs.empty()) {
+			std::pair<uint64_t, uint32_t>& run = runs.back();
+			if ((run.first + (uint64_t) run.second * chunkSize == chunkOffset) && (run.second < maxRun)
+					&& (run.first / bevvySize == chunkOffset / bevvySize)) {
+				run.second++;
+				continue;
+			}
+		}
+		runs.push_back(std::make_pair(chunkOffset, 1));
+	}
+
+	// Load the runs. Chunks are held here while the ranges are filled, as they may not all fit in the cache.
+	std::map<uint64_t, cacheBuffer_t> loaded;
+	if (!runs.empty()) {
+		std::vector<std::vector<cacheBuffer_t>> results(runs.size());
+		std::function<void(size_t)> loadRun = [this, &runs, &results](size_t i) {
+			results[i] = chunkLoader->loadRun(runs[i].first, runs[i].second);
+		};
+		// Decompression is CPU bound, so extra threads only help with cores to run them.
+		aff4::util::Executor::getDefault().parallel(runs.size(), loadRun,
+				std::max<unsigned int>(1, std::thread::hardware_concurrency()));
+		for (size_t i = 0; i < runs.size(); i++) {
+			for (size_t c = 0; c < results[i].size(); c++) {
+				uint64_t chunkOffset = runs[i].first + c * chunkSize;
+				if (results[i][c].second != 0) {
+					chunkCache->insert(chunkOffset, results[i][c]);
+				}
+				loaded.insert(std::make_pair(chunkOffset, results[i][c]));
+			}
+		}
+	}
+
+	// Fill the ranges.
+	int64_t actualRead = 0;
+	bool failed = false;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t offset = requests[i].offset;
+		if ((offset >= size()) || (requests[i].count == 0)) {
+			requests[i].result = 0;
+			continue;
+		}
+		uint64_t leftToRead = std::min<uint64_t>(requests[i].count, size() - offset);
+		uint8_t* buffer = static_cast<uint8_t*>(requests[i].buffer);
+		requests[i].result = leftToRead;
+		while (leftToRead > 0) {
+			uint64_t chunkOffset = floor(offset, chunkSize);
+			auto it = loaded.find(chunkOffset);
+			cacheBuffer_t entry = (it != loaded.end()) ? it->second : chunkCache->get(chunkOffset);
+			if (entry.second == 0) {
+#if DEBUG
+				fprintf(aff4::getDebugOutput(), "%s[%d] : Reading  %" PRIx64 " : %" PRIx64 " => %" PRIx64 " FAILED READ \n", __FILE__, __LINE__, offset, leftToRead, chunkOffset);
+#endif
+				requests[i].result = -1;
+				failed = true;
+				break;
+			}
+			uint64_t delta = offset - chunkOffset;
+			uint64_t toCopy = std::min<uint64_t>(entry.second - delta, leftToRead);
+			::memcpy(buffer, entry.first.get() + delta, toCopy);
+			offset += toCopy;
+			leftToRead -= toCopy;
+			buffer += toCopy;
+		}
+		if (requests[i].result > 0) {
+			actualRead += requests[i].result;
+		}
+	}
+#if DEBUG
+	fprintf(aff4::getDebugOutput(), "%s[%d] : Completed Vectored Read of %" PRIu64 " ranges, %" PRIu64 " chunks in %" PRIu64 " runs => %" PRIx64 " \n",
+			__FILE__, __LINE__, (uint64_t) count, (uint64_t) needed.size(), (uint64_t) runs.size(), actualRead);
+#endif
+	return failed ? -1 : actualRead;
+}
+
+uint64_t SharedImageStream::getCompressedCacheSize() noexcept {
+	return chunkLoader->getCompressedCacheSize();
+}
+
+void SharedImageStream::evict(uint64_t offset, uint64_t count) noexcept {
+	if (closed || (offset >= size()) || (count == 0)) {
+		return;
+	}
+	if (offset + count > size()) {
+		count = size() - offset;
+	}
+	for (uint64_t chunkOffset = floor(offset, chunkSize); chunkOffset < offset + count; chunkOffset += chunkSize) {
+		chunkCache->evict(chunkOffset);
+		chunkLoader->evict(chunkOffset);
+	}
+	// Invalidate the stream's chunks held by the per-thread caches. Each is released when its thread next misses on
+	// that entry.
+	epoch.fetch_add(1, std::memory_order_release);
+}
+
+void SharedImageStream::loadPrefetch(uint64_t chunkOffset) noexcept {
+	{
+		std::lock_guard<std::mutex> lock(prefetchLock);
+		if (closed) {
+			prefetchPending.erase(chunkOffset);
+			return;
+		}
+		prefetchRunning++;
+	}
+	chunkCache->preload(chunkOffset);
+	{
+		std::lock_guard<std::mutex> lock(prefetchLock);
+		prefetchRunning--;
+		prefetchPending.erase(chunkOffset);
+	}
+	prefetchDone.notify_all();
+}
+
+} /* namespace structs */
+} /* namespace stream */
+} /* namespace aff4 */
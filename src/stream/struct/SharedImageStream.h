@@ -0,0 +1,251 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file SharedImageStream.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Shared state of an AFF4 Zip based ImageStream
+ *
+ * This class holds the decoded information and caches of an aff4:ImageStream, shared by all ImageStream instances
+ * opened on the same resource of a container.
+ */
+#ifndef SRC_STREAM_STRUCT_SHAREDIMAGESTREAM_H_
+#define SRC_STREAM_STRUCT_SHAREDIMAGESTREAM_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "ImageStream.h"
+
+namespace aff4 {
+namespace stream {
+namespace structs {
+
+/**
+ * @brief Shared state of an aff4:ImageStream.
+ * <p>
+ * Holds the bevvy index cache, the chunk cache and the compressed chunk cache of the stream. The container registers
+ * one instance per stream resource, and every ImageStream opened on that resource reads through it, so consumers of
+ * the same stream share its caches. Closing an ImageStream does not close the shared state; it is closed when the
+ * container is closed, or destroyed once no ImageStream holds it.
+ * <p>
+ * Base implementation is MT-SAFE.
+ */
+class SharedImageStream: public std::enable_shared_from_this<SharedImageStream> {
+public:
+	/**
+	 * Create the shared state of the given stream, backed by a AFF4 Zip container
+	 * @param resource The resource
+	 * @param parent The parent container.
+	 */
+	LIBAFF4_API_LOCAL SharedImageStream(const std::string& resource, aff4::container::AFF4ZipContainer* parent);
+	virtual ~SharedImageStream();
+
+	/**
+	 * Get the resource URN of the stream.
+	 * @return The resource URN of the stream.
+	 */
+	std::string getResourceID() const noexcept;
+
+	/**
+	 * Get the properties of the stream. (Shared with the container's RDF model where present).
+	 * @return The properties of the stream.
+	 */
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getProperties() noexcept;
+
+	/**
+	 * Get the length of the stream.
+	 * @return The length of the stream.
+	 */
+	uint64_t size() noexcept;
+
+	/**
+	 * Close the stream for all ImageStreams reading it, waiting for prefetch loads using the parent to complete.
+	 */
+	void close() noexcept;
+
+	/**
+	 * Has this stream been closed?
+	 * @return TRUE if the stream has been closed.
+	 */
+	bool isClosed() const noexcept;
+
+	/**
+	 * Read a batch of ranges in a single call.
+	 * @param reads The ranges to read.
+	 * @param count The number of ranges.
+	 * @return The total number of bytes read, or -1 if any range failed to read.
+	 * @see aff4::stream::ImageStream::readScatter()
+	 */
+	int64_t readScatter(const ScatterRead* reads, size_t count) noexcept;
+
+	/**
+	 * Read a number of ranges in a single call.
+	 * @param requests The ranges to read. The result of each is set.
+	 * @param count The number of ranges.
+	 * @return The total number of bytes read, or -1 if any range failed to read.
+	 * @see aff4::stream::ImageStream::readv()
+	 */
+	int64_t readv(aff4::ReadRequest* requests, size_t count) noexcept;
+
+	/**
+	 * Load the chunks covering the given range into the chunk cache on the library executor.
+	 * @param offset The offset from the start of the stream.
+	 * @param count The length of the range.
+	 * @param priority The urgency of the hint.
+	 * @see aff4::stream::ImageStream::prefetch()
+	 */
+	void prefetch(uint64_t offset, uint64_t count, aff4::PrefetchPriority priority) noexcept;
+
+	/**
+	 * Drop the chunks covering the given range from the caches.
+	 * <p>
+	 * The chunks held by the per-thread caches are invalidated, but released only as each thread next misses on their
+	 * entries. (At most AFF4_IMAGE_STREAM_L1_ENTRIES chunks per thread).
+	 * @param offset The offset from the start of the stream.
+	 * @param count The length of the range.
+	 */
+	void evict(uint64_t offset, uint64_t count) noexcept;
+
+	/**
+	 * Get the number of bytes of compressed chunks held behind the chunk cache.
+	 * @return The number of bytes held.
+	 */
+	uint64_t getCompressedCacheSize() noexcept;
+
+private:
+	/**
+	 * Parent container.
+	 */
+	aff4::container::AFF4ZipContainer* parent;
+	/**
+	 * The resource.
+	 */
+	const std::string resource;
+	/**
+	 * The properties of the stream.
+	 */
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties;
+	/**
+	 * Closed flag
+	 */
+	std::atomic<bool> closed;
+	/**
+	 * The length of the stream.
+	 */
+	uint64_t length;
+
+	/**
+	 * The chunkSize
+	 */
+	uint32_t chunkSize;
+
+	/**
+	 * The number of chunks in each segment/bevvy.
+	 */
+	uint32_t chunksInSegment;
+	/**
+	 * Compression codec.
+	 */
+	std::shared_ptr<aff4::codec::CompressionCodec> codec;
+	/**
+	 * Cache of Bevvy Indexes.
+	 */
+	std::shared_ptr<aff4::util::cache<uint32_t, std::shared_ptr<aff4::stream::structs::BevvyIndex>>> bevvyIndexCache;
+
+	/**
+	 * Bevvy Index loader.
+	 */
+	std::unique_ptr<aff4::stream::structs::BevvyIndexLoader> bevvyLoader;
+
+	/**
+	 * Cache of data chunks.
+	 */
+	std::shared_ptr<aff4::util::cache<uint64_t, cacheBuffer_t>> chunkCache;
+
+	/**
+	 * Chunk loader. (handles decompression).
+	 */
+	std::unique_ptr<aff4::stream::structs::ChunkLoader> chunkLoader;
+
+	/**
+	 * The number of entries in the chunk cache.
+	 */
+	uint64_t chunkCacheEntries;
+
+	/**
+	 * Unique (never reused) identifier of this stream, used to key the per-thread chunk cache.
+	 */
+	uint64_t streamID;
+	/**
+	 * Incremented to invalidate the chunks of this stream held in the per-thread chunk caches.
+	 */
+	std::atomic<uint64_t> epoch;
+
+	/**
+	 * Lock for the prefetch state.
+	 */
+	std::mutex prefetchLock;
+	/**
+	 * Signalled when a prefetch load completes.
+	 */
+	std::condition_variable prefetchDone;
+	/**
+	 * Chunks queued for prefetch, and not yet loaded.
+	 */
+	std::set<uint64_t> prefetchPending;
+	/**
+	 * The number of prefetch loads in progress. close() waits for these, as they use the parent container.
+	 */
+	uint32_t prefetchRunning;
+
+	/**
+	 * Get the given chunk, from the calling thread's chunk cache if held there, else from the shared chunk cache.
+	 * <p>
+	 * A hit in the thread's cache takes no lock and no reference, so the returned pointer is only valid until the next
+	 * call by this thread.
+	 * @param chunkOffset The offset of the chunk.
+	 * @param chunkLength Set to the length of the chunk.
+	 * @return The chunk contents, or NULL if the chunk failed to load.
+	 */
+	const uint8_t* getChunk(uint64_t chunkOffset, uint32_t& chunkLength) noexcept;
+
+	/**
+	 * Load a prefetched chunk into the chunk cache. (Called on a library worker thread).
+	 * @param chunkOffset The offset of the chunk.
+	 */
+	void loadPrefetch(uint64_t chunkOffset) noexcept;
+};
+
+} /* namespace structs */
+} /* namespace stream */
+} /* namespace aff4 */
+
+#endif /* SRC_STREAM_STRUCT_SHAREDIMAGESTREAM_H_ */
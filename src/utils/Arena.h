@@ -0,0 +1,212 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Arena.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Monotonic arena and STL allocator for per-container metadata.
+ */
+
+#ifndef SRC_UTILS_ARENA_H_
+#define SRC_UTILS_ARENA_H_
+
+#include "aff4config.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+
+#include "AFF4Defaults.h"
+
+namespace aff4 {
+namespace util {
+
+/**
+ * @brief Monotonic memory arena.
+ * <p>
+ * Memory is handed out from large blocks by bumping a pointer, individual deallocation is a no-op, and all blocks
+ * are released in one step when the arena is destroyed. Objects allocated from the arena must not require their
+ * memory after the arena is gone; use ArenaAllocator, which shares ownership of the arena.
+ * <p>
+ * Allocation is NOT MT-SAFE. Owners allocate while building their (subsequently read only) structures.
+ */
+class Arena {
+public:
+	/**
+	 * Create a new arena.
+	 * @param blockSize The size of the first block. Subsequent blocks double in size, up to 16 times this size.
+	 */
+	explicit Arena(size_t blockSize = AFF4_ARENA_BLOCK_SIZE) noexcept :
+			head(nullptr), current(nullptr), remaining(0), blockSize(blockSize), maxBlockSize(blockSize * 16), allocated(0), reserved(0) {
+	}
+
+	~Arena() {
+		release();
+	}
+
+	/**
+	 * Allocate memory from the arena.
+	 * @param size The number of bytes.
+	 * @param alignment The required alignment. (power of 2, at most alignof(max_align_t)).
+	 * @return The allocated memory.
+	 * @throws std::bad_alloc if the memory can't be allocated.
+	 */
+	void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+		size_t padding = (alignment - (reinterpret_cast<uintptr_t>(current) & (alignment - 1))) & (alignment - 1);
+		if ((current == nullptr) || (size + padding > remaining)) {
+			addBlock(size + alignment);
+			padding = (alignment - (reinterpret_cast<uintptr_t>(current) & (alignment - 1))) & (alignment - 1);
+		}
+		uint8_t* ptr = current + padding;
+		current = ptr + size;
+		remaining -= size + padding;
+		allocated += size;
+		return ptr;
+	}
+
+	/**
+	 * Release all memory held by the arena.
+	 */
+	void release() noexcept {
+		while (head != nullptr) {
+			Block* next = head->next;
+			::free(head);
+			head = next;
+		}
+		current = nullptr;
+		remaining = 0;
+		allocated = 0;
+		reserved = 0;
+	}
+
+	/**
+	 * Get the number of bytes handed out.
+	 * @return The number of bytes handed out.
+	 */
+	size_t getAllocated() const noexcept {
+		return allocated;
+	}
+
+	/**
+	 * Get the number of bytes held in blocks.
+	 * @return The number of bytes held.
+	 */
+	size_t getReserved() const noexcept {
+		return reserved;
+	}
+
+private:
+	/**
+	 * Block header, the block memory follows.
+	 */
+	struct Block {
+		Block* next;
+		std::max_align_t align;
+	};
+
+	Block* head;
+	uint8_t* current;
+	size_t remaining;
+	size_t blockSize;
+	size_t maxBlockSize;
+	size_t allocated;
+	size_t reserved;
+
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+
+	/**
+	 * Add a block of at least the given size.
+	 * @param minimum The minimum number of bytes required.
+	 */
+	void addBlock(size_t minimum) {
+		size_t size = (minimum > blockSize) ? minimum : blockSize;
+		Block* block = static_cast<Block*>(::malloc(offsetof(Block, align) + size));
+		if (block == nullptr) {
+			throw std::bad_alloc();
+		}
+		block->next = head;
+		head = block;
+		current = reinterpret_cast<uint8_t*>(&block->align);
+		remaining = size;
+		reserved += size;
+		if (blockSize < maxBlockSize) {
+			blockSize *= 2;
+		}
+	}
+};
+
+/**
+ * @brief STL allocator backed by a shared Arena.
+ * <p>
+ * Every copy shares ownership of the arena, so the arena lives as long as any container or shared_ptr control
+ * block (see std::allocate_shared) built with it.
+ */
+template<typename T>
+class ArenaAllocator {
+public:
+	typedef T value_type;
+
+	/**
+	 * Create an allocator for the given arena.
+	 * @param arena The arena.
+	 */
+	explicit ArenaAllocator(const std::shared_ptr<Arena>& arena) noexcept :
+			arena(arena) {
+	}
+
+	template<typename U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept :
+			arena(other.arena) {
+	}
+
+	T* allocate(size_t n) {
+		return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* ptr, size_t n) noexcept {
+		// Released with the arena.
+		(void) ptr;
+		(void) n;
+	}
+
+	template<typename U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept {
+		return arena == other.arena;
+	}
+
+	template<typename U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+		return arena != other.arena;
+	}
+
+	/**
+	 * The shared arena.
+	 */
+	std::shared_ptr<Arena> arena;
+};
+
+} /* namespace util */
+} /* namespace aff4 */
+
+#endif /* SRC_UTILS_ARENA_H_ */
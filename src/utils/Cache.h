@@ -41,7 +41,7 @@ namespace util {
  *
  * This cache does not have an explicit/public put() function. Rather elements are loaded into the cache on demand
  * when get() is called and the key doesn't exist in the cache. The cache will invoke the provided function of the
- * cache loader provided.
+ * cache loader provided. (Elements loaded in bulk by the owner may be added with insert()).
  *
  * Base implementation is MT-SAFE.
  */
@@ -59,12 +59,17 @@ public:
 
 	/**
 	 * Create a new cache instance containing up to max elements.
+	 * <p>
+	 * With a weigher, the cache instead holds elements up to a total weight (eg bytes). The most recently used element
+	 * is always held, even if heavier than the maximum.
 	 *
-	 * @param maxSize The maximum number of elements.
+	 * @param maxSize The maximum number of elements, or the maximum total weight if a weigher is given.
 	 * @param loader Function pointer to load values for the cache, if the key doesn't exist.
+	 * @param weigher Function to determine the weight of an element, or nullptr to count elements.
 	 */
-	cache(uint64_t maxSize, std::function<value_t(key_t)> loader) :
-			maxSize(maxSize), loader(loader) {
+	cache(uint64_t maxSize, std::function<value_t(key_t)> loader,
+			std::function<uint64_t(const value_t&)> weigher = nullptr) :
+			maxSize(maxSize), weight(0), loader(loader), weigher(weigher) {
 	}
 
 	~cache() {
@@ -73,11 +78,13 @@ public:
 
 	/**
 	 * Get the element from the cache.
+	 * <p>
+	 * The element is returned by value, as another thread may evict it as soon as the cache lock is released.
 	 *
 	 * @param key The Key to get.
 	 * @return The item from the cache.
 	 */
-	const value_t& get(const key_t& key) noexcept {
+	value_t get(const key_t& key) noexcept {
 		std::lock_guard<std::recursive_mutex> lock(cacheLock);
 		auto it = cacheMap.find(key);
 		if (it == cacheMap.end()) {
@@ -95,6 +102,73 @@ public:
 		}
 	}
 
+	/**
+	 * Get the element from the cache, if held, without loading it.
+	 *
+	 * @param key The Key to get.
+	 * @param value Set to the element, if held.
+	 * @return TRUE if the element was held.
+	 */
+	bool find(const key_t& key, value_t& value) noexcept {
+		std::lock_guard<std::recursive_mutex> lock(cacheLock);
+		auto it = cacheMap.find(key);
+		if (it == cacheMap.end()) {
+			return false;
+		}
+		cacheItems.splice(cacheItems.begin(), cacheItems, it->second);
+		value = it->second->second;
+		return true;
+	}
+
+	/**
+	 * Load the element into the cache, if not already held.
+	 * <p>
+	 * Unlike get(), the loader is invoked without holding the cache lock, so concurrent get() calls for other
+	 * elements are not blocked while the element loads.
+	 *
+	 * @param key The Key to load.
+	 */
+	void preload(const key_t& key) noexcept {
+		{
+			std::lock_guard<std::recursive_mutex> lock(cacheLock);
+			if (cacheMap.find(key) != cacheMap.end()) {
+				return;
+			}
+		}
+		insert(key, loader(key));
+	}
+
+	/**
+	 * Insert an element loaded outside of the cache, if not already held.
+	 *
+	 * @param key The Key.
+	 * @param value The element.
+	 */
+	void insert(const key_t& key, const value_t& value) noexcept {
+		std::lock_guard<std::recursive_mutex> lock(cacheLock);
+		if (cacheMap.find(key) == cacheMap.end()) {
+			put(key, value);
+		}
+	}
+
+	/**
+	 * Remove the element from the cache, if held.
+	 *
+	 * @param key The Key to remove.
+	 * @return TRUE if the element was held.
+	 */
+	bool evict(const key_t& key) noexcept {
+		std::lock_guard<std::recursive_mutex> lock(cacheLock);
+		auto it = cacheMap.find(key);
+		if (it == cacheMap.end()) {
+			return false;
+		}
+		weight -= weigh(it->second->second);
+		cacheItems.erase(it->second);
+		cacheMap.erase(it);
+		return true;
+	}
+
 	/**
 	 * Does the key exist within the cache
 	 *
@@ -115,6 +189,15 @@ public:
 		return cacheMap.size();
 	}
 
+	/**
+	 * Get the total weight of the elements held by the cache. (The number of elements, if the cache has no weigher).
+	 * @return The total weight of the held elements.
+	 */
+	uint64_t getWeight() noexcept {
+		std::lock_guard<std::recursive_mutex> lock(cacheLock);
+		return weight;
+	}
+
 	/**
 	 * Invalidate the entire cache.
 	 *
@@ -124,6 +207,7 @@ public:
 		std::lock_guard<std::recursive_mutex> lock(cacheLock);
 		cacheItems.clear();
 		cacheMap.clear();
+		weight = 0;
 		return true;
 	}
 
@@ -140,20 +224,32 @@ private:
 	void put(const key_t& key, const value_t& value) {
 		auto it = cacheMap.find(key);
 		cacheItems.push_front(keyValuePair_t(key, value));
+		weight += weigh(value);
 		if (it != cacheMap.end()) {
+			weight -= weigh(it->second->second);
 			cacheItems.erase(it->second);
 			cacheMap.erase(it);
 		}
 		cacheMap[key] = cacheItems.begin();
 
-		if (cacheMap.size() > maxSize) {
+		while ((weight > maxSize) && (cacheItems.size() > 1)) {
 			auto last = cacheItems.end();
 			last--;
+			weight -= weigh(last->second);
 			cacheMap.erase(last->first);
 			cacheItems.pop_back();
 		}
 	}
 
+	/**
+	 * Get the weight of the given element.
+	 * @param value The element.
+	 * @return The weight of the element.
+	 */
+	uint64_t weigh(const value_t& value) const {
+		return weigher ? weigher(value) : 1;
+	}
+
 	/**
 	 * Lock for the cache. (use std::lock_guard to acquire).
 	 *
@@ -169,13 +265,21 @@ private:
 	 */
 	std::map<key_t, listIterator_t> cacheMap;
 	/**
-	 * The maximum number of entries for this cache.
+	 * The maximum number of entries (or total weight) for this cache.
 	 */
 	uint64_t maxSize;
+	/**
+	 * The total weight of the held entries.
+	 */
+	uint64_t weight;
 	/**
 	 * Function pointer for load function.
 	 */
 	std::function<value_t(key_t)> loader;
+	/**
+	 * Function to weigh entries, or nullptr to count entries.
+	 */
+	std::function<uint64_t(const value_t&)> weigher;
 };
 
 }/* namespace util */
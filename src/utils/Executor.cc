@@ -0,0 +1,472 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Executor.h"
+#include "IOScheduler.h"
+#include "aff4.h"
+
+#include <algorithm>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace aff4 {
+namespace util {
+
+/**
+ * The executor the calling thread is a worker of, if any.
+ */
+static thread_local const Executor* currentExecutor = nullptr;
+/**
+ * The index of the calling worker thread's queue.
+ */
+static thread_local size_t currentSlot = 0;
+
+/**
+ * State shared by the invocations of a single call to Executor::parallel().
+ */
+struct ParallelGroup {
+	/**
+	 * The next index to claim.
+	 */
+	std::atomic<size_t> next;
+	/**
+	 * The number of invocations yet to complete.
+	 */
+	std::atomic<size_t> remaining;
+	/**
+	 * Lock for done.
+	 */
+	std::mutex lock;
+	/**
+	 * Signalled once all invocations have completed.
+	 */
+	std::condition_variable done;
+};
+
+/**
+ * Resolve the requested number of worker threads.
+ * @param threads The requested number of threads. (0 for the default).
+ * @return The number of threads to start.
+ */
+static size_t resolveThreads(size_t threads) {
+	if (threads == 0) {
+		threads = std::max<size_t>(AFF4_EXECUTOR_MIN_THREADS, std::thread::hardware_concurrency());
+	}
+	return std::min<size_t>(threads, AFF4_EXECUTOR_MAX_THREADS);
+}
+
+Executor::Executor(size_t threads) noexcept :
+		workerQueues(new WorkerQueue[AFF4_EXECUTOR_MAX_THREADS]), active(0), pending(0), threads(resolveThreads(threads)), //
+		generation(0), stopped(false) {
+	limits[aff4::executor::PRIORITY_LOW] = AFF4_EXECUTOR_LOW_QUEUE_SIZE;
+	limits[aff4::executor::PRIORITY_NORMAL] = AFF4_EXECUTOR_QUEUE_SIZE;
+	limits[aff4::executor::PRIORITY_HIGH] = AFF4_EXECUTOR_QUEUE_SIZE;
+}
+
+Executor::~Executor() {
+	shutdown();
+}
+
+Executor& Executor::getDefault() noexcept {
+	// Never destroyed: joining the workers during static destruction would wait on tasks that may still use the
+	// library's other statics, after those have been destroyed.
+	static Executor* executor = new Executor();
+	return *executor;
+}
+
+int64_t Executor::getCurrentSlot() const noexcept {
+	return (currentExecutor == this) ? (int64_t) currentSlot : -1;
+}
+
+bool Executor::submit(std::function<void()> task, aff4::executor::Priority priority) noexcept {
+	if ((priority < aff4::executor::PRIORITY_LOW) || (priority > aff4::executor::PRIORITY_HIGH)) {
+		return false;
+	}
+	// Run the task with the I/O class of its submitter; speculative work yields to all other reads.
+	aff4::io::IOClass ioClass = (priority == aff4::executor::PRIORITY_LOW) ? aff4::io::IO_SPECULATIVE :
+			IOScheduler::getCurrentClass();
+	try {
+		std::function<void()> inner(std::move(task));
+		task = [ioClass, inner]() {
+			// Restored even if the task throws.
+			aff4::io::ScopedIOClass scope(ioClass);
+			inner();
+		};
+	} catch (...) {
+		return false;
+	}
+	// Work forked by a worker stays on that worker, unless speculative.
+	int64_t slot = (priority != aff4::executor::PRIORITY_LOW) ? getCurrentSlot() : -1;
+	aff4::executor::HostExecutor hostExecutor;
+	uint64_t limit;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		if (stopped) {
+			return false;
+		}
+		hostExecutor = host;
+		limit = limits[priority];
+		if (!hostExecutor) {
+			if (!start()) {
+				return false;
+			}
+			if (slot < 0) {
+				std::deque<std::function<void()>>& queue = queues[priority];
+				if (queue.size() >= limit) {
+					return false;
+				}
+				try {
+					queue.push_back(std::move(task));
+				} catch (...) {
+					return false;
+				}
+				pending++;
+			}
+		}
+	}
+	if (hostExecutor) {
+		try {
+			hostExecutor(std::move(task), priority);
+		} catch (...) {
+			return false;
+		}
+		return true;
+	}
+	if (slot >= 0) {
+		WorkerQueue& queue = workerQueues[slot];
+		// Count before queuing, so pending never falls below the number of queued tasks.
+		pending++;
+		{
+			std::lock_guard<std::mutex> guard(queue.lock);
+			bool queued = false;
+			if (queue.tasks.size() < limit) {
+				try {
+					queue.tasks.push_back(std::move(task));
+					queued = true;
+				} catch (...) {
+				}
+			}
+			if (!queued) {
+				pending--;
+				return false;
+			}
+		}
+		// Synchronise with workers testing pending before they wait.
+		std::lock_guard<std::mutex> guard(lock);
+	}
+	available.notify_one();
+	return true;
+}
+
+void Executor::parallel(size_t count, const std::function<void(size_t)>& body, size_t maxThreads) noexcept {
+	size_t helpers = (count == 0) ? 0 : std::min<size_t>(count - 1, getThreadCount());
+	if (maxThreads != 0) {
+		helpers = std::min<size_t>(helpers, maxThreads - 1);
+	}
+	if (helpers == 0) {
+		for (size_t index = 0; index < count; index++) {
+			body(index);
+		}
+		return;
+	}
+	std::shared_ptr<ParallelGroup> group = std::make_shared<ParallelGroup>();
+	group->next = 0;
+	group->remaining = count;
+	// Helpers that start after every index is claimed return without touching body.
+	std::function<void()> work = [group, count, &body]() {
+		size_t index;
+		while ((index = group->next++) < count) {
+			body(index);
+			if (--group->remaining == 0) {
+				{
+					std::lock_guard<std::mutex> guard(group->lock);
+				}
+				group->done.notify_all();
+			}
+		}
+	};
+	for (size_t helper = 0; helper < helpers; helper++) {
+		if (!submit(work, aff4::executor::PRIORITY_HIGH)) {
+			break;
+		}
+	}
+	// The caller claims any index no helper has, so only waits on invocations already running.
+	work();
+	std::unique_lock<std::mutex> guard(group->lock);
+	group->done.wait(guard, [&group]() {
+		return group->remaining == 0;
+	});
+}
+
+size_t Executor::getPendingCount() noexcept {
+	return pending;
+}
+
+size_t Executor::getThreadCount() noexcept {
+	std::lock_guard<std::mutex> guard(lock);
+	return threads;
+}
+
+size_t Executor::setThreadCount(size_t newThreads) noexcept {
+	std::unique_lock<std::mutex> guard(lock);
+	size_t oldValue = threads;
+	if (getCurrentSlot() >= 0) {
+		return oldValue;
+	}
+	threads = resolveThreads(newThreads);
+	if (!workers.empty()) {
+		stop(guard);
+		if (!stopped && (pending > 0)) {
+			start();
+		}
+	}
+	return oldValue;
+}
+
+bool Executor::setAffinity(const std::vector<uint32_t>& cpus) noexcept {
+	std::unique_lock<std::mutex> guard(lock);
+	if (getCurrentSlot() < 0) {
+		try {
+			affinity = cpus;
+		} catch (...) {
+			return false;
+		}
+		if (!workers.empty()) {
+			stop(guard);
+			if (!stopped && (pending > 0)) {
+				start();
+			}
+		}
+	}
+#if defined(__linux__) || defined(_WIN32)
+	return true;
+#else
+	return false;
+#endif
+}
+
+uint64_t Executor::getQueueLimit(aff4::executor::Priority priority) noexcept {
+	if ((priority < aff4::executor::PRIORITY_LOW) || (priority > aff4::executor::PRIORITY_HIGH)) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	return limits[priority];
+}
+
+uint64_t Executor::setQueueLimit(aff4::executor::Priority priority, uint64_t limit) noexcept {
+	if ((priority < aff4::executor::PRIORITY_LOW) || (priority > aff4::executor::PRIORITY_HIGH)) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	uint64_t oldValue = limits[priority];
+	limits[priority] = limit;
+	return oldValue;
+}
+
+aff4::executor::HostExecutor Executor::setHostExecutor(aff4::executor::HostExecutor newHost) noexcept {
+	std::lock_guard<std::mutex> guard(lock);
+	aff4::executor::HostExecutor oldValue = host;
+	host = newHost;
+	return oldValue;
+}
+
+void Executor::shutdown() noexcept {
+	std::vector<std::thread> stopping;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopped = true;
+		generation++;
+		for (size_t priority = 0; priority < PRIORITIES; priority++) {
+			queues[priority].clear();
+		}
+		for (size_t slot = 0; slot < AFF4_EXECUTOR_MAX_THREADS; slot++) {
+			std::lock_guard<std::mutex> queueGuard(workerQueues[slot].lock);
+			workerQueues[slot].tasks.clear();
+		}
+		pending = 0;
+		stopping.swap(workers);
+	}
+	available.notify_all();
+	for (std::thread& worker : stopping) {
+#if defined(_WIN32)
+		// Joining during DLL unload deadlocks on the loader lock.
+		worker.detach();
+#else
+		worker.join();
+#endif
+	}
+}
+
+bool Executor::start() noexcept {
+	if (!workers.empty()) {
+		return true;
+	}
+	if (active < threads) {
+		active = threads;
+	}
+	try {
+		while (workers.size() < threads) {
+			size_t slot = workers.size();
+			workers.emplace_back(&Executor::run, this, slot, generation.load());
+			applyAffinity(workers.back());
+		}
+	} catch (...) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Unable to start worker thread \n", __FILE__, __LINE__);
+#endif
+	}
+	return !workers.empty();
+}
+
+void Executor::stop(std::unique_lock<std::mutex>& guard) noexcept {
+	std::vector<std::thread> stopping;
+	stopping.swap(workers);
+	generation++;
+	guard.unlock();
+	available.notify_all();
+	for (std::thread& worker : stopping) {
+		worker.join();
+	}
+	guard.lock();
+	// Hand the tasks forked by the stopped workers to their successors.
+	for (size_t slot = 0; slot < AFF4_EXECUTOR_MAX_THREADS; slot++) {
+		WorkerQueue& queue = workerQueues[slot];
+		std::lock_guard<std::mutex> queueGuard(queue.lock);
+		while (!queue.tasks.empty()) {
+			try {
+				queues[aff4::executor::PRIORITY_NORMAL].push_back(std::move(queue.tasks.front()));
+			} catch (...) {
+				pending--;
+			}
+			queue.tasks.pop_front();
+		}
+	}
+}
+
+void Executor::applyAffinity(std::thread& worker) noexcept {
+	if (affinity.empty()) {
+		return;
+	}
+#if defined(__linux__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	for (uint32_t cpu : affinity) {
+		if (cpu < CPU_SETSIZE) {
+			CPU_SET(cpu, &cpus);
+		}
+	}
+	if (pthread_setaffinity_np(worker.native_handle(), sizeof(cpus), &cpus) != 0) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Unable to set worker thread affinity \n", __FILE__, __LINE__);
+#endif
+	}
+#elif defined(_WIN32)
+	DWORD_PTR mask = 0;
+	for (uint32_t cpu : affinity) {
+		if (cpu < sizeof(DWORD_PTR) * 8) {
+			mask |= ((DWORD_PTR) 1) << cpu;
+		}
+	}
+	if ((mask == 0) || (SetThreadAffinityMask(worker.native_handle(), mask) == 0)) {
+#if DEBUG
+		fprintf(aff4::getDebugOutput(), "%s[%d] : Unable to set worker thread affinity \n", __FILE__, __LINE__);
+#endif
+	}
+#else
+	(void) worker;
+#endif
+}
+
+bool Executor::take(size_t slot, std::function<void()>& task) noexcept {
+	// Own tasks, newest first.
+	{
+		WorkerQueue& queue = workerQueues[slot];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.back());
+			queue.tasks.pop_back();
+			pending--;
+			return true;
+		}
+	}
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		for (size_t priority : { aff4::executor::PRIORITY_HIGH, aff4::executor::PRIORITY_NORMAL }) {
+			if (!queues[priority].empty()) {
+				task = std::move(queues[priority].front());
+				queues[priority].pop_front();
+				pending--;
+				return true;
+			}
+		}
+	}
+	// Steal the oldest task of another worker, including those of stopped workers not yet handed on.
+	size_t workerCount = active;
+	for (size_t i = 1; i < workerCount; i++) {
+		WorkerQueue& queue = workerQueues[(slot + i) % workerCount];
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if (!queue.tasks.empty()) {
+			task = std::move(queue.tasks.front());
+			queue.tasks.pop_front();
+			pending--;
+			return true;
+		}
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	std::deque<std::function<void()>>& queue = queues[aff4::executor::PRIORITY_LOW];
+	if (!queue.empty()) {
+		task = std::move(queue.front());
+		queue.pop_front();
+		pending--;
+		return true;
+	}
+	return false;
+}
+
+void Executor::run(size_t slot, uint64_t workerGeneration) noexcept {
+	currentExecutor = this;
+	currentSlot = slot;
+	while (true) {
+		std::function<void()> task;
+		if (!take(slot, task)) {
+			std::unique_lock<std::mutex> guard(lock);
+			available.wait(guard, [this, workerGeneration]() {
+				return (generation != workerGeneration) || (pending > 0);
+			});
+			if (generation != workerGeneration) {
+				return;
+			}
+			continue;
+		}
+		try {
+			task();
+		} catch (...) {
+			// Tasks are best effort.
+		}
+		if (generation != workerGeneration) {
+			return;
+		}
+	}
+}
+
+} /* namespace util */
+} /* namespace aff4 */
@@ -0,0 +1,266 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file Executor.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Shared work-stealing worker threads for the library.
+ */
+
+#ifndef SRC_UTILS_EXECUTOR_H_
+#define SRC_UTILS_EXECUTOR_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AFF4Defaults.h"
+
+namespace aff4 {
+namespace util {
+
+/**
+ * @brief Work-stealing pool of worker threads, shared by all library features.
+ * <p>
+ * Tasks submitted from outside the pool are held in one queue per priority. Normal priority tasks submitted by a
+ * worker are held in that worker's own queue and run newest first, so forked work stays on the thread (and in the
+ * cache) that created it; idle workers steal the oldest tasks from the others. Workers take, in order: their own
+ * tasks, high priority tasks, normal priority tasks, tasks stolen from other workers, and finally low priority tasks.
+ * <p>
+ * Submitters must not depend on a task running promptly, or at all once the pool has been shut down. Callers that wait
+ * on a number of tasks should use parallel(), which runs the tasks on the calling thread if no worker is free, and so
+ * can't deadlock when called from a worker. The worker threads are started on first use.
+ * <p>
+ * Base implementation is MT-SAFE.
+ */
+class Executor {
+public:
+	/**
+	 * Create a new executor.
+	 * @param threads The number of worker threads. (0 for one per core, and at least AFF4_EXECUTOR_MIN_THREADS).
+	 */
+	Executor(size_t threads = 0) noexcept;
+	~Executor();
+
+	/**
+	 * Get the executor shared by the library.
+	 * <p>
+	 * The instance is never destroyed, so its workers are left running at exit rather than joined.
+	 * @return The library executor.
+	 */
+	static Executor& getDefault() noexcept;
+
+	/**
+	 * Queue a task to be run on a worker thread.
+	 *
+	 * @param task The task.
+	 * @param priority The priority of the task.
+	 * @return TRUE if the task was queued, FALSE if the queue is full or the executor has been shut down.
+	 */
+	bool submit(std::function<void()> task, aff4::executor::Priority priority = aff4::executor::PRIORITY_NORMAL) noexcept;
+
+	/**
+	 * Run body(0) ... body(count - 1), in parallel on the calling thread and any free worker threads, returning once
+	 * all have completed.
+	 *
+	 * @param count The number of invocations.
+	 * @param body The body to run. Must not throw.
+	 * @param maxThreads The maximum number of threads (including the caller) to use. (0 for no limit).
+	 */
+	void parallel(size_t count, const std::function<void(size_t)>& body, size_t maxThreads = 0) noexcept;
+
+	/**
+	 * Get the number of tasks queued and not yet started.
+	 * @return The number of queued tasks.
+	 */
+	size_t getPendingCount() noexcept;
+
+	/**
+	 * Get the number of worker threads.
+	 * @return The number of worker threads.
+	 */
+	size_t getThreadCount() noexcept;
+
+	/**
+	 * Set the number of worker threads, restarting the workers. Queued tasks are retained.
+	 * <p>
+	 * Ignored if called from a worker of this executor.
+	 * @param threads The number of worker threads. (0 for one per core, and at least AFF4_EXECUTOR_MIN_THREADS).
+	 * @return The old number of worker threads.
+	 */
+	size_t setThreadCount(size_t threads) noexcept;
+
+	/**
+	 * Restrict the worker threads to the given CPUs, restarting the workers. Queued tasks are retained.
+	 * <p>
+	 * Ignored if called from a worker of this executor.
+	 * @param cpus The CPU numbers the workers may run on. (empty for no restriction).
+	 * @return TRUE if thread affinity is supported on this platform.
+	 */
+	bool setAffinity(const std::vector<uint32_t>& cpus) noexcept;
+
+	/**
+	 * Get the maximum number of queued tasks of the given priority.
+	 * @param priority The priority.
+	 * @return The maximum number of queued tasks.
+	 */
+	uint64_t getQueueLimit(aff4::executor::Priority priority) noexcept;
+
+	/**
+	 * Set the maximum number of queued tasks of the given priority.
+	 * @param priority The priority.
+	 * @param limit The maximum number of queued tasks.
+	 * @return The old limit.
+	 */
+	uint64_t setQueueLimit(aff4::executor::Priority priority, uint64_t limit) noexcept;
+
+	/**
+	 * Hand all tasks to the given host executor rather than the worker threads.
+	 * @param host The host executor, or nullptr to use the worker threads.
+	 * @return The old host executor.
+	 */
+	aff4::executor::HostExecutor setHostExecutor(aff4::executor::HostExecutor host) noexcept;
+
+	/**
+	 * Discard all queued tasks, and stop the worker threads once their current tasks complete.
+	 */
+	void shutdown() noexcept;
+
+private:
+	/**
+	 * The number of task priorities.
+	 */
+	static const size_t PRIORITIES = 3;
+
+	/**
+	 * The tasks forked by a single worker.
+	 */
+	struct WorkerQueue {
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+
+	/**
+	 * Worker thread body.
+	 * @param slot The index of the worker's queue.
+	 * @param generation The generation the worker was started in. The worker exits once the generation changes.
+	 */
+	void run(size_t slot, uint64_t generation) noexcept;
+
+	/**
+	 * Take the next task for the given worker.
+	 * @param slot The index of the worker's queue.
+	 * @param task Set to the task.
+	 * @return TRUE if a task was taken.
+	 */
+	bool take(size_t slot, std::function<void()>& task) noexcept;
+
+	/**
+	 * Start the worker threads, if not running. Requires the lock.
+	 * @return TRUE if at least one worker is running.
+	 */
+	bool start() noexcept;
+
+	/**
+	 * Stop the worker threads once their current tasks complete, moving their queued tasks to the normal priority
+	 * queue.
+	 * @param guard The held lock, released while the workers stop.
+	 */
+	void stop(std::unique_lock<std::mutex>& guard) noexcept;
+
+	/**
+	 * Apply the CPU affinity to the given worker thread.
+	 * @param worker The worker thread.
+	 */
+	void applyAffinity(std::thread& worker) noexcept;
+
+	/**
+	 * Get the index of the calling thread's queue, if it is a worker of this executor.
+	 * @return The index of the queue, or -1 if not a worker of this executor.
+	 */
+	int64_t getCurrentSlot() const noexcept;
+
+	/**
+	 * Lock for the priority queues and configuration.
+	 */
+	std::mutex lock;
+	/**
+	 * Signalled when a task is queued, or the workers are stopping.
+	 */
+	std::condition_variable available;
+	/**
+	 * The queued tasks submitted from outside the pool, by priority.
+	 */
+	std::deque<std::function<void()>> queues[PRIORITIES];
+	/**
+	 * The maximum number of queued tasks, by priority.
+	 */
+	uint64_t limits[PRIORITIES];
+	/**
+	 * The per-worker queues. Allocated once, so workers can steal without the lock.
+	 */
+	std::unique_ptr<WorkerQueue[]> workerQueues;
+	/**
+	 * The worker threads.
+	 */
+	std::vector<std::thread> workers;
+	/**
+	 * The number of worker queues that may hold tasks.
+	 */
+	std::atomic<size_t> active;
+	/**
+	 * The number of queued tasks, in all queues.
+	 */
+	std::atomic<size_t> pending;
+	/**
+	 * The number of worker threads to start.
+	 */
+	size_t threads;
+	/**
+	 * Incremented each time the workers are stopped.
+	 */
+	std::atomic<uint64_t> generation;
+	/**
+	 * The CPUs the workers may run on.
+	 */
+	std::vector<uint32_t> affinity;
+	/**
+	 * The host executor, if any.
+	 */
+	aff4::executor::HostExecutor host;
+	/**
+	 * Has the executor been shut down.
+	 */
+	bool stopped;
+};
+
+} /* namespace util */
+} /* namespace aff4 */
+
+#endif /* SRC_UTILS_EXECUTOR_H_ */
@@ -0,0 +1,165 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IOScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace aff4 {
+namespace util {
+
+/**
+ * The I/O class of the calling thread.
+ */
+static thread_local aff4::io::IOClass currentClass = aff4::io::IO_NORMAL;
+
+/**
+ * Is the given value a valid I/O class?
+ * @param ioClass The value.
+ * @return TRUE if valid.
+ */
+static bool isValidClass(int ioClass) {
+	return (ioClass >= aff4::io::IO_SPECULATIVE) && (ioClass <= aff4::io::IO_INTERACTIVE);
+}
+
+IOScheduler::IOScheduler(uint32_t depth) noexcept :
+		depth(depth), inFlight(0) {
+	for (int ioClass = 0; ioClass < CLASSES; ioClass++) {
+		waiting[ioClass] = 0;
+		rates[ioClass] = 0;
+	}
+}
+
+IOScheduler& IOScheduler::getDefault() noexcept {
+	static IOScheduler scheduler;
+	return scheduler;
+}
+
+aff4::io::IOClass IOScheduler::getCurrentClass() noexcept {
+	return currentClass;
+}
+
+aff4::io::IOClass IOScheduler::setCurrentClass(aff4::io::IOClass ioClass) noexcept {
+	aff4::io::IOClass oldValue = currentClass;
+	if (isValidClass(ioClass)) {
+		currentClass = ioClass;
+	}
+	return oldValue;
+}
+
+bool IOScheduler::canAdmit(int ioClass) const noexcept {
+	// Strictly by class.
+	for (int higher = ioClass + 1; higher < CLASSES; higher++) {
+		if (waiting[higher] != 0) {
+			return false;
+		}
+	}
+	uint32_t limit = depth;
+	if (ioClass <= aff4::io::IO_BACKGROUND) {
+		// Keep the last quarter of the queue for normal and interactive reads.
+		limit = std::max<uint32_t>(1, depth - depth / 4);
+	}
+	return inFlight < limit;
+}
+
+void IOScheduler::acquire(aff4::io::IOClass ioClass, uint64_t count) noexcept {
+	if (!isValidClass(ioClass)) {
+		ioClass = aff4::io::IO_NORMAL;
+	}
+	std::unique_lock<std::mutex> guard(lock);
+	if (rates[ioClass] != 0) {
+		// Reserve the time to transfer this read, and wait for the reservation to start.
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point start = std::max(now, nextRead[ioClass]);
+		nextRead[ioClass] = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>((double) count / (double) rates[ioClass]));
+		if (start > now) {
+			guard.unlock();
+			std::this_thread::sleep_until(start);
+			guard.lock();
+		}
+	}
+	if (depth == 0) {
+		inFlight++;
+		return;
+	}
+	waiting[ioClass]++;
+	changed.wait(guard, [this, ioClass]() {
+		return (depth == 0) || canAdmit(ioClass);
+	});
+	waiting[ioClass]--;
+	inFlight++;
+	if (waiting[ioClass] == 0) {
+		// Reads of lower classes may now be admissible.
+		changed.notify_all();
+	}
+}
+
+void IOScheduler::release() noexcept {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		inFlight--;
+	}
+	changed.notify_all();
+}
+
+uint32_t IOScheduler::getWaitingCount(aff4::io::IOClass ioClass) noexcept {
+	if (!isValidClass(ioClass)) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	return waiting[ioClass];
+}
+
+uint32_t IOScheduler::getQueueDepth() noexcept {
+	std::lock_guard<std::mutex> guard(lock);
+	return depth;
+}
+
+uint32_t IOScheduler::setQueueDepth(uint32_t newDepth) noexcept {
+	uint32_t oldValue;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		oldValue = depth;
+		depth = newDepth;
+	}
+	changed.notify_all();
+	return oldValue;
+}
+
+uint64_t IOScheduler::getRateLimit(aff4::io::IOClass ioClass) noexcept {
+	if (!isValidClass(ioClass)) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	return rates[ioClass];
+}
+
+uint64_t IOScheduler::setRateLimit(aff4::io::IOClass ioClass, uint64_t bytesPerSecond) noexcept {
+	if (!isValidClass(ioClass)) {
+		return 0;
+	}
+	std::lock_guard<std::mutex> guard(lock);
+	uint64_t oldValue = rates[ioClass];
+	rates[ioClass] = bytesPerSecond;
+	nextRead[ioClass] = std::chrono::steady_clock::time_point();
+	return oldValue;
+}
+
+} /* namespace util */
+} /* namespace aff4 */
@@ -0,0 +1,173 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file IOScheduler.h
+ * @author Schatz Forensic, Ptd Ltd.
+ * @version 1.0
+ * @date 12-Sep-2017
+ * @copyright Copyright Schatz Forensic, Ptd Ltd. 2017. All Rights Reserved. This project is released under the LGPL 3.0+.
+ *
+ * @brief Priority scheduling of container reads.
+ */
+
+#ifndef SRC_UTILS_IOSCHEDULER_H_
+#define SRC_UTILS_IOSCHEDULER_H_
+
+#include "aff4config.h"
+#include "aff4.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+#include "AFF4Defaults.h"
+
+namespace aff4 {
+namespace util {
+
+/**
+ * @brief Admission control for container reads, by I/O class.
+ * <p>
+ * Reads are admitted immediately while fewer than the queue depth are in flight. Once the queue is full, waiting reads
+ * are admitted strictly by class, so an interactive read waits only for reads already in flight rather than behind
+ * queued bulk work. Speculative and background reads may not occupy the last quarter of the queue, and are split
+ * into slices by the caller so they yield to other reads between slices. Each class may be rate limited.
+ * <p>
+ * Base implementation is MT-SAFE.
+ */
+class IOScheduler {
+public:
+	/**
+	 * Create a new scheduler.
+	 * @param depth The maximum number of reads in flight. (0 to admit all reads immediately).
+	 */
+	IOScheduler(uint32_t depth = AFF4_IO_QUEUE_DEPTH) noexcept;
+
+	/**
+	 * Get the scheduler shared by all containers.
+	 * @return The library scheduler.
+	 */
+	static IOScheduler& getDefault() noexcept;
+
+	/**
+	 * Get the I/O class of the calling thread.
+	 * @return The I/O class.
+	 */
+	static aff4::io::IOClass getCurrentClass() noexcept;
+
+	/**
+	 * Set the I/O class of the calling thread.
+	 * @param ioClass The I/O class.
+	 * @return The old I/O class.
+	 */
+	static aff4::io::IOClass setCurrentClass(aff4::io::IOClass ioClass) noexcept;
+
+	/**
+	 * Wait until a read of the given class may be issued. Each call must be paired with a call to release().
+	 * @param ioClass The I/O class of the read.
+	 * @param count The number of bytes to be read.
+	 */
+	void acquire(aff4::io::IOClass ioClass, uint64_t count) noexcept;
+
+	/**
+	 * Complete a read admitted by acquire().
+	 */
+	void release() noexcept;
+
+	/**
+	 * Get the number of reads waiting to be admitted.
+	 * @param ioClass The I/O class.
+	 * @return The number of waiting reads of the class.
+	 */
+	uint32_t getWaitingCount(aff4::io::IOClass ioClass) noexcept;
+
+	/**
+	 * Get the maximum number of reads in flight.
+	 * @return The maximum number of reads in flight. (0 if scheduling is disabled).
+	 */
+	uint32_t getQueueDepth() noexcept;
+
+	/**
+	 * Set the maximum number of reads in flight.
+	 * @param depth The maximum number of reads in flight. (0 to admit all reads immediately).
+	 * @return The old setting.
+	 */
+	uint32_t setQueueDepth(uint32_t depth) noexcept;
+
+	/**
+	 * Get the rate limit of the given class.
+	 * @param ioClass The I/O class.
+	 * @return The rate limit in bytes per second. (0 for no limit).
+	 */
+	uint64_t getRateLimit(aff4::io::IOClass ioClass) noexcept;
+
+	/**
+	 * Set the rate limit of the given class.
+	 * @param ioClass The I/O class.
+	 * @param bytesPerSecond The rate limit in bytes per second. (0 for no limit).
+	 * @return The old setting.
+	 */
+	uint64_t setRateLimit(aff4::io::IOClass ioClass, uint64_t bytesPerSecond) noexcept;
+
+private:
+	/**
+	 * The number of I/O classes.
+	 */
+	static const int CLASSES = 4;
+
+	/**
+	 * Can a read of the given class be admitted now? Requires the lock.
+	 * @param ioClass The I/O class.
+	 * @return TRUE if the read can be admitted.
+	 */
+	bool canAdmit(int ioClass) const noexcept;
+
+	/**
+	 * Lock for the scheduler state.
+	 */
+	std::mutex lock;
+	/**
+	 * Signalled when a read completes, or the configuration changes.
+	 */
+	std::condition_variable changed;
+	/**
+	 * The maximum number of reads in flight.
+	 */
+	uint32_t depth;
+	/**
+	 * The number of reads in flight.
+	 */
+	uint32_t inFlight;
+	/**
+	 * The number of reads waiting, by class.
+	 */
+	uint32_t waiting[CLASSES];
+	/**
+	 * The rate limit in bytes per second, by class.
+	 */
+	uint64_t rates[CLASSES];
+	/**
+	 * The time each class may next issue a read, under its rate limit.
+	 */
+	std::chrono::steady_clock::time_point nextRead[CLASSES];
+};
+
+} /* namespace util */
+} /* namespace aff4 */
+
+#endif /* SRC_UTILS_IOSCHEDULER_H_ */
@@ -18,8 +18,16 @@
 #include "Zip.h"
 #include "ZipStream.h"
 #include <inttypes.h>
+#include <algorithm>
 #include "PortableEndian.h"
 #include "StringUtil.h"
+#include "IOScheduler.h"
+
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 /*
  * Handle some of the macOS vs Linux
@@ -56,7 +64,8 @@ ZipEntry::~ZipEntry() {
 }
 
 Zip::Zip(const std::string& filename) :
-		filename(filename), fileHandle(0), length(0), closed(true), comment("") {
+		filename(filename), fileHandle(0), length(0), closed(true), readers(0), arena(std::make_shared<aff4::util::Arena>()),
+		comment("") {
 
 #ifndef _WIN32
 	/*
@@ -111,6 +120,10 @@ Zip::~Zip() {
 
 void Zip::close() noexcept {
 	if (!closed.exchange(true)) {
+		// Reads already past the closed check finish before the handle is closed (and may be reused).
+		while (readers.load() != 0) {
+			std::this_thread::yield();
+		}
 		entries.clear();
 #ifndef _WIN32
 		/*
@@ -175,6 +188,76 @@ std::shared_ptr<IAFF4Stream> Zip::getStream(const std::string& segmentName) noex
 	return s;
 }
 
+std::shared_ptr<const uint8_t> Zip::mapSegment(const std::string& segmentName, uint64_t& size) noexcept {
+	size = 0;
+	if (closed) {
+		errno = EBADF;
+		return nullptr;
+	}
+	std::shared_ptr<ZipEntry> entry;
+	for (const std::shared_ptr<ZipEntry>& e : entries) {
+		if (e->getSegmentName().compare(segmentName) == 0) {
+			entry = e;
+			break;
+		}
+	}
+	if (entry == nullptr) {
+		errno = ENOENT;
+		return nullptr;
+	}
+	if ((entry->getCompressionMethod() != ZIP_STORED) || (entry->getLength() == 0)
+			|| (entry->getLength() != entry->getCompressedLength()) || (entry->getOffset() + entry->getLength() > length)) {
+		errno = EINVAL;
+		return nullptr;
+	}
+#ifndef _WIN32
+	/*
+	* POSIX based systems.
+	*/
+	uint64_t pageSize = (uint64_t) ::sysconf(_SC_PAGESIZE);
+	uint64_t start = entry->getOffset() - (entry->getOffset() % pageSize);
+	size_t mappedLength = (size_t) (entry->getOffset() + entry->getLength() - start);
+	void* base = ::mmap(nullptr, mappedLength, PROT_READ, MAP_SHARED, fileHandle, (off_t) start);
+	if (base == MAP_FAILED) {
+#if DEBUG
+		fprintf( aff4::getDebugOutput(), "%s[%d] : Zip Map Segment: %s FAILED\n", __FILE__, __LINE__, segmentName.c_str());
+#endif
+		return nullptr;
+	}
+	std::shared_ptr<const uint8_t> mapping(static_cast<const uint8_t*>(base) + (entry->getOffset() - start),
+			[base, mappedLength](const uint8_t*) {
+				::munmap(base, mappedLength);
+			});
+#else
+	/*
+	* Windows based systems
+	*/
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	uint64_t start = entry->getOffset() - (entry->getOffset() % info.dwAllocationGranularity);
+	SIZE_T mappedLength = (SIZE_T) (entry->getOffset() + entry->getLength() - start);
+	HANDLE fileMapping = CreateFileMapping(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (fileMapping == NULL) {
+		errno = EIO;
+		return nullptr;
+	}
+	void* base = MapViewOfFile(fileMapping, FILE_MAP_READ, (DWORD) (start >> 32), (DWORD) (start & 0xffffffffL),
+			mappedLength);
+	// The view holds a reference to the mapping.
+	CloseHandle(fileMapping);
+	if (base == NULL) {
+		errno = EIO;
+		return nullptr;
+	}
+	std::shared_ptr<const uint8_t> mapping(static_cast<const uint8_t*>(base) + (entry->getOffset() - start),
+			[base](const uint8_t*) {
+				UnmapViewOfFile(base);
+			});
+#endif
+	size = entry->getLength();
+	return mapping;
+}
+
 void Zip::parseCD() noexcept {
 	errno = EIO;
 	structs::EndCentralDirectory* endCD = nullptr;
@@ -338,9 +421,9 @@ void Zip::parseCD() noexcept {
 		zipEntry.dataOffset += sizeof(fileHeader) + le16toh(fileHeader.file_name_length) + le16toh(fileHeader.extra_field_len);
 
 		// We should have all our information.
-		std::shared_ptr<ZipEntry> segment(
-				new ZipEntry(segmentName, zipEntry.headerOffset, zipEntry.dataOffset, zipEntry.size, zipEntry.csize,
-						le16toh(entry.compression_method)));
+		std::shared_ptr<ZipEntry> segment = std::allocate_shared<ZipEntry>(aff4::util::ArenaAllocator<ZipEntry>(arena),
+				segmentName, (uint64_t) zipEntry.headerOffset, (uint64_t) zipEntry.dataOffset, (uint64_t) zipEntry.size,
+				(uint64_t) zipEntry.csize, (int) le16toh(entry.compression_method));
 
 		entries.push_back(segment);
 
@@ -356,6 +439,10 @@ int64_t Zip::fileRead(void *buf, uint64_t count, uint64_t offset) noexcept {
 #if DEBUG
 	fprintf(aff4::getDebugOutput(), "%s[%d] : Reading %" PRIx64 " : %" PRIx64 " \n", __FILE__, __LINE__, offset, count);
 #endif
+	if (closed) {
+		errno = EBADF;
+		return -1;
+	}
 	if ((count == 0) || (buf == nullptr)) {
 		return 0;
 	}
@@ -367,6 +454,39 @@ int64_t Zip::fileRead(void *buf, uint64_t count, uint64_t offset) noexcept {
 	if (offset + count > length) {
 		count -= (offset + count) - length;
 	}
+	aff4::util::IOScheduler& scheduler = aff4::util::IOScheduler::getDefault();
+	aff4::io::IOClass ioClass = aff4::util::IOScheduler::getCurrentClass();
+	// Bulk reads are issued in slices, so other reads are admitted between them.
+	uint64_t slice = (ioClass <= aff4::io::IO_BACKGROUND) ? AFF4_IO_SLICE_SIZE : count;
+	uint8_t* buffer = static_cast<uint8_t*>(buf);
+	int64_t actualRead = 0;
+	while (count > 0) {
+		uint64_t toRead = std::min<uint64_t>(count, slice);
+		scheduler.acquire(ioClass, toRead);
+		int64_t res = -1;
+		readers++;
+		if (!closed) {
+			res = readDirect(buffer, toRead, offset);
+		} else {
+			errno = EBADF;
+		}
+		readers--;
+		scheduler.release();
+		if (res <= 0) {
+			return (actualRead > 0) ? actualRead : res;
+		}
+		actualRead += res;
+		if ((uint64_t) res < toRead) {
+			break;
+		}
+		buffer += res;
+		offset += res;
+		count -= res;
+	}
+	return actualRead;
+}
+
+int64_t Zip::readDirect(void *buf, uint64_t count, uint64_t offset) noexcept {
 #ifndef _WIN32
 	/*
 	* POSIX based systems.
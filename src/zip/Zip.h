@@ -41,6 +41,9 @@
 #endif
 #include <fcntl.h>
 #include <cerrno>
+#include <memory>
+
+#include "Arena.h"
 
 namespace aff4 {
 /**
@@ -343,12 +346,26 @@ public:
 	 */
 	LIBAFF4_API std::shared_ptr<IAFF4Stream> getStream(const std::string& segmentName) noexcept;
 
+	/**
+	 * Map the contents of the given stored (uncompressed) segment read only into memory.
+	 * <p>
+	 * The mapping remains valid while the returned pointer (or a copy) is held, even after the zip file is closed.
+	 * @param segmentName The name of the segment to map
+	 * @param size Set to the length of the segment.
+	 * @return The segment contents, or NULL if the segment doesn't exist, is compressed, is empty or can't be mapped.
+	 * (consult errno).
+	 */
+	LIBAFF4_API std::shared_ptr<const uint8_t> mapSegment(const std::string& segmentName, uint64_t& size) noexcept;
+
 	/**
 	 * Read a number of bytes from the stream starting at offset
+	 * <p>
+	 * The read is scheduled by the I/O class of the calling thread (see aff4::io::setIOClass()).
 	 * @param buf A pointer to the buffer to read to.
 	 * @param count The number of bytes to read
 	 * @param offset The offset from the start of the stream.
-	 * @return The number of bytes read. (0 indicates nothing read, or -1 indicates error.
+	 * @return The number of bytes read. (0 indicates nothing read, or -1 indicates error, with errno EBADF if the
+	 * zip file has been closed).
 	 */
 	LIBAFF4_API int64_t fileRead(void *buf, uint64_t count, uint64_t offset) noexcept;
 private:
@@ -372,6 +389,14 @@ private:
 	 * Is this container closed.
 	 */
 	std::atomic<bool> closed;
+	/**
+	 * The number of reads in progress on the file handle. close() waits for these.
+	 */
+	std::atomic<uint32_t> readers;
+	/**
+	 * Arena holding the zip entries. (Shared with the entries, so released with the last entry).
+	 */
+	std::shared_ptr<aff4::util::Arena> arena;
 	/**
 	 * vector of all entries.
 	 */
@@ -385,6 +410,15 @@ private:
 	 * Attempt to find the Central Directory, and construct a vector of ZipEntry.
 	 */
 	LIBAFF4_API_LOCAL void parseCD() noexcept;
+
+	/**
+	 * Read a number of bytes from the underlying file starting at offset, without scheduling.
+	 * @param buf A pointer to the buffer to read to.
+	 * @param count The number of bytes to read. Must not extend past the end of the file.
+	 * @param offset The offset from the start of the file.
+	 * @return The number of bytes read. (0 indicates nothing read, or -1 indicates error.
+	 */
+	LIBAFF4_API_LOCAL int64_t readDirect(void *buf, uint64_t count, uint64_t offset) noexcept;
 };
 
 } /* namespace zip */
@@ -16,6 +16,7 @@
  */
 
 #include "ZipStream.h"
+#include <algorithm>
 #include <inttypes.h>
 
 namespace aff4 {
@@ -96,6 +97,14 @@ std::vector<aff4::rdf::RDFValue> ZipSegmentStream::getProperty(aff4::Lexicon res
 	return AFF4Resource::getProperty(resource);
 }
 
+std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> ZipSegmentStream::getPropertyMap() noexcept {
+	return AFF4Resource::getPropertyMap();
+}
+
+std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> ZipSegmentStream::getPropertyValues(aff4::Lexicon resource) noexcept {
+	return AFF4Resource::getPropertyValues(resource);
+}
+
 /*
  * Compressed stream helpers.
  */
@@ -109,30 +118,10 @@ int64_t ZipSegmentStream::readCompressed(void *buf, uint64_t count, uint64_t off
 		/*
 		 * Poor mans implementation - decompress the whole lot and copy result buffer.
 		 */
-		std::shared_ptr<uint8_t> buffer(new uint8_t[entry->getCompressedLength()], std::default_delete<uint8_t[]>());
-		std::shared_ptr<uint8_t> decompbuffer(new uint8_t[entry->getLength()], std::default_delete<uint8_t[]>());
-		int64_t read = container->fileRead(buffer.get(), entry->getCompressedLength(), entry->getOffset());
-		if (read == -1) {
-			return read;
-		}
-		// Decompress.
-		z_stream zstream;
-		::memset(&zstream, 0, sizeof(zstream));
-		zstream.next_in = buffer.get();
-		zstream.avail_in = read;
-		zstream.next_out = decompbuffer.get();
-		zstream.avail_out = entry->getLength();
-
-		if (inflateInit2(&zstream, -15) != Z_OK) {
+		std::unique_ptr<uint8_t[]> decompbuffer = inflateSegment();
+		if (decompbuffer == nullptr) {
 			return -1;
 		}
-
-		if (inflate(&zstream, Z_FINISH) != Z_STREAM_END) {
-			inflateEnd(&zstream);
-			return -1;
-		}
-
-		inflateEnd(&zstream);
 		// copy data to result buffer.
 		::memcpy(buf, decompbuffer.get() + offset, count);
 		return count;
@@ -148,5 +137,132 @@ int64_t ZipSegmentStream::readCompressed(void *buf, uint64_t count, uint64_t off
 	return -1;
 }
 
+std::unique_ptr<uint8_t[]> ZipSegmentStream::inflateSegment() noexcept {
+	if (size() > ZIP_WHOLE_STREAM) {
+		return nullptr;
+	}
+	std::unique_ptr<uint8_t[]> buffer(new uint8_t[entry->getCompressedLength()]);
+	std::unique_ptr<uint8_t[]> decompbuffer(new uint8_t[entry->getLength()]);
+	int64_t read = container->fileRead(buffer.get(), entry->getCompressedLength(), entry->getOffset());
+	if (read == -1) {
+		return nullptr;
+	}
+	// Decompress.
+	z_stream zstream;
+	::memset(&zstream, 0, sizeof(zstream));
+	zstream.next_in = buffer.get();
+	zstream.avail_in = read;
+	zstream.next_out = decompbuffer.get();
+	zstream.avail_out = entry->getLength();
+
+	if (inflateInit2(&zstream, -15) != Z_OK) {
+		return nullptr;
+	}
+
+	if (inflate(&zstream, Z_FINISH) != Z_STREAM_END) {
+		inflateEnd(&zstream);
+		return nullptr;
+	}
+
+	inflateEnd(&zstream);
+	return decompbuffer;
+}
+
+int64_t ZipSegmentStream::readv(aff4::ReadRequest* requests, size_t count) noexcept {
+	if (closed || (entry.get() == nullptr)) {
+		for (size_t i = 0; i < count; i++) {
+			requests[i].result = -1;
+		}
+		errno = EPERM;
+		return -1;
+	}
+	uint64_t length = size();
+	// The ranges within the stream, in offset order.
+	std::vector<size_t> order;
+	for (size_t i = 0; i < count; i++) {
+		requests[i].result = 0;
+		if ((requests[i].offset < length) && (requests[i].count > 0)) {
+			order.push_back(i);
+		}
+	}
+	std::sort(order.begin(), order.end(), [requests](size_t a, size_t b) {
+		return requests[a].offset < requests[b].offset;
+	});
+	auto rangeLength = [requests, length](size_t i) {
+		return std::min<uint64_t>(requests[i].count, length - requests[i].offset);
+	};
+
+	bool failed = false;
+	if (entry->getCompressionMethod() == ZIP_DEFLATE) {
+		// Decompress once for all ranges.
+		std::unique_ptr<uint8_t[]> decompbuffer = order.empty() ? nullptr : inflateSegment();
+		for (size_t i : order) {
+			if (decompbuffer == nullptr) {
+				requests[i].result = -1;
+				failed = true;
+				continue;
+			}
+			::memcpy(requests[i].buffer, decompbuffer.get() + requests[i].offset, rangeLength(i));
+			requests[i].result = rangeLength(i);
+		}
+	} else if (entry->getCompressionMethod() == ZIP_STORED) {
+		size_t first = 0;
+		while (first < order.size()) {
+			// Extend the span over the following ranges that are close enough to read together.
+			uint64_t start = requests[order[first]].offset;
+			uint64_t end = start + rangeLength(order[first]);
+			size_t last = first;
+			while (last + 1 < order.size()) {
+				size_t next = order[last + 1];
+				uint64_t nextEnd = std::max<uint64_t>(end, requests[next].offset + rangeLength(next));
+				if ((requests[next].offset > end + AFF4_READV_COALESCE_GAP) || (nextEnd - start > AFF4_READV_MAX_RUN)) {
+					break;
+				}
+				end = nextEnd;
+				last++;
+			}
+			int64_t read;
+			if (first == last) {
+				read = container->fileRead(requests[order[first]].buffer, end - start, start + entry->getOffset());
+			} else {
+				std::unique_ptr<uint8_t[]> span(new uint8_t[end - start]);
+				read = container->fileRead(span.get(), end - start, start + entry->getOffset());
+				for (size_t r = first; (r <= last) && (read > 0); r++) {
+					size_t i = order[r];
+					uint64_t delta = requests[i].offset - start;
+					if ((uint64_t) read > delta) {
+						::memcpy(requests[i].buffer, span.get() + delta, std::min<uint64_t>(rangeLength(i), read - delta));
+					}
+				}
+			}
+			for (size_t r = first; r <= last; r++) {
+				size_t i = order[r];
+				uint64_t delta = requests[i].offset - start;
+				if (read < 0) {
+					requests[i].result = -1;
+					failed = true;
+				} else if ((uint64_t) read > delta) {
+					requests[i].result = std::min<uint64_t>(rangeLength(i), read - delta);
+				}
+			}
+			first = last + 1;
+		}
+	} else {
+		// We don't yet support other compression methods.
+		for (size_t i : order) {
+			requests[i].result = -1;
+		}
+		errno = EPERM;
+		return -1;
+	}
+	int64_t actualRead = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (requests[i].result > 0) {
+			actualRead += requests[i].result;
+		}
+	}
+	return failed ? -1 : actualRead;
+}
+
 } /* namespace zip */
 } /* namespace aff4 */
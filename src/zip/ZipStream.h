@@ -63,6 +63,17 @@ public:
 	uint64_t size() noexcept;
 	void close() noexcept;
 	int64_t read(void *buf, uint64_t count, uint64_t offset) noexcept;
+	/**
+	 * Read a number of ranges in a single call.
+	 * <p>
+	 * Stored segments coalesce ranges that are close together into a single container read. Compressed segments
+	 * are decompressed once for all ranges.
+	 *
+	 * @param requests The ranges to read. The result of each is set.
+	 * @param count The number of ranges.
+	 * @return The total number of bytes read, or -1 if any range failed to read.
+	 */
+	int64_t readv(aff4::ReadRequest* requests, size_t count) noexcept;
 
 	/*
 	 * From AFF4Resource.
@@ -71,6 +82,8 @@ public:
 	aff4::Lexicon getBaseType() noexcept;
 	std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() noexcept;
 	std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) noexcept;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> getPropertyMap() noexcept;
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> getPropertyValues(aff4::Lexicon resource) noexcept;
 
 private:
 	/**
@@ -95,6 +108,12 @@ private:
 	 */
 	int64_t readCompressed(void *buf, uint64_t count, uint64_t offset) noexcept;
 
+	/**
+	 * Decompress the whole of a compressed stream.
+	 * @return The decompressed stream, or NULL on error or if the stream is too large.
+	 */
+	std::unique_ptr<uint8_t[]> inflateSegment() noexcept;
+
 };
 
 } /* namespace zip */
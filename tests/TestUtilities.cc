@@ -16,6 +16,7 @@
  */
 
 #include "TestUtilities.h"
+#include <string.h>
 
 #if defined _WIN32 && defined _MSC_VER  
 
@@ -203,5 +204,39 @@ std::string sha1sum(int handle, uint64_t toRead, uint64_t readSize) {
 	return result;
 }
 
+void testReadv(std::shared_ptr<IAFF4Stream> stream, size_t ranges, uint64_t maxRange) {
+	uint64_t size = stream->size();
+	std::unique_ptr<uint8_t[]> vectored(new uint8_t[ranges * maxRange]);
+	std::unique_ptr<uint8_t[]> expected(new uint8_t[ranges * maxRange]);
+	::memset(vectored.get(), 0, ranges * maxRange);
+	::memset(expected.get(), 0, ranges * maxRange);
+
+	// Scattered ranges from a fixed seed. The last two are past the end, and straddle the end.
+	std::vector<aff4::ReadRequest> requests;
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	for (size_t i = 0; i < ranges; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint64_t offset = (seed >> 16) % size;
+		uint64_t count = 1 + ((seed >> 8) % maxRange);
+		if (i == ranges - 2) {
+			offset = size + 1;
+		} else if (i == ranges - 1) {
+			offset = size - std::min<uint64_t>(size, maxRange / 2);
+		}
+		aff4::ReadRequest request = { vectored.get() + (i * maxRange), count, offset, 0 };
+		requests.push_back(request);
+	}
+	int64_t total = stream->readv(requests.data(), requests.size());
+
+	int64_t expectedTotal = 0;
+	for (size_t i = 0; i < ranges; i++) {
+		int64_t res = stream->read(expected.get() + (i * maxRange), requests[i].count, requests[i].offset);
+		CPPUNIT_ASSERT_EQUAL(res, requests[i].result);
+		expectedTotal += res;
+	}
+	CPPUNIT_ASSERT_EQUAL(expectedTotal, total);
+	CPPUNIT_ASSERT(::memcmp(vectored.get(), expected.get(), ranges * maxRange) == 0);
+}
+
 } /* namespace test */
 } /* namespace aff4 */
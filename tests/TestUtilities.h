@@ -92,6 +92,14 @@ std::string sha1sum(std::shared_ptr<IAFF4Stream> stream, uint64_t readSize = 128
  */
 std::string sha1sum(int handle, uint64_t toRead, uint64_t readSize = 128 * 1024);
 
+/**
+ * Test that a vectored read of scattered, unordered and overlapping ranges matches reading each range in turn.
+ * @param stream The stream to read.
+ * @param ranges The number of ranges.
+ * @param maxRange The maximum length of each range.
+ */
+void testReadv(std::shared_ptr<IAFF4Stream> stream, size_t ranges, uint64_t maxRange);
+
 } /* namespace test */
 } /* namespace aff4 */
 
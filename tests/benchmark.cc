@@ -0,0 +1,646 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Micro benchmarks for libaff4 internals.
+ *
+ * Usage: benchmark [name] [count]
+ */
+
+#include "../aff4config.h"
+#include "../src/aff4.h"
+#include "../src/rdf/Model.h"
+#include "../src/stream/struct/MapIndex.h"
+#include "../src/stream/struct/ChunkStore.h"
+#include "../src/codec/CompressionCodec.h"
+#include "../src/stream/ImageStream.h"
+#include "../src/container/AFF4ZipContainer.h"
+#include "../src/zip/Zip.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <snappy.h>
+
+/*
+ * Heap accounting. Each allocation carries a header with its size, so that live bytes can be reported.
+ */
+
+static std::atomic<int64_t> heapBytes(0);
+static std::atomic<int64_t> heapBlocks(0);
+static std::atomic<int64_t> heapAllocations(0);
+
+static const size_t HEAP_HEADER = 16;
+
+void* operator new(size_t size) {
+	void* p = ::malloc(size + HEAP_HEADER);
+	if (p == nullptr) {
+		throw std::bad_alloc();
+	}
+	*static_cast<size_t*>(p) = size;
+	heapBytes += size;
+	heapBlocks++;
+	heapAllocations++;
+	return static_cast<char*>(p) + HEAP_HEADER;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (ptr == nullptr) {
+		return;
+	}
+	void* p = static_cast<char*>(ptr) - HEAP_HEADER;
+	heapBytes -= *static_cast<size_t*>(p);
+	heapBlocks--;
+	::free(p);
+}
+
+void* operator new[](size_t size) {
+	return operator new(size);
+}
+
+void operator delete[](void* ptr) noexcept {
+	operator delete(ptr);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return operator new(size);
+	} catch (...) {
+		return nullptr;
+	}
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+	return operator new(size, std::nothrow);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+	operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+	operator delete(ptr);
+}
+
+/**
+ * Create a turtle document, similar in shape to a large logical image container.
+ * @param count The number of image streams to describe.
+ * @return The turtle document.
+ */
+static std::string createTurtle(uint64_t count) {
+	std::string turtle = "@prefix aff4: <http://aff4.org/Schema#> .\n"
+			"@prefix xsd: <http://www.w3.org/2001/XMLSchema#> .\n\n";
+	const std::string volume = "<aff4://685e15cc-d0fb-4dbc-ba47-48117fc77044>";
+	char buffer[1024];
+	for (uint64_t i = 0; i < count; i++) {
+		snprintf(buffer, sizeof(buffer), "<aff4://c215ba20-5648-4209-a793-%012" PRIx64 ">\n"
+				"    a aff4:ImageStream ;\n"
+				"    aff4:stored %s ;\n"
+				"    aff4:target <aff4://cf853d0b-5589-4c7c-8358-%012" PRIx64 "> ;\n"
+				"    aff4:size \"%" PRIu64 "\"^^xsd:long ;\n"
+				"    aff4:chunkSize 32768 ;\n"
+				"    aff4:chunksInSegment 2048 ;\n"
+				"    aff4:compressionMethod <https://code.google.com/p/snappy/> ;\n"
+				"    aff4:hash \"%040" PRIx64 "\"^^aff4:SHA1 ;\n"
+				"    aff4:tool \"Evimetry 3.0.0\" .\n\n", i, volume.c_str(), i % 16, (i + 1) * 4096, i);
+		turtle += buffer;
+	}
+	return turtle;
+}
+
+/**
+ * Report the heap footprint of an RDF model built from a large turtle document.
+ */
+static int benchmarkModelFootprint(uint64_t count) {
+	std::string turtle = createTurtle(count);
+
+	int64_t baseline = heapBytes;
+	int64_t baselineBlocks = heapBlocks;
+	auto start = std::chrono::high_resolution_clock::now();
+	std::unique_ptr<aff4::rdf::Model> model(new aff4::rdf::Model());
+	if (model->parse(reinterpret_cast<unsigned char*>(&turtle[0]), turtle.size()) != 0) {
+		fprintf(stderr, "Failed to parse the turtle document\n");
+		return 1;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	int64_t bytes = heapBytes - baseline;
+	int64_t blocks = heapBlocks - baselineBlocks;
+	uint64_t statements = count * 9;
+
+	printf("model-footprint\n");
+	printf("  sizeof(RDFValue)   : %zu\n", sizeof(aff4::rdf::RDFValue));
+	printf("  turtle bytes       : %zu\n", turtle.size());
+	printf("  statements         : %" PRIu64 "\n", statements);
+	printf("  interned strings   : %zu\n", model->getInternedStringCount());
+	printf("  heap bytes         : %" PRId64 "\n", bytes);
+	printf("  heap blocks        : %" PRId64 "\n", blocks);
+	printf("  bytes / statement  : %.1f\n", (double) bytes / statements);
+	printf("  parse time (ms)    : %.1f\n",
+			std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0);
+	return 0;
+}
+
+/**
+ * Report the cost of opening, reading the metadata of and closing a small container many times.
+ * (Run from the top level source directory).
+ */
+static int benchmarkContainerOpenClose(uint64_t count) {
+	const std::string filename = "tests/resources/Base-Linear.aff4";
+	int64_t open = 0;
+	int64_t close = 0;
+	int64_t blocks = heapBlocks;
+	int64_t allocations = heapAllocations;
+	for (uint64_t i = 0; i < count; i++) {
+		auto start = std::chrono::high_resolution_clock::now();
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+		if ((container == nullptr) || (container->getImages().size() != 1)) {
+			fprintf(stderr, "Failed to open %s\n", filename.c_str());
+			return 1;
+		}
+		auto mid = std::chrono::high_resolution_clock::now();
+		container->close();
+		container.reset();
+		auto end = std::chrono::high_resolution_clock::now();
+		open += std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count();
+		close += std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count();
+	}
+	printf("container-open-close\n");
+	printf("  containers         : %" PRIu64 "\n", count);
+	printf("  open (us)          : %.1f\n", open / 1000.0 / count);
+	printf("  close (us)         : %.1f\n", close / 1000.0 / count);
+	printf("  heap allocations   : %.1f per container\n", (double) (heapAllocations - allocations) / count);
+	printf("  leaked heap blocks : %" PRId64 "\n", heapBlocks - blocks);
+	return 0;
+}
+
+/**
+ * Time the entry lookup of a synthetic map of count 4K entries, comparing the tree map with the flat index.
+ */
+static int benchmarkMapLookup(uint64_t count) {
+	const uint64_t lookups = 10000000;
+	std::map<uint64_t, aff4::stream::structs::MapEntryPoint> tree;
+	std::vector<aff4::stream::structs::MapEntryPoint> entries;
+	entries.reserve(count);
+	for (uint64_t i = 0; i < count; i++) {
+		aff4::stream::structs::MapEntryPoint entry;
+		entry.offset = i * 4096;
+		entry.length = 4096;
+		entry.streamOffset = (count - i) * 4096;
+		entry.streamID = (uint32_t) (i % 3);
+		entries.push_back(entry);
+		tree[entry.offset] = entry;
+	}
+	aff4::stream::structs::MapIndex index(std::move(entries));
+
+	std::vector<uint64_t> targets(lookups);
+	std::mt19937_64 random(42);
+	for (uint64_t i = 0; i < lookups; i++) {
+		targets[i] = random() % (count * 4096);
+	}
+
+	uint64_t check = 0;
+	// std::map lower_bound, as MapStream did before.
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint64_t target : targets) {
+		auto it = tree.lower_bound(target);
+		if ((it == tree.end()) || (it->second.offset > target)) {
+			it--;
+		}
+		check += it->second.streamOffset;
+	}
+	auto mid = std::chrono::high_resolution_clock::now();
+	// Flat index.
+	for (uint64_t target : targets) {
+		check -= index.get(index.find(target)).streamOffset;
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	double treeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count();
+	double indexTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count();
+
+	// Sequential 64K reads, with and without the cursor.
+	uint64_t steps = std::min<uint64_t>(lookups, count * 4096 / 65536);
+	start = std::chrono::high_resolution_clock::now();
+	for (uint64_t i = 0; i < steps; i++) {
+		for (uint64_t offset = i * 65536; offset < (i + 1) * 65536; offset += 4096) {
+			check += index.get(index.find(offset)).length;
+		}
+	}
+	mid = std::chrono::high_resolution_clock::now();
+	size_t cursor = 0;
+	for (uint64_t i = 0; i < steps; i++) {
+		for (uint64_t offset = i * 65536; offset < (i + 1) * 65536; offset += 4096) {
+			cursor = index.find(offset, cursor);
+			check -= index.get(cursor).length;
+		}
+	}
+	end = std::chrono::high_resolution_clock::now();
+	double searchTime = std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count();
+	double cursorTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count();
+
+	printf("map-lookup\n");
+	printf("  entries            : %" PRIu64 "\n", count);
+	printf("  std::map (ns)      : %.1f per random lookup\n", treeTime / lookups);
+	printf("  MapIndex (ns)      : %.1f per random lookup\n", indexTime / lookups);
+	printf("  search (ns)        : %.1f per sequential lookup\n", searchTime / (steps * 16));
+	printf("  cursor (ns)        : %.1f per sequential lookup\n", cursorTime / (steps * 16));
+	if (check != 0) {
+		fprintf(stderr, "Lookup mismatch\n");
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Time reading the 256 4K pages of 1MB of an aff4:ImageStream (as a MapStream does for a map of 4K entries), with a
+ * call per page, and batched as a single scatter/gather read. The pages are read whole, and then only their first 64
+ * bytes to show the per call overhead. (Run from the top level source directory).
+ */
+static int benchmarkImageScatterRead(uint64_t count) {
+	const std::string filename = "tests/resources/Base-Linear.aff4";
+	const std::string resource = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	const uint64_t pageSize = 4096;
+	const uint64_t pages = 256;
+	std::unique_ptr<uint8_t[]> buffer(new uint8_t[pageSize * pages]);
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+	if (container == nullptr) {
+		fprintf(stderr, "Failed to open %s\n", filename.c_str());
+		return 1;
+	}
+	std::shared_ptr<aff4::stream::ImageStream> stream = std::dynamic_pointer_cast<aff4::stream::ImageStream>(
+			static_cast<aff4::container::AFF4ZipContainer*>(container.get())->getImageStream(resource));
+	if (stream == nullptr) {
+		fprintf(stderr, "Failed to open %s\n", resource.c_str());
+		return 1;
+	}
+	printf("image-scatter-read\n");
+	printf("  pages              : %" PRIu64 " x %" PRIu64 "\n", pages, pageSize);
+	for (uint64_t rangeSize : { pageSize, (uint64_t) 64 }) {
+		std::vector<aff4::stream::ScatterRead> reads;
+		for (uint64_t i = 0; i < pages; i++) {
+			aff4::stream::ScatterRead read = { buffer.get() + (i * pageSize), rangeSize, i * pageSize };
+			reads.push_back(read);
+		}
+		// Warm the chunk cache.
+		stream->readScatter(reads.data(), reads.size());
+
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint64_t i = 0; i < count; i++) {
+			for (const aff4::stream::ScatterRead& read : reads) {
+				if (stream->read(read.buffer, read.count, read.offset) <= 0) {
+					return 1;
+				}
+			}
+		}
+		auto mid = std::chrono::high_resolution_clock::now();
+		for (uint64_t i = 0; i < count; i++) {
+			if (stream->readScatter(reads.data(), reads.size()) <= 0) {
+				return 1;
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double single = std::chrono::duration_cast<std::chrono::nanoseconds>(mid - start).count();
+		double batched = std::chrono::duration_cast<std::chrono::nanoseconds>(end - mid).count();
+		printf("  %4" PRIu64 " bytes per page\n", rangeSize);
+		printf("    per page (ns)    : %.1f\n", single / count / pages);
+		printf("    batched (ns)     : %.1f\n", batched / count / pages);
+	}
+	return 0;
+}
+
+/**
+ * Warm 512 byte sector reads within a few chunks of an aff4:ImageStream. (Run from the top level source directory).
+ */
+static int benchmarkImageSectorRead(uint64_t count) {
+	const std::string filename = "tests/resources/Base-Linear.aff4";
+	const std::string resource = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	const uint64_t sectorSize = 512;
+	const uint64_t region = 4 * AFF4_DEFAULT_CHUNK_SIZE;
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+	if (container == nullptr) {
+		fprintf(stderr, "Failed to open %s\n", filename.c_str());
+		return 1;
+	}
+	std::shared_ptr<aff4::IAFF4Stream> stream =
+			static_cast<aff4::container::AFF4ZipContainer*>(container.get())->getImageStream(resource);
+	if (stream == nullptr) {
+		fprintf(stderr, "Failed to open %s\n", resource.c_str());
+		return 1;
+	}
+	uint8_t sector[sectorSize];
+	std::vector<uint64_t> offsets;
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	for (uint64_t i = 0; i < 1024; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		offsets.push_back(((seed >> 16) % (region / sectorSize)) * sectorSize);
+	}
+	for (uint64_t offset : offsets) {
+		stream->read(sector, sectorSize, offset);
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	for (uint64_t i = 0; i < count; i++) {
+		for (uint64_t offset : offsets) {
+			if (stream->read(sector, sectorSize, offset) <= 0) {
+				return 1;
+			}
+		}
+	}
+	auto end = std::chrono::high_resolution_clock::now();
+	double elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	printf("image-sector-read\n");
+	printf("  sectors            : %zu x %" PRIu64 " in %" PRIu64 " bytes\n", offsets.size(), sectorSize, region);
+	printf("  per read (ns)      : %.1f\n", elapsed / count / offsets.size());
+	return 0;
+}
+
+/**
+ * Cold reads of scattered 512 byte records from an aff4:ImageStream, read one at a time and with a single vectored
+ * read. A new container is opened for each pass, so every chunk is loaded. (Run from the top level source directory).
+ */
+static int benchmarkImageReadv(uint64_t count) {
+	const std::string filename = "tests/resources/Base-Linear.aff4";
+	const std::string resource = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	const uint64_t records = 1024;
+	const uint64_t recordSize = 512;
+	std::unique_ptr<uint8_t[]> buffer(new uint8_t[records * recordSize]);
+	double single = 0;
+	double vectored = 0;
+	for (uint64_t pass = 0; pass < count * 2; pass++) {
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+		if (container == nullptr) {
+			fprintf(stderr, "Failed to open %s\n", filename.c_str());
+			return 1;
+		}
+		std::shared_ptr<aff4::IAFF4Stream> stream =
+				static_cast<aff4::container::AFF4ZipContainer*>(container.get())->getImageStream(resource);
+		// Records scattered over the image, from a fixed seed.
+		std::vector<aff4::ReadRequest> requests;
+		uint64_t seed = 0x2545F4914F6CDD1DULL;
+		for (uint64_t i = 0; i < records; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			uint64_t offset = ((seed >> 16) % (stream->size() / recordSize)) * recordSize;
+			aff4::ReadRequest request = { buffer.get() + (i * recordSize), recordSize, offset, 0 };
+			requests.push_back(request);
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+		if ((pass & 1) == 0) {
+			for (const aff4::ReadRequest& request : requests) {
+				if (stream->read(request.buffer, request.count, request.offset) <= 0) {
+					return 1;
+				}
+			}
+		} else if (stream->readv(requests.data(), requests.size()) <= 0) {
+			return 1;
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		double elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		(((pass & 1) == 0) ? single : vectored) += elapsed;
+	}
+	printf("image-readv\n");
+	printf("  records            : %" PRIu64 " x %" PRIu64 "\n", records, recordSize);
+	printf("  single reads (ms)  : %.2f\n", single / count / 1000000);
+	printf("  vectored read (ms) : %.2f\n", vectored / count / 1000000);
+	return 0;
+}
+
+/**
+ * Random 4 KiB reads over a working set larger than the decompressed chunk cache, with and without the compressed
+ * chunk cache behind it. (Run from the top level source directory).
+ */
+static int benchmarkImageCompressedCache(uint64_t count) {
+	const std::string filename = "tests/resources/Base-Linear.aff4";
+	const std::string resource = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	const uint64_t readSize = 4096;
+	const uint64_t region = 96 * AFF4_DEFAULT_CHUNK_SIZE;
+	uint8_t buffer[readSize];
+	std::vector<uint64_t> offsets;
+	uint64_t seed = 0x2545F4914F6CDD1DULL;
+	for (uint64_t i = 0; i < 1024; i++) {
+		seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+		offsets.push_back(((seed >> 16) % (region / readSize)) * readSize);
+	}
+	double elapsed[2] = { 0, 0 };
+	uint64_t cacheSize = aff4::stream::setImageStreamCacheSize(2 * 1024 * 1024);
+	uint64_t compressedCacheSize = aff4::stream::getImageStreamCompressedCacheSize();
+	for (int tier = 0; tier < 2; tier++) {
+		aff4::stream::setImageStreamCompressedCacheSize((tier == 0) ? 0 : 8 * 1024 * 1024);
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+		if (container == nullptr) {
+			fprintf(stderr, "Failed to open %s\n", filename.c_str());
+			return 1;
+		}
+		std::shared_ptr<aff4::IAFF4Stream> stream =
+				static_cast<aff4::container::AFF4ZipContainer*>(container.get())->getImageStream(resource);
+		if (stream == nullptr) {
+			fprintf(stderr, "Failed to open %s\n", resource.c_str());
+			return 1;
+		}
+		for (uint64_t offset : offsets) {
+			stream->read(buffer, readSize, offset);
+		}
+		auto start = std::chrono::high_resolution_clock::now();
+		for (uint64_t i = 0; i < count; i++) {
+			for (uint64_t offset : offsets) {
+				if (stream->read(buffer, readSize, offset) <= 0) {
+					return 1;
+				}
+			}
+		}
+		auto end = std::chrono::high_resolution_clock::now();
+		elapsed[tier] = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+	}
+	aff4::stream::setImageStreamCacheSize(cacheSize);
+	aff4::stream::setImageStreamCompressedCacheSize(compressedCacheSize);
+	printf("image-compressed-cache\n");
+	printf("  reads              : %zu x %" PRIu64 " in %" PRIu64 " bytes\n", offsets.size(), readSize, region);
+	printf("  uncached (us)      : %.2f\n", elapsed[0] / count / offsets.size() / 1000);
+	printf("  compressed (us)    : %.2f\n", elapsed[1] / count / offsets.size() / 1000);
+	return 0;
+}
+
+/**
+ * Decompression of the chunks of a sparse image (zero and filler chunks) as the chunk loader does, with and without
+ * the content addressed chunk store, and the heap held by the decompressed chunks.
+ */
+static int benchmarkChunkSharing(uint64_t count) {
+	const uint32_t chunkSize = AFF4_DEFAULT_CHUNK_SIZE;
+	const size_t chunks = 1024;
+	std::shared_ptr<aff4::codec::CompressionCodec> codec = aff4::codec::getCodec(
+			aff4::Lexicon::AFF4_IMAGE_COMPRESSION_SNAPPY, chunkSize);
+	// Zero, 0xFF and repeated text filler chunks.
+	std::vector<std::string> payloads;
+	std::string chunk(chunkSize, '\0');
+	for (int pattern = 0; pattern < 3; pattern++) {
+		for (uint32_t i = 0; i < chunkSize; i++) {
+			chunk[i] = (pattern == 0) ? 0 : (pattern == 1) ? (char) 0xFF : "FILLER"[i % 6];
+		}
+		std::string payload;
+		snappy::Compress(chunk.data(), chunk.size(), &payload);
+		payloads.push_back(payload);
+	}
+	aff4::stream::structs::ChunkStore& store = aff4::stream::structs::ChunkStore::getDefault();
+	const std::string codecResource = codec->getResourceID();
+	double elapsed[2] = { 0, 0 };
+	int64_t held[2] = { 0, 0 };
+	for (int sharing = 0; sharing < 2; sharing++) {
+		for (uint64_t pass = 0; pass < count; pass++) {
+			int64_t baseline = heapBytes;
+			std::vector<std::shared_ptr<uint8_t>> cached(chunks);
+			auto start = std::chrono::high_resolution_clock::now();
+			for (size_t i = 0; i < chunks; i++) {
+				std::string& payload = payloads[(i * 7) % payloads.size()];
+				uint8_t* source = reinterpret_cast<uint8_t*>(&payload[0]);
+				if (sharing != 0) {
+					cached[i] = store.find(codecResource, chunkSize, source, (uint32_t) payload.size());
+					if (cached[i] != nullptr) {
+						continue;
+					}
+				}
+				std::shared_ptr<uint8_t> dest(new uint8_t[chunkSize], std::default_delete<uint8_t[]>());
+				codec->decompress(source, payload.size(), dest.get(), chunkSize);
+				if (sharing != 0) {
+					dest = store.share(codecResource, chunkSize, source, (uint32_t) payload.size(), dest);
+				}
+				cached[i] = dest;
+			}
+			auto end = std::chrono::high_resolution_clock::now();
+			elapsed[sharing] += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+			held[sharing] += heapBytes - baseline;
+		}
+	}
+	printf("chunk-sharing\n");
+	printf("  chunks             : %zu x %" PRIu32 " from %zu distinct\n", chunks, chunkSize, payloads.size());
+	printf("  unshared (us)      : %.1f\n", elapsed[0] / count / 1000);
+	printf("  shared (us)        : %.1f\n", elapsed[1] / count / 1000);
+	printf("  unshared heap bytes: %" PRId64 "\n", held[0] / (int64_t) count);
+	printf("  shared heap bytes  : %" PRId64 "\n", held[1] / (int64_t) count);
+	return 0;
+}
+
+/**
+ * Latency of small interactive container reads while background threads read the container in bulk, with and without
+ * the I/O scheduler. (Run from the top level source directory).
+ */
+static int benchmarkIOPriority(uint64_t count) {
+	const std::string filename = "tests/resources/Base-Linear.aff4";
+	const size_t bulkThreads = 8;
+	const uint64_t bulkSize = 1024 * 1024;
+	const uint64_t readSize = 4096;
+	const uint64_t length = 3 * 1024 * 1024;
+	aff4::zip::Zip zip(filename);
+	if (zip.getEntries().empty()) {
+		fprintf(stderr, "Failed to open %s\n", filename.c_str());
+		return 1;
+	}
+	printf("io-priority\n");
+	printf("  %" PRIu64 " byte reads, %zu threads reading %" PRIu64 " bytes\n", readSize, bulkThreads, bulkSize);
+	uint32_t oldDepth = aff4::io::getQueueDepth();
+	for (uint32_t depth : { 0, 4 }) {
+		aff4::io::setQueueDepth(depth);
+		std::atomic<bool> running(true);
+		std::vector<std::thread> bulk;
+		for (size_t t = 0; t < bulkThreads; t++) {
+			bulk.emplace_back([&zip, &running, bulkSize, length]() {
+				aff4::io::ScopedIOClass scope(aff4::io::IO_BACKGROUND);
+				std::unique_ptr<uint8_t[]> buffer(new uint8_t[bulkSize]);
+				uint64_t offset = 0;
+				while (running) {
+					zip.fileRead(buffer.get(), bulkSize, offset);
+					offset = (offset + bulkSize) % (length - bulkSize);
+				}
+			});
+		}
+		aff4::io::ScopedIOClass scope(aff4::io::IO_INTERACTIVE);
+		uint8_t buffer[readSize];
+		std::vector<double> latencies;
+		uint64_t seed = 0x2545F4914F6CDD1DULL;
+		for (uint64_t i = 0; i < count; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			uint64_t offset = ((seed >> 16) % (length / readSize)) * readSize;
+			auto start = std::chrono::high_resolution_clock::now();
+			zip.fileRead(buffer, readSize, offset);
+			auto end = std::chrono::high_resolution_clock::now();
+			latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+		}
+		running = false;
+		for (std::thread& thread : bulk) {
+			thread.join();
+		}
+		std::sort(latencies.begin(), latencies.end());
+		printf("  %s\n", (depth == 0) ? "unscheduled" : "scheduled");
+		printf("    p50 (us)         : %.1f\n", latencies[latencies.size() / 2] / 1000);
+		printf("    p99 (us)         : %.1f\n", latencies[latencies.size() * 99 / 100] / 1000);
+	}
+	aff4::io::setQueueDepth(oldDepth);
+	return 0;
+}
+
+/**
+ * Available benchmarks, and their default iteration count.
+ */
+static const std::map<std::string, std::pair<std::function<int(uint64_t)>, uint64_t>> benchmarks = { //
+		{ "model-footprint", { benchmarkModelFootprint, 100000 } }, //
+		{ "container-open-close", { benchmarkContainerOpenClose, 2000 } }, //
+		{ "chunk-sharing", { benchmarkChunkSharing, 100 } }, //
+		{ "map-lookup", { benchmarkMapLookup, 10000000 } }, //
+		{ "image-scatter-read", { benchmarkImageScatterRead, 20000 } }, //
+		{ "image-sector-read", { benchmarkImageSectorRead, 2000 } }, //
+		{ "image-readv", { benchmarkImageReadv, 20 } }, //
+		{ "image-compressed-cache", { benchmarkImageCompressedCache, 20 } }, //
+		{ "io-priority", { benchmarkIOPriority, 2000 } }, //
+		};
+
+int main(int argc, char** argv) {
+	std::string name = (argc > 1) ? argv[1] : "";
+	uint64_t count = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 0;
+	int res = 0;
+	bool found = false;
+	for (auto it = benchmarks.begin(); it != benchmarks.end(); it++) {
+		if (name.empty() || (name == it->first)) {
+			found = true;
+			res |= it->second.first((count != 0) ? count : it->second.second);
+		}
+	}
+	if (!found) {
+		fprintf(stderr, "Usage: %s [name] [count]\nBenchmarks:\n", argv[0]);
+		for (auto it = benchmarks.begin(); it != benchmarks.end(); it++) {
+			fprintf(stderr, "  %s\n", it->first.c_str());
+		}
+		return 1;
+	}
+	return res;
+}
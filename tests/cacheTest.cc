@@ -29,7 +29,18 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include "aff4.h"
 #include "aff4-c.h"
 #include "utils\Cache.h"
+#include "utils\Arena.h"
+#include "utils\Executor.h"
+#include "utils\IOScheduler.h"
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <functional>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 #define CPPUNIT_ASSERT Assert::IsTrue
 #define CPPUNIT_ASSERT_EQUAL Assert::AreEqual
@@ -237,6 +248,286 @@ TEST_METHOD(testLongBuffer) {
 	}
 }
 
+TEST_METHOD(testArena) {
+
+	std::shared_ptr<aff4::util::Arena> arena = std::make_shared<aff4::util::Arena>(1024);
+	CPPUNIT_ASSERT_EQUAL((size_t)0, arena->getReserved());
+
+	// Allocations honour the requested alignment.
+	for (size_t i = 1; i < 64; i++) {
+		void* ptr = arena->allocate(i, 8);
+		CPPUNIT_ASSERT_EQUAL((uintptr_t)0, reinterpret_cast<uintptr_t>(ptr) & 7);
+	}
+	CPPUNIT_ASSERT(arena->getReserved() >= arena->getAllocated());
+
+	// Requests larger than a block get their own block.
+	uint8_t* large = static_cast<uint8_t*>(arena->allocate(64 * 1024));
+	memset(large, 0xff, 64 * 1024);
+	CPPUNIT_ASSERT(arena->getReserved() >= 64 * 1024);
+
+	// STL containers built with the allocator keep the arena alive.
+	typedef std::map<uint64_t, uint64_t, std::less<uint64_t>, aff4::util::ArenaAllocator<std::pair<const uint64_t, uint64_t>>> ArenaMap;
+	std::unique_ptr<ArenaMap> m(new ArenaMap(std::less<uint64_t>(), aff4::util::ArenaAllocator<std::pair<const uint64_t, uint64_t>>(arena)));
+	std::weak_ptr<aff4::util::Arena> weak = arena;
+	arena.reset();
+	for (uint64_t i = 0; i < 1000; i++) {
+		(*m)[i] = i * 2;
+	}
+	CPPUNIT_ASSERT_EQUAL((size_t)1000, m->size());
+	CPPUNIT_ASSERT_EQUAL((uint64_t)1998, m->at(999));
+	CPPUNIT_ASSERT(!weak.expired());
+	m.reset();
+	CPPUNIT_ASSERT(weak.expired());
+}
+
+TEST_METHOD(testPreload) {
+
+	IntLoader loader;
+	std::function<uint32_t(uint8_t)> loaderFunc = std::bind(&IntLoader::load, &loader, std::placeholders::_1);
+	std::unique_ptr<aff4::util::cache<uint8_t, uint32_t>> c(new aff4::util::cache<uint8_t, uint32_t>(4, loaderFunc));
+
+	c->preload(1);
+	CPPUNIT_ASSERT(c->exists(1));
+	CPPUNIT_ASSERT_EQUAL((uint64_t)1, c->size());
+	// Already held, so not reloaded.
+	c->preload(1);
+	CPPUNIT_ASSERT_EQUAL((uint64_t)1, c->size());
+	CPPUNIT_ASSERT_EQUAL((uint32_t)3, c->get(1));
+
+	// Preloaded entries are subject to the same eviction.
+	for (uint8_t i = 10; i < 20; i++) {
+		c->preload(i);
+	}
+	CPPUNIT_ASSERT_EQUAL((uint64_t)4, c->size());
+	CPPUNIT_ASSERT(!c->exists(1));
+	CPPUNIT_ASSERT(c->exists(19));
+}
+
+TEST_METHOD(testWeighted) {
+
+	IntLoader loader;
+	std::function<uint32_t(uint8_t)> loaderFunc = std::bind(&IntLoader::load, &loader, std::placeholders::_1);
+	// Each element weighs its value.
+	std::unique_ptr<aff4::util::cache<uint8_t, uint32_t>> c(new aff4::util::cache<uint8_t, uint32_t>(10, loaderFunc,
+			[](const uint32_t& value) { return (uint64_t) value; }));
+
+	c->insert(1, 4);
+	c->insert(2, 4);
+	CPPUNIT_ASSERT_EQUAL((uint64_t)8, c->getWeight());
+	// Over the budget, so the least recently used is dropped.
+	c->insert(3, 4);
+	CPPUNIT_ASSERT_EQUAL((uint64_t)8, c->getWeight());
+	CPPUNIT_ASSERT(!c->exists(1));
+
+	// find() does not load missing elements, and marks held elements as used.
+	uint32_t value = 0;
+	CPPUNIT_ASSERT(!c->find(1, value));
+	CPPUNIT_ASSERT(!c->exists(1));
+	CPPUNIT_ASSERT(c->find(2, value));
+	CPPUNIT_ASSERT_EQUAL((uint32_t)4, value);
+	c->insert(4, 3);
+	CPPUNIT_ASSERT(c->exists(2));
+	CPPUNIT_ASSERT(!c->exists(3));
+
+	// Heavier than the budget, but still held as the most recent.
+	c->insert(5, 20);
+	CPPUNIT_ASSERT_EQUAL((uint64_t)1, c->size());
+	CPPUNIT_ASSERT_EQUAL((uint64_t)20, c->getWeight());
+	c->evict(5);
+	CPPUNIT_ASSERT_EQUAL((uint64_t)0, c->getWeight());
+}
+
+TEST_METHOD(testExecutor) {
+
+	std::unique_ptr<aff4::util::Executor> executor(new aff4::util::Executor(1));
+	CPPUNIT_ASSERT_EQUAL((size_t)0, executor->getPendingCount());
+	CPPUNIT_ASSERT_EQUAL((size_t)1, executor->getThreadCount());
+
+	// Hold the only worker, so queued tasks run by priority.
+	std::promise<void> started;
+	std::promise<void> release;
+	std::shared_future<void> released = release.get_future().share();
+	CPPUNIT_ASSERT(executor->submit([&started, released]() {
+		started.set_value();
+		released.wait();
+	}));
+	started.get_future().wait();
+
+	std::mutex orderLock;
+	std::vector<int> order;
+	std::promise<void> done;
+	std::function<void(int)> record = [&orderLock, &order, &done](int value) {
+		std::lock_guard<std::mutex> guard(orderLock);
+		order.push_back(value);
+		if (order.size() == 4) {
+			done.set_value();
+		}
+	};
+	CPPUNIT_ASSERT_EQUAL((uint64_t)AFF4_EXECUTOR_LOW_QUEUE_SIZE, executor->setQueueLimit(aff4::executor::PRIORITY_LOW, 1));
+	CPPUNIT_ASSERT(executor->submit([&record]() { record(0); }, aff4::executor::PRIORITY_LOW));
+	// The low priority queue is full.
+	CPPUNIT_ASSERT(!executor->submit([&record]() { record(0); }, aff4::executor::PRIORITY_LOW));
+	CPPUNIT_ASSERT(executor->submit([&record]() { record(1); }, aff4::executor::PRIORITY_NORMAL));
+	CPPUNIT_ASSERT(executor->submit([&record]() { record(2); }, aff4::executor::PRIORITY_HIGH));
+	CPPUNIT_ASSERT(executor->submit([&record]() { record(3); }, aff4::executor::PRIORITY_HIGH));
+	CPPUNIT_ASSERT_EQUAL((size_t)4, executor->getPendingCount());
+	release.set_value();
+	done.get_future().wait();
+	CPPUNIT_ASSERT_EQUAL(2, order[0]);
+	CPPUNIT_ASSERT_EQUAL(3, order[1]);
+	CPPUNIT_ASSERT_EQUAL(1, order[2]);
+	CPPUNIT_ASSERT_EQUAL(0, order[3]);
+
+	// The running thread's I/O class is restored, even if the task throws.
+	std::function<void()> hosted;
+	executor->setHostExecutor([&hosted](std::function<void()> task, aff4::executor::Priority priority) {
+		(void)priority;
+		hosted = task;
+	});
+	int taskClass = -1;
+	CPPUNIT_ASSERT(executor->submit([&taskClass]() {
+		taskClass = (int)aff4::io::getIOClass();
+		throw std::runtime_error("task failed");
+	}, aff4::executor::PRIORITY_LOW));
+	executor->setHostExecutor(nullptr);
+	bool thrown = false;
+	try {
+		hosted();
+	} catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	CPPUNIT_ASSERT(thrown);
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_SPECULATIVE, taskClass);
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_NORMAL, (int)aff4::io::getIOClass());
+
+	// Once shut down, tasks are refused.
+	executor->shutdown();
+	CPPUNIT_ASSERT(!executor->submit([]() {}));
+}
+
+TEST_METHOD(testExecutorParallel) {
+
+	std::unique_ptr<aff4::util::Executor> executor(new aff4::util::Executor(2));
+
+	std::vector<std::atomic<int>> counts(100);
+	for (std::atomic<int>& count : counts) {
+		count = 0;
+	}
+	executor->parallel(counts.size(), [&counts](size_t i) {
+		counts[i]++;
+	});
+	for (std::atomic<int>& count : counts) {
+		CPPUNIT_ASSERT_EQUAL(1, count.load());
+	}
+
+	// Nested on every worker, which must not deadlock waiting on each other.
+	std::atomic<int> total(0);
+	std::atomic<int> outstanding(4);
+	std::promise<void> done;
+	aff4::util::Executor* pool = executor.get();
+	for (int task = 0; task < 4; task++) {
+		CPPUNIT_ASSERT(executor->submit([pool, &total, &outstanding, &done]() {
+			pool->parallel(16, [pool, &total](size_t) {
+				pool->parallel(4, [&total](size_t) {
+					total++;
+				});
+			});
+			if (--outstanding == 0) {
+				done.set_value();
+			}
+		}));
+	}
+	done.get_future().wait();
+	CPPUNIT_ASSERT_EQUAL(4 * 16 * 4, total.load());
+
+	// Restarting the workers keeps queued work.
+	CPPUNIT_ASSERT_EQUAL((size_t)2, executor->setThreadCount(3));
+	CPPUNIT_ASSERT_EQUAL((size_t)3, executor->getThreadCount());
+	std::promise<void> ran;
+	CPPUNIT_ASSERT(executor->submit([&ran]() { ran.set_value(); }));
+	ran.get_future().wait();
+#if defined(__linux__) || defined(_WIN32)
+	CPPUNIT_ASSERT(executor->setAffinity(std::vector<uint32_t> { 0 }));
+#endif
+	total = 0;
+	executor->parallel(8, [&total](size_t) {
+		total++;
+	});
+	CPPUNIT_ASSERT_EQUAL(8, total.load());
+
+	// A host executor runs all tasks.
+	std::atomic<int> hosted(0);
+	executor->setHostExecutor([&hosted](std::function<void()> task, aff4::executor::Priority priority) {
+		(void)priority;
+		hosted++;
+		std::thread(task).detach();
+	});
+	std::promise<void> hostRan;
+	CPPUNIT_ASSERT(executor->submit([&hostRan]() { hostRan.set_value(); }, aff4::executor::PRIORITY_LOW));
+	hostRan.get_future().wait();
+	total = 0;
+	executor->parallel(8, [&total](size_t) {
+		total++;
+	});
+	CPPUNIT_ASSERT_EQUAL(8, total.load());
+	CPPUNIT_ASSERT(hosted.load() >= 2);
+	executor->setHostExecutor(nullptr);
+}
+
+TEST_METHOD(testIOScheduler) {
+
+	std::unique_ptr<aff4::util::IOScheduler> scheduler(new aff4::util::IOScheduler(1));
+	CPPUNIT_ASSERT_EQUAL((uint32_t)1, scheduler->getQueueDepth());
+
+	// Fill the queue, then queue a speculative read ahead of an interactive one.
+	scheduler->acquire(aff4::io::IO_NORMAL, 4096);
+	std::mutex orderLock;
+	std::vector<int> order;
+	std::function<void(aff4::io::IOClass)> read = [&scheduler, &orderLock, &order](aff4::io::IOClass ioClass) {
+		scheduler->acquire(ioClass, 4096);
+		{
+			std::lock_guard<std::mutex> guard(orderLock);
+			order.push_back((int) ioClass);
+		}
+		scheduler->release();
+	};
+	std::thread speculative(read, aff4::io::IO_SPECULATIVE);
+	while (scheduler->getWaitingCount(aff4::io::IO_SPECULATIVE) == 0) {
+		std::this_thread::yield();
+	}
+	std::thread interactive(read, aff4::io::IO_INTERACTIVE);
+	while (scheduler->getWaitingCount(aff4::io::IO_INTERACTIVE) == 0) {
+		std::this_thread::yield();
+	}
+	scheduler->release();
+	speculative.join();
+	interactive.join();
+	CPPUNIT_ASSERT_EQUAL((size_t)2, order.size());
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_INTERACTIVE, order[0]);
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_SPECULATIVE, order[1]);
+
+	// Rate limited reads are spaced by their size.
+	CPPUNIT_ASSERT_EQUAL((uint64_t)0, scheduler->setRateLimit(aff4::io::IO_BACKGROUND, 1024 * 1024));
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 3; i++) {
+		scheduler->acquire(aff4::io::IO_BACKGROUND, 128 * 1024);
+		scheduler->release();
+	}
+	std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+	CPPUNIT_ASSERT(elapsed >= std::chrono::milliseconds(200));
+	CPPUNIT_ASSERT_EQUAL((uint64_t)1024 * 1024, scheduler->setRateLimit(aff4::io::IO_BACKGROUND, 0));
+
+	// The I/O class is per thread.
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_NORMAL, (int)aff4::io::setIOClass(aff4::io::IO_INTERACTIVE));
+	int otherClass = -1;
+	std::thread other([&otherClass]() {
+		otherClass = (int)aff4::io::getIOClass();
+	});
+	other.join();
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_NORMAL, otherClass);
+	CPPUNIT_ASSERT_EQUAL((int)aff4::io::IO_INTERACTIVE, (int)aff4::io::setIOClass(aff4::io::IO_NORMAL));
+}
+
 #if defined _WIN32 && defined _MSC_VER 
 
 	};
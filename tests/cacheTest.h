@@ -23,19 +23,35 @@
 #include "../aff4config.h"
 #include "../src/aff4.h"
 #include "../src/utils/Cache.h"
+#include "../src/utils/Arena.h"
+#include "../src/utils/Executor.h"
+#include "../src/utils/IOScheduler.h"
 
 #include "TestUtilities.h"
 
 #include <inttypes.h>
 #include <string.h>
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <mutex>
 #include <memory>
+#include <map>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
 class cacheTest: public CPPUNIT_NS::TestFixture {
 CPPUNIT_TEST_SUITE(cacheTest);
 
 	CPPUNIT_TEST(testIntInt);
 	CPPUNIT_TEST(testLongBuffer);
+	CPPUNIT_TEST(testArena);
+	CPPUNIT_TEST(testPreload);
+	CPPUNIT_TEST(testWeighted);
+	CPPUNIT_TEST(testExecutor);
+	CPPUNIT_TEST(testExecutorParallel);
+	CPPUNIT_TEST(testIOScheduler);
 
 	CPPUNIT_TEST_SUITE_END()
 	;
@@ -49,6 +65,12 @@ public:
 private:
 	void testIntInt();
 	void testLongBuffer();
+	void testArena();
+	void testPreload();
+	void testWeighted();
+	void testExecutor();
+	void testExecutorParallel();
+	void testIOScheduler();
 
 };
 
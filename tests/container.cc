@@ -33,6 +33,7 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include "TestUtilities.h"
 
 #include <inttypes.h>
+#include <string.h>
 
 #define CPPUNIT_ASSERT Assert::IsTrue
 #define CPPUNIT_ASSERT_EQUAL Assert::AreEqual
@@ -159,6 +160,46 @@ TEST_METHOD(testZipLinear) {
 	container.close();
 }
 
+TEST_METHOD(testZipSegmentReadv) {
+	std::string filename(UNITTEST_BASE_PATH "tests/resources/Base-Linear.aff4");
+	aff4::zip::Zip container(filename);
+
+	// Stored segment; nearby ranges are coalesced into a single read.
+	std::string resource = "aff4%3A%2F%2Ffcbfdce7-4488-4677-abf6-08bc931e195b/map";
+	std::shared_ptr<aff4::IAFF4Stream> stream = container.getStream(resource);
+	CPPUNIT_ASSERT(stream != nullptr);
+	aff4::test::testReadv(stream, 200, 512);
+	aff4::test::testReadv(stream, 8, 64 * 1024);
+
+	stream->close();
+	aff4::ReadRequest request = { nullptr, 1, 0, 0 };
+	CPPUNIT_ASSERT_EQUAL((int64_t) -1, stream->readv(&request, 1));
+	CPPUNIT_ASSERT_EQUAL((int64_t) -1, request.result);
+}
+
+TEST_METHOD(testZipFileReadIOClass) {
+	std::string filename(UNITTEST_BASE_PATH "tests/resources/Base-Linear.aff4");
+	aff4::zip::Zip container(filename);
+
+	// Speculative and background reads are sliced, but return the same content.
+	uint64_t length = 3 * AFF4_IO_SLICE_SIZE + 17;
+	std::unique_ptr<uint8_t[]> expected(new uint8_t[length]);
+	std::unique_ptr<uint8_t[]> actual(new uint8_t[length]);
+	CPPUNIT_ASSERT_EQUAL((int64_t) length, container.fileRead(expected.get(), length, 5));
+	for (aff4::io::IOClass ioClass : { aff4::io::IO_SPECULATIVE, aff4::io::IO_BACKGROUND, aff4::io::IO_INTERACTIVE }) {
+		aff4::io::ScopedIOClass scope(ioClass);
+		CPPUNIT_ASSERT_EQUAL((int) ioClass, (int) aff4::io::getIOClass());
+		memset(actual.get(), 0, length);
+		CPPUNIT_ASSERT_EQUAL((int64_t) length, container.fileRead(actual.get(), length, 5));
+		CPPUNIT_ASSERT(memcmp(expected.get(), actual.get(), length) == 0);
+	}
+	CPPUNIT_ASSERT_EQUAL((int) aff4::io::IO_NORMAL, (int) aff4::io::getIOClass());
+
+	// Reads past the end are truncated, whatever the class.
+	aff4::io::ScopedIOClass scope(aff4::io::IO_SPECULATIVE);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 3177529 - 3000000, container.fileRead(actual.get(), length, 3000000));
+}
+
 TEST_METHOD(testZipSegmentRead) {
 	std::string filename(UNITTEST_BASE_PATH "tests/resources/Base-Linear.aff4");
 	aff4::zip::Zip container(filename);
@@ -519,6 +560,216 @@ TEST_METHOD(testContainerImageStreamContents) {
 	testStreamContents(con->getSegment(res), streamSHA1);
 }
 
+TEST_METHOD(testContainerModelIndex) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+	CPPUNIT_ASSERT(container != nullptr);
+	aff4::container::AFF4ZipContainer* con = static_cast<aff4::container::AFF4ZipContainer*>(container.get());
+	std::shared_ptr<aff4::rdf::Model> model = con->getRDFModel();
+	CPPUNIT_ASSERT(model != nullptr);
+
+	const std::string image = "aff4://cf853d0b-5589-4c7c-8358-2ca1572b87eb";
+	const std::string map = "aff4://fcbfdce7-4488-4677-abf6-08bc931e195b";
+	const std::string stream = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+
+	const std::vector<std::string>& images = model->getResourcesOfType(aff4::Lexicon::AFF4_IMAGE_TYPE);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, images.size());
+	CPPUNIT_ASSERT_EQUAL(image, images[0]);
+	CPPUNIT_ASSERT(model->getResourcesOfType(aff4::Lexicon::AFF4_CONTIGUOUS_IMAGE_TYPE) == images);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, model->getResourcesOfType(aff4::Lexicon::AFF4_MAP_TYPE).size());
+	CPPUNIT_ASSERT_EQUAL(map, model->getResourcesOfType(aff4::Lexicon::AFF4_MAP_TYPE)[0]);
+	CPPUNIT_ASSERT(model->getResourcesOfType(aff4::Lexicon::AFF4_MEMORY_IMAGE_TYPE).empty());
+
+	CPPUNIT_ASSERT(model->isResourceOfType(stream, aff4::Lexicon::AFF4_IMAGESTREAM_TYPE));
+	CPPUNIT_ASSERT(!model->isResourceOfType(stream, aff4::Lexicon::AFF4_MAP_TYPE));
+	CPPUNIT_ASSERT(!model->isResourceOfType("aff4://missing", aff4::Lexicon::AFF4_MAP_TYPE));
+
+	// All objects are stored in this container, in sorted order.
+	const std::vector<std::string>& stored = model->getResourcesWithProperty(aff4::Lexicon::AFF4_STORED, resource);
+	CPPUNIT_ASSERT_EQUAL((size_t) 7, stored.size());
+	CPPUNIT_ASSERT(std::is_sorted(stored.begin(), stored.end()));
+	CPPUNIT_ASSERT(std::binary_search(stored.begin(), stored.end(), stream));
+
+	// Case details, both case notes, timestamps and the map all target the image.
+	const std::vector<std::string>& targets = model->getResourcesWithProperty(aff4::Lexicon::AFF4_TARGET, image);
+	CPPUNIT_ASSERT_EQUAL((size_t) 5, targets.size());
+	CPPUNIT_ASSERT(model->getResourcesWithProperty(aff4::Lexicon::AFF4_TARGET, "aff4://missing").empty());
+}
+
+TEST_METHOD(testContainerLazyMetadata) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+	CPPUNIT_ASSERT(container != nullptr);
+	aff4::container::AFF4ZipContainer* con = static_cast<aff4::container::AFF4ZipContainer*>(container.get());
+
+	// Opening, resource ID and raw segment access should not parse the RDF model.
+	CPPUNIT_ASSERT(!con->isMetadataLoaded());
+	CPPUNIT_ASSERT_EQUAL(resource, container->getResourceID());
+	std::shared_ptr<aff4::IAFF4Stream> segment = con->getSegment("information.turtle");
+	CPPUNIT_ASSERT(segment != nullptr);
+	CPPUNIT_ASSERT(!con->isMetadataLoaded());
+
+	// Any metadata query loads the model.
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, images.size());
+	CPPUNIT_ASSERT(con->isMetadataLoaded());
+	CPPUNIT_ASSERT(!container->getProperty(aff4::Lexicon::AFF4_TYPE).empty());
+	CPPUNIT_ASSERT(con->getRDFModel() != nullptr);
+}
+
+TEST_METHOD(testContainerSharedProperties) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+	CPPUNIT_ASSERT(container != nullptr);
+	aff4::container::AFF4ZipContainer* con = static_cast<aff4::container::AFF4ZipContainer*>(container.get());
+
+	const std::string stream = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	std::shared_ptr<aff4::IAFF4Stream> s1 = con->getImageStream(stream);
+	std::shared_ptr<aff4::IAFF4Stream> s2 = con->getImageStream(stream);
+	CPPUNIT_ASSERT(s1 != nullptr);
+	CPPUNIT_ASSERT(s2 != nullptr);
+
+	// Both streams share the model's properties, rather than holding copies.
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties = s1->getPropertyMap();
+	CPPUNIT_ASSERT(properties == s2->getPropertyMap());
+	CPPUNIT_ASSERT(*properties == s1->getProperties());
+	CPPUNIT_ASSERT(s1->getPropertyValues(aff4::Lexicon::AFF4_SIZE).get() == s2->getPropertyValues(aff4::Lexicon::AFF4_SIZE).get());
+	CPPUNIT_ASSERT(*s1->getPropertyValues(aff4::Lexicon::AFF4_SIZE) == s1->getProperty(aff4::Lexicon::AFF4_SIZE));
+	CPPUNIT_ASSERT(s1->getPropertyValues(aff4::Lexicon::AFF4_CASE_NAME)->empty());
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_IMAGESTREAM_TYPE, s1->getBaseType());
+}
+
+TEST_METHOD(testResourceDefaultPropertyViews) {
+	// A resource implementing only the original interface gets the read only views by default.
+	class Resource: public aff4::IAFF4Resource {
+	public:
+		std::string getResourceID() const {
+			return "aff4://resource";
+		}
+		aff4::Lexicon getBaseType() {
+			return aff4::Lexicon::AFF4_IMAGE_TYPE;
+		}
+		std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> getProperties() {
+			std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>> properties;
+			properties[aff4::Lexicon::AFF4_TYPE].push_back(aff4::rdf::RDFValue(aff4::Lexicon::AFF4_IMAGE_TYPE));
+			return properties;
+		}
+		std::vector<aff4::rdf::RDFValue> getProperty(aff4::Lexicon resource) {
+			return getProperties()[resource];
+		}
+	};
+	Resource resource;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties = resource.getPropertyMap();
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, properties->size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, resource.getPropertyValues(aff4::Lexicon::AFF4_TYPE)->size());
+	CPPUNIT_ASSERT(*resource.getPropertyValues(aff4::Lexicon::AFF4_TYPE) == resource.getProperty(aff4::Lexicon::AFF4_TYPE));
+	CPPUNIT_ASSERT(resource.getPropertyValues(aff4::Lexicon::AFF4_SIZE)->empty());
+}
+
+TEST_METHOD(testResourcePropertiesImmutable) {
+	// Adding a property publishes a new map, leaving views already handed out unchanged.
+	class Resource: public aff4::AFF4Resource {
+	public:
+		Resource() :
+				aff4::AFF4Resource("aff4://resource") {
+			addProperty(aff4::Lexicon::AFF4_SIZE, aff4::rdf::RDFValue((int64_t) 1));
+		}
+		void setSize(int64_t size) {
+			addProperty(aff4::Lexicon::AFF4_SIZE, aff4::rdf::RDFValue(size));
+		}
+	};
+	Resource resource;
+	std::shared_ptr<const std::map<aff4::Lexicon, std::vector<aff4::rdf::RDFValue>>> properties = resource.getPropertyMap();
+	std::shared_ptr<const std::vector<aff4::rdf::RDFValue>> sizes = resource.getPropertyValues(aff4::Lexicon::AFF4_SIZE);
+	resource.setSize(2);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 1, (*sizes)[0].getLong());
+	CPPUNIT_ASSERT_EQUAL((int64_t) 1, properties->at(aff4::Lexicon::AFF4_SIZE)[0].getLong());
+	CPPUNIT_ASSERT_EQUAL((int64_t) 2, (*resource.getPropertyValues(aff4::Lexicon::AFF4_SIZE))[0].getLong());
+	CPPUNIT_ASSERT(properties != resource.getPropertyMap());
+}
+
+TEST_METHOD(testContainerSharedImageStreams) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+	CPPUNIT_ASSERT(container != nullptr);
+	aff4::container::AFF4ZipContainer* con = static_cast<aff4::container::AFF4ZipContainer*>(container.get());
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, con->getLiveImageStreamCount());
+
+	// The map of the image opens the data stream on first read, which is shared with direct consumers.
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, images.size());
+	std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+	CPPUNIT_ASSERT(map != nullptr);
+	std::shared_ptr<aff4::IAFF4Stream> mapStream = map->getStream();
+	CPPUNIT_ASSERT(mapStream != nullptr);
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, con->getLiveImageStreamCount());
+
+	const std::string stream = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	std::shared_ptr<aff4::IAFF4Stream> s1 = con->getImageStream(stream);
+	std::shared_ptr<aff4::IAFF4Resource> s2 = container->open(stream);
+	CPPUNIT_ASSERT(s1 != nullptr);
+	CPPUNIT_ASSERT(s2 != nullptr);
+	CPPUNIT_ASSERT(s1 != std::dynamic_pointer_cast<aff4::IAFF4Stream>(s2));
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, con->getLiveImageStreamCount());
+
+	uint8_t buffer1[4096];
+	uint8_t buffer2[4096];
+	CPPUNIT_ASSERT_EQUAL((int64_t) 4096, s1->read(buffer1, 4096, 0));
+	CPPUNIT_ASSERT_EQUAL((int64_t) 4096, mapStream->read(buffer2, 4096, 0));
+	CPPUNIT_ASSERT(::memcmp(buffer1, buffer2, 4096) == 0);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, con->getLiveImageStreamCount());
+
+	// Streams on the same resource share their caches.
+	aff4::stream::ImageStream* i1 = dynamic_cast<aff4::stream::ImageStream*>(s1.get());
+	aff4::stream::ImageStream* i2 = dynamic_cast<aff4::stream::ImageStream*>(s2.get());
+	CPPUNIT_ASSERT(i1 != nullptr);
+	CPPUNIT_ASSERT(i2 != nullptr);
+	CPPUNIT_ASSERT(i1->getCompressedCacheSize() > 0);
+	CPPUNIT_ASSERT_EQUAL(i1->getCompressedCacheSize(), i2->getCompressedCacheSize());
+
+	// Closing one stream leaves the other streams, and maps, reading.
+	s1->close();
+	CPPUNIT_ASSERT_EQUAL((int64_t) -1, s1->read(buffer2, 4096, 0));
+	CPPUNIT_ASSERT_EQUAL(EPERM, errno);
+	::memset(buffer2, 0, 4096);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 4096, std::dynamic_pointer_cast<aff4::IAFF4Stream>(s2)->read(buffer2, 4096, 0));
+	CPPUNIT_ASSERT(::memcmp(buffer1, buffer2, 4096) == 0);
+	::memset(buffer2, 0, 4096);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 4096, mapStream->read(buffer2, 4096, 0));
+	CPPUNIT_ASSERT(::memcmp(buffer1, buffer2, 4096) == 0);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, con->getLiveImageStreamCount());
+
+	// Once all consumers release the stream, it is no longer registered.
+	s1.reset();
+	s2.reset();
+	mapStream.reset();
+	map.reset();
+	images.clear();
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, con->getLiveImageStreamCount());
+
+	// Closing the container closes all streams.
+	std::shared_ptr<aff4::IAFF4Stream> s3 = con->getImageStream(stream);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 4096, s3->read(buffer2, 4096, 0));
+	container->close();
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, con->getLiveImageStreamCount());
+	CPPUNIT_ASSERT_EQUAL((int64_t) -1, s3->read(buffer2, 4096, 0));
+}
+
+TEST_METHOD(testContainerCloseWithPrefetch) {
+	const std::string stream = "aff4://c215ba20-5648-4209-a793-1f918c723610";
+	uint8_t buffer[4096];
+	for (int i = 0; i < 8; i++) {
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename);
+		CPPUNIT_ASSERT(container != nullptr);
+		aff4::container::AFF4ZipContainer* con = static_cast<aff4::container::AFF4ZipContainer*>(container.get());
+		std::shared_ptr<aff4::IAFF4Stream> s = con->getImageStream(stream);
+		CPPUNIT_ASSERT(s != nullptr);
+		// Closed while the background loads are still running.
+		s->prefetch(0, s->size(), aff4::PREFETCH_HIGH);
+		container->close();
+		CPPUNIT_ASSERT_EQUAL((int64_t) -1, s->read(buffer, sizeof(buffer), 0));
+		errno = 0;
+		CPPUNIT_ASSERT_EQUAL((int64_t) -1, con->fileRead(buffer, sizeof(buffer), 0));
+		CPPUNIT_ASSERT_EQUAL(EBADF, errno);
+	}
+}
+
 TEST_METHOD(testBlank) {
 	std::string filename(filename1);
 
@@ -41,11 +41,20 @@ CPPUNIT_TEST_SUITE(container);
 	CPPUNIT_TEST(testZipLinear);
 	CPPUNIT_TEST(testZipAllocated);
 	CPPUNIT_TEST(testZipSegmentRead);
+	CPPUNIT_TEST(testZipSegmentReadv);
+	CPPUNIT_TEST(testZipFileReadIOClass);
 
 	CPPUNIT_TEST(testContainerDescription);
 	CPPUNIT_TEST(testContainerMissingResource);
 	CPPUNIT_TEST(testContainerMapContents);
 	CPPUNIT_TEST(testContainerImageStreamContents);
+	CPPUNIT_TEST(testContainerModelIndex);
+	CPPUNIT_TEST(testContainerLazyMetadata);
+	CPPUNIT_TEST(testContainerSharedProperties);
+	CPPUNIT_TEST(testResourceDefaultPropertyViews);
+	CPPUNIT_TEST(testResourcePropertiesImmutable);
+	CPPUNIT_TEST(testContainerSharedImageStreams);
+	CPPUNIT_TEST(testContainerCloseWithPrefetch);
 
 	CPPUNIT_TEST(testBlank);
 	CPPUNIT_TEST(testBlank5);
@@ -63,6 +72,8 @@ private:
 	void testZipLinear();
 	void testZipAllocated();
 	void testZipSegmentRead();
+	void testZipSegmentReadv();
+	void testZipFileReadIOClass();
 	void testContainerLinear();
 	void testContainerAllocated();
 	void testContainerLinearReadError();
@@ -72,6 +83,13 @@ private:
 	void testContainerMissingResource();
 	void testContainerMapContents();
 	void testContainerImageStreamContents();
+	void testContainerModelIndex();
+	void testContainerLazyMetadata();
+	void testContainerSharedProperties();
+	void testResourceDefaultPropertyViews();
+	void testResourcePropertiesImmutable();
+	void testContainerSharedImageStreams();
+	void testContainerCloseWithPrefetch();
 
 	void testBlank();
 	void testBlank5();
@@ -32,10 +32,15 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include "TestUtilities.h"
 #include"container\AFF4ZipContainer.h"
 #include "stream\ImageStreamFactory.h"
+#include "stream\struct\ChunkStore.h"
 
 #include <locale>
 #include <codecvt>
 #include <shlwapi.h>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
 
 #define CPPUNIT_ASSERT Assert::IsTrue
 #define CPPUNIT_ASSERT_EQUAL Assert::AreEqual
@@ -306,6 +311,239 @@ TEST_METHOD(testLinearImageStreamContents) {
 	}
 }
 
+TEST_METHOD(testMapStreamExtents) {
+	std::vector<std::string> files = { file_1, file_2, file_3, pfile_1, pfile_2 };
+	for (const std::string& file : files) {
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file);
+		CPPUNIT_ASSERT(container != nullptr);
+		std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+		CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+		std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+		CPPUNIT_ASSERT(map != nullptr);
+		std::shared_ptr<aff4::IAFF4Stream> stream = map->getStream();
+		CPPUNIT_ASSERT(stream != nullptr);
+		std::shared_ptr<aff4::stream::MapStream> mapStream = std::dynamic_pointer_cast<aff4::stream::MapStream>(stream);
+		CPPUNIT_ASSERT(mapStream != nullptr);
+
+		// The extents cover the stream, without opening any target stream.
+		uint64_t size = stream->size();
+		std::vector<aff4::StreamExtent> extents = map->getExtents(0, UINT64_MAX);
+		CPPUNIT_ASSERT(!extents.empty());
+		CPPUNIT_ASSERT_EQUAL((size_t) 0, mapStream->getOpenedStreamCount());
+		uint64_t offset = 0;
+		uint64_t data = 0;
+		std::vector<uint8_t> buffer;
+		for (const aff4::StreamExtent& extent : extents) {
+			CPPUNIT_ASSERT_EQUAL(offset, extent.offset);
+			CPPUNIT_ASSERT(extent.length > 0);
+			CPPUNIT_ASSERT(!extent.target.empty());
+			offset += extent.length;
+			if (extent.type == aff4::ExtentType::EXTENT_DATA) {
+				data += extent.length;
+			}
+			// Zero and (default) gap extents read as zeros.
+			if ((extent.type == aff4::ExtentType::EXTENT_ZERO) || (extent.type == aff4::ExtentType::EXTENT_GAP)) {
+				buffer.assign(std::min<uint64_t>(extent.length, 4096), 0xff);
+				CPPUNIT_ASSERT_EQUAL((int64_t) buffer.size(), stream->read(buffer.data(), buffer.size(), extent.offset));
+				CPPUNIT_ASSERT(std::count(buffer.begin(), buffer.end(), 0) == (ptrdiff_t) buffer.size());
+			}
+		}
+		CPPUNIT_ASSERT_EQUAL(size, offset);
+		printf("Map : %s : %" PRIu64 " extents, %" PRIu64 " of %" PRIu64 " bytes stored data\n",
+				map->getResourceID().c_str(), (uint64_t) extents.size(), data, size);
+
+		// Walking the data regions with nextData()/nextHole() finds the same data.
+		uint64_t walked = 0;
+		offset = map->nextData(0);
+		while (offset < size) {
+			uint64_t hole = map->nextHole(offset);
+			CPPUNIT_ASSERT(hole > offset);
+			walked += hole - offset;
+			offset = map->nextData(hole);
+		}
+		CPPUNIT_ASSERT_EQUAL(data, walked);
+		CPPUNIT_ASSERT_EQUAL(size, stream->nextData(size));
+		CPPUNIT_ASSERT_EQUAL(size, stream->nextHole(size));
+
+		// A sub range is truncated to the range.
+		std::vector<aff4::StreamExtent> part = stream->getExtents(extents[0].offset + 1, 10);
+		CPPUNIT_ASSERT_EQUAL((size_t) 1, part.size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t) 1, part[0].offset);
+		CPPUNIT_ASSERT_EQUAL((uint64_t) 10, part[0].length);
+		CPPUNIT_ASSERT_EQUAL(extents[0].targetOffset + 1, part[0].targetOffset);
+	}
+}
+
+TEST_METHOD(testImageStreamScatterRead) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_1);
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::stream::MapStream> mapStream = std::dynamic_pointer_cast<aff4::stream::MapStream>(
+			images[0]->getMap()->getStream());
+	CPPUNIT_ASSERT(mapStream != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Stream>> streams = mapStream->getStreams();
+	CPPUNIT_ASSERT(!streams.empty());
+	std::shared_ptr<aff4::stream::ImageStream> stream = std::dynamic_pointer_cast<aff4::stream::ImageStream>(streams[0]);
+	CPPUNIT_ASSERT(stream != nullptr);
+
+	// Adjacent ranges, ranges in the same chunk, across chunks, truncated at and beyond the end.
+	uint64_t size = stream->size();
+	std::vector<std::pair<uint64_t, uint64_t>> ranges = { { 0, 100 }, { 100, 4096 }, { 200, 16 }, { 32700, 200 }, {
+			(3 * 65536) + 5, 7 }, { size - 10, 100 }, { size + 10, 10 } };
+	std::unique_ptr<uint8_t[]> expected(new uint8_t[ranges.size() * 4096]);
+	std::unique_ptr<uint8_t[]> actual(new uint8_t[ranges.size() * 4096]);
+	::memset(expected.get(), 0, ranges.size() * 4096);
+	::memset(actual.get(), 0, ranges.size() * 4096);
+	std::vector<aff4::stream::ScatterRead> reads;
+	int64_t total = 0;
+	for (size_t i = 0; i < ranges.size(); i++) {
+		total += stream->read(expected.get() + (i * 4096), ranges[i].second, ranges[i].first);
+		aff4::stream::ScatterRead read = { actual.get() + (i * 4096), ranges[i].second, ranges[i].first };
+		reads.push_back(read);
+	}
+	CPPUNIT_ASSERT_EQUAL(total, stream->readScatter(reads.data(), reads.size()));
+	CPPUNIT_ASSERT(::memcmp(expected.get(), actual.get(), ranges.size() * 4096) == 0);
+}
+
+TEST_METHOD(testImageStreamThreadCache) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_1);
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::stream::MapStream> mapStream = std::dynamic_pointer_cast<aff4::stream::MapStream>(
+			images[0]->getMap()->getStream());
+	CPPUNIT_ASSERT(mapStream != nullptr);
+	std::shared_ptr<aff4::IAFF4Stream> stream = mapStream->getStreams()[0];
+	CPPUNIT_ASSERT(std::dynamic_pointer_cast<aff4::stream::ImageStream>(stream) != nullptr);
+
+	// Sector reads within a few chunks, as served from the per-thread chunk cache.
+	const uint64_t region = 256 * 1024;
+	std::unique_ptr<uint8_t[]> expected(new uint8_t[region]);
+	CPPUNIT_ASSERT_EQUAL((int64_t) region, stream->read(expected.get(), region, 0));
+	std::function<int(uint64_t)> readSectors = [&stream, &expected, region](uint64_t seed) {
+		int errors = 0;
+		uint8_t sector[512];
+		for (int i = 0; i < 4096; i++) {
+			seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+			uint64_t offset = ((seed >> 16) % (region / 512)) * 512;
+			if ((stream->read(sector, 512, offset) != 512) || (::memcmp(sector, expected.get() + offset, 512) != 0)) {
+				errors++;
+			}
+		}
+		return errors;
+	};
+	CPPUNIT_ASSERT_EQUAL(0, readSectors(1));
+
+	// Evicted chunks are reloaded.
+	stream->evict(0, region);
+	CPPUNIT_ASSERT_EQUAL(0, readSectors(2));
+
+	// Each thread holds its own chunks.
+	std::vector<std::future<int>> results;
+	for (uint64_t seed = 3; seed < 7; seed++) {
+		results.push_back(std::async(std::launch::async, readSectors, seed));
+	}
+	for (std::future<int>& result : results) {
+		CPPUNIT_ASSERT_EQUAL(0, result.get());
+	}
+
+	// Chunks held by the thread are not used once the stream is closed.
+	stream->close();
+	uint8_t sector[512];
+	CPPUNIT_ASSERT_EQUAL((int64_t) -1, stream->read(sector, 512, 0));
+}
+
+TEST_METHOD(testImageStreamCompressedCache) {
+	// A decompressed cache of few chunks, backed by the compressed chunk cache. (Applies to streams as opened).
+	uint64_t cacheSize = aff4::stream::setImageStreamCacheSize(2 * 1024 * 1024);
+	uint64_t compressedCacheSize = aff4::stream::setImageStreamCompressedCacheSize(8 * 1024 * 1024);
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_1);
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::stream::MapStream> mapStream = std::dynamic_pointer_cast<aff4::stream::MapStream>(
+			images[0]->getMap()->getStream());
+	CPPUNIT_ASSERT(mapStream != nullptr);
+	std::shared_ptr<aff4::stream::ImageStream> stream = std::dynamic_pointer_cast<aff4::stream::ImageStream>(
+			mapStream->getStreams()[0]);
+	CPPUNIT_ASSERT(stream != nullptr);
+	aff4::stream::setImageStreamCacheSize(cacheSize);
+	aff4::stream::setImageStreamCompressedCacheSize(compressedCacheSize);
+
+	const uint64_t region = 3 * 1024 * 1024;
+	std::unique_ptr<uint8_t[]> expected(new uint8_t[region]);
+	std::unique_ptr<uint8_t[]> actual(new uint8_t[region]);
+	CPPUNIT_ASSERT_EQUAL((int64_t) region, stream->read(expected.get(), region, 0));
+	uint64_t held = stream->getCompressedCacheSize();
+	CPPUNIT_ASSERT(held > 0);
+	CPPUNIT_ASSERT(held <= 8 * 1024 * 1024);
+
+	// Chunks long gone from the decompressed cache are decompressed from the compressed chunks.
+	for (uint64_t offset = 0; offset < region; offset += 4096) {
+		CPPUNIT_ASSERT_EQUAL((int64_t) 4096, stream->read(actual.get() + offset, 4096, offset));
+	}
+	CPPUNIT_ASSERT(::memcmp(expected.get(), actual.get(), region) == 0);
+
+	// Evicted chunks are dropped from both caches, and read again from the container.
+	stream->evict(0, region);
+	::memset(actual.get(), 0, region);
+	CPPUNIT_ASSERT_EQUAL((int64_t) region, stream->read(actual.get(), region, 0));
+	CPPUNIT_ASSERT(::memcmp(expected.get(), actual.get(), region) == 0);
+}
+
+TEST_METHOD(testImageStreamChunkSharing) {
+	aff4::stream::structs::ChunkStore store(4);
+	const std::string codec = "http://code.google.com/p/snappy/";
+	uint8_t payload[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	std::shared_ptr<uint8_t> chunk(new uint8_t[64], std::default_delete<uint8_t[]>());
+	::memset(chunk.get(), 0xAA, 64);
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload)) == nullptr);
+	CPPUNIT_ASSERT(store.share(codec, 64, payload, sizeof(payload), chunk) == chunk);
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload)) == chunk);
+	// Only identical contents, of the same codec and chunk size, are shared.
+	CPPUNIT_ASSERT(store.find("aff4:NullCompressor", 64, payload, sizeof(payload)) == nullptr);
+	CPPUNIT_ASSERT(store.find(codec, 128, payload, sizeof(payload)) == nullptr);
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload) - 1) == nullptr);
+	payload[4] = 0;
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload)) == nullptr);
+
+	// Chunks of zeros become the zero page, which is always held.
+	std::shared_ptr<uint8_t> zeros(new uint8_t[64](), std::default_delete<uint8_t[]>());
+	std::shared_ptr<uint8_t> zeroPage = aff4::stream::structs::ChunkStore::getZeroPage(64);
+	CPPUNIT_ASSERT(zeroPage == aff4::stream::structs::ChunkStore::getZeroPage(64));
+	CPPUNIT_ASSERT(store.share(codec, 64, payload, sizeof(payload), zeros) == zeroPage);
+	zeros.reset();
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload)) == zeroPage);
+
+	// The store does not own the chunks it shares.
+	payload[4] = 5;
+	chunk.reset();
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload)) == nullptr);
+	chunk = std::shared_ptr<uint8_t>(new uint8_t[64], std::default_delete<uint8_t[]>());
+	::memset(chunk.get(), 0xAA, 64);
+	CPPUNIT_ASSERT(store.share(codec, 64, payload, sizeof(payload), chunk) == chunk);
+	CPPUNIT_ASSERT(store.find(codec, 64, payload, sizeof(payload)) == chunk);
+
+	// Streams read the same contents with and without sharing.
+	std::vector<std::vector<uint8_t>> contents;
+	for (int sharing = 0; sharing < 2; sharing++) {
+		bool enabled = aff4::stream::setImageStreamChunkSharingEnabled(sharing != 0);
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_1);
+		CPPUNIT_ASSERT(container != nullptr);
+		std::shared_ptr<aff4::stream::MapStream> mapStream = std::dynamic_pointer_cast<aff4::stream::MapStream>(
+				container->getImages()[0]->getMap()->getStream());
+		CPPUNIT_ASSERT(mapStream != nullptr);
+		std::shared_ptr<aff4::IAFF4Stream> stream = mapStream->getStreams()[0];
+		aff4::stream::setImageStreamChunkSharingEnabled(enabled);
+		std::vector<uint8_t> content((size_t) stream->size());
+		CPPUNIT_ASSERT_EQUAL((int64_t) content.size(), stream->read(content.data(), content.size(), 0));
+		contents.push_back(content);
+	}
+	CPPUNIT_ASSERT(contents[0] == contents[1]);
+	CPPUNIT_ASSERT(aff4::stream::structs::ChunkStore::getDefault().size() > 0);
+}
+
 TEST_METHOD(testAllocatedImageStreamContents) {
 	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_2);
 	CPPUNIT_ASSERT(container != nullptr);
@@ -420,6 +658,116 @@ TEST_METHOD(testContainerAllocatedUnknown) {
 
 
 
+TEST_METHOD(testMapStreamSharedTable) {
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_2);
+	CPPUNIT_ASSERT(container != nullptr);
+
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+	CPPUNIT_ASSERT(map != nullptr);
+
+	// Each call provides a new stream, over the one parsed map table.
+	std::shared_ptr<aff4::stream::MapStream> stream1 = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+	std::shared_ptr<aff4::stream::MapStream> stream2 = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+	CPPUNIT_ASSERT(stream1 != nullptr);
+	CPPUNIT_ASSERT(stream2 != nullptr);
+	CPPUNIT_ASSERT(stream1 != stream2);
+	CPPUNIT_ASSERT(stream1->getTable() != nullptr);
+	CPPUNIT_ASSERT(stream1->getTable() == stream2->getTable());
+	CPPUNIT_ASSERT_EQUAL(stream1->size(), stream2->size());
+
+	// Closing one stream leaves the other usable, and its map and streams valid while held.
+	std::shared_ptr<const aff4::stream::structs::MapIndex> index = stream1->getMap();
+	std::vector<std::shared_ptr<aff4::IAFF4Stream>> streams = stream1->getStreams();
+	CPPUNIT_ASSERT(index != nullptr);
+	CPPUNIT_ASSERT(!streams.empty());
+	size_t entries = index->size();
+	stream1->close();
+	CPPUNIT_ASSERT(stream1->getTable() == nullptr);
+	CPPUNIT_ASSERT(stream1->getMap() == nullptr);
+	CPPUNIT_ASSERT(stream1->getStreams().empty());
+	std::shared_ptr<aff4::IAFF4Stream> stream = stream2;
+	testStreamContentsInt(stream, streamSHA1_2, 64 * 1024);
+
+	// Changing an override rebuilds the table.
+	std::shared_ptr<aff4::IAFF4Stream> gap = aff4::stream::createZeroStream();
+	map->setMapGapStreamOverride(gap);
+	std::shared_ptr<aff4::stream::MapStream> stream3 = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+	CPPUNIT_ASSERT(stream3 != nullptr);
+	CPPUNIT_ASSERT(stream3->getTable() != stream2->getTable());
+	stream = stream3;
+	testStreamContentsInt(stream, streamSHA1_2, 64 * 1024);
+	stream2.reset();
+	CPPUNIT_ASSERT_EQUAL(entries, index->size());
+	for (const std::shared_ptr<aff4::IAFF4Stream>& s : streams) {
+		CPPUNIT_ASSERT(s != nullptr);
+	}
+}
+
+TEST_METHOD(testMapStreamCoalesced) {
+	std::vector<std::string> files = { file_1, file_2, file_3, pfile_1, pfile_2 };
+	for (const std::string& file : files) {
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file);
+		CPPUNIT_ASSERT(container != nullptr);
+		std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+		CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+		std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+		CPPUNIT_ASSERT(map != nullptr);
+		std::shared_ptr<aff4::stream::MapStream> stream = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+		CPPUNIT_ASSERT(stream != nullptr);
+
+		aff4::stream::MapStatistics statistics = stream->getStatistics();
+		printf("Map : %s : stored %" PRIu64 ", sparse %" PRIu64 ", coalesced %" PRIu64 " => %" PRIu64 "\n",
+				map->getResourceID().c_str(), statistics.storedEntries, statistics.sparseEntries,
+				statistics.coalescedEntries, statistics.entries);
+		CPPUNIT_ASSERT(statistics.entries > 0);
+		CPPUNIT_ASSERT(statistics.entries + statistics.coalescedEntries <= statistics.storedEntries + statistics.sparseEntries);
+
+		// Entries cover the map without gaps, and no two neighbours could have been merged.
+		std::shared_ptr<const aff4::stream::structs::MapIndex> entries = stream->getMap();
+		CPPUNIT_ASSERT(entries != nullptr);
+		CPPUNIT_ASSERT_EQUAL((size_t) statistics.entries, entries->size());
+		for (size_t i = 1; i < entries->size(); i++) {
+			const aff4::stream::structs::MapEntryPoint& prior = entries->get(i - 1);
+			const aff4::stream::structs::MapEntryPoint& entry = entries->get(i);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) (prior.offset + prior.length), (uint64_t) entry.offset);
+			CPPUNIT_ASSERT(!((prior.streamID == entry.streamID) && (prior.streamOffset + prior.length == entry.streamOffset)));
+		}
+	}
+}
+
+TEST_METHOD(testMapStreamInPlace) {
+	// Use every eligible map in place.
+	uint64_t threshold = aff4::map::setMapInPlaceThreshold(1);
+	std::vector<std::string> files = { file_1, file_2, pfile_1 };
+	std::vector<std::string> hashes = { streamSHA1_1, streamSHA1_2, "" };
+	for (size_t i = 0; i < files.size(); i++) {
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(files[i]);
+		CPPUNIT_ASSERT(container != nullptr);
+		std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+		CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+		std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+		CPPUNIT_ASSERT(map != nullptr);
+		std::shared_ptr<aff4::stream::MapStream> stream = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+		CPPUNIT_ASSERT(stream != nullptr);
+
+		aff4::stream::MapStatistics statistics = stream->getStatistics();
+		printf("Map : %s : stored %" PRIu64 " => %" PRIu64 " %s\n", map->getResourceID().c_str(),
+				statistics.storedEntries, statistics.entries, statistics.mapped ? "in place" : "loaded");
+		CPPUNIT_ASSERT_EQUAL(statistics.mapped, stream->getMap()->isMapped());
+		if (statistics.mapped) {
+			CPPUNIT_ASSERT_EQUAL(statistics.storedEntries, statistics.entries);
+			CPPUNIT_ASSERT_EQUAL((uint64_t) 0, statistics.coalescedEntries);
+		}
+		if (!hashes[i].empty()) {
+			std::shared_ptr<aff4::IAFF4Stream> s = stream;
+			testStreamContentsInt(s, hashes[i], 64 * 1024);
+		}
+	}
+	aff4::map::setMapInPlaceThreshold(threshold);
+}
+
 TEST_METHOD(testContainer7) {
 
 	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(pfile_1);
@@ -531,6 +879,132 @@ TEST_METHOD(testContainerLinear_Part2) {
 	}
 }
 
+TEST_METHOD(testMapStreamLazyStreams) {
+	std::unique_ptr<aff4::IAFF4Resolver> resolver(aff4::container::createResolver(strip_file_1));
+
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(strip_file_1, resolver.get());
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+	CPPUNIT_ASSERT(map != nullptr);
+	std::shared_ptr<aff4::stream::MapStream> stream = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+	CPPUNIT_ASSERT(stream != nullptr);
+
+	// Nothing is opened until read.
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, stream->getOpenedStreamCount());
+
+	// A small read only opens the stream(s) backing that range.
+	std::shared_ptr<const aff4::stream::structs::MapIndex> entries = stream->getMap();
+	CPPUNIT_ASSERT(entries != nullptr);
+	const aff4::stream::structs::MapEntryPoint& first = entries->get(0);
+	uint8_t buffer[512];
+	uint64_t count = std::min<uint64_t>(sizeof(buffer), first.length);
+	CPPUNIT_ASSERT_EQUAL((int64_t) count, stream->read(buffer, count, 0));
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, stream->getOpenedStreamCount());
+
+	// Streams used by other (shared table) instances are opened once.
+	std::shared_ptr<aff4::stream::MapStream> second = std::dynamic_pointer_cast<aff4::stream::MapStream>(map->getStream());
+	CPPUNIT_ASSERT(second != nullptr);
+	CPPUNIT_ASSERT_EQUAL((int64_t) count, second->read(buffer, count, 0));
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, second->getOpenedStreamCount());
+
+	// Asking for all streams opens them all.
+	std::vector<std::shared_ptr<aff4::IAFF4Stream>> streams = stream->getStreams();
+	CPPUNIT_ASSERT(!streams.empty());
+	for (const std::shared_ptr<aff4::IAFF4Stream>& s : streams) {
+		CPPUNIT_ASSERT(s != nullptr);
+	}
+	printf("Map : %s : opened %" PRIu64 " of %" PRIu64 " streams\n", map->getResourceID().c_str(),
+			(uint64_t) stream->getOpenedStreamCount(), (uint64_t) (streams.size() - 1));
+	for (uint64_t rSize : readSizes) {
+		std::shared_ptr<aff4::IAFF4Stream> s = stream;
+		testStreamContentsInt(s, strip_streamSHA1_1, rSize);
+	}
+}
+
+TEST_METHOD(testMapStreamConcurrentRead) {
+	std::unique_ptr<aff4::IAFF4Resolver> resolver(aff4::container::createResolver(strip_file_1));
+
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(strip_file_1, resolver.get());
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+	CPPUNIT_ASSERT(map != nullptr);
+	std::shared_ptr<aff4::IAFF4Stream> stream = map->getStream();
+	CPPUNIT_ASSERT(stream != nullptr);
+
+	// Read the whole image, reading target streams in turn and then concurrently.
+	uint64_t size = stream->size();
+	std::unique_ptr<uint8_t[]> serial(new uint8_t[size]);
+	std::unique_ptr<uint8_t[]> concurrent(new uint8_t[size]);
+	uint64_t threshold = aff4::map::setConcurrentReadThreshold(0);
+	CPPUNIT_ASSERT_EQUAL((int64_t) size, stream->read(serial.get(), size, 0));
+	aff4::map::setConcurrentReadThreshold(1);
+	CPPUNIT_ASSERT_EQUAL((int64_t) size, stream->read(concurrent.get(), size, 0));
+	CPPUNIT_ASSERT(::memcmp(serial.get(), concurrent.get(), size) == 0);
+	for (uint64_t rSize : readSizes) {
+		testStreamContentsInt(stream, strip_streamSHA1_1, rSize);
+	}
+	aff4::map::setConcurrentReadThreshold(threshold);
+}
+
+TEST_METHOD(testMapStreamPrefetch) {
+	uint64_t window = aff4::map::setPrefetchWindow(1024 * 1024);
+	for (int pass = 0; pass < 2; pass++) {
+		std::unique_ptr<aff4::IAFF4Resolver> resolver(aff4::container::createResolver(strip_file_1));
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(strip_file_1, resolver.get());
+		CPPUNIT_ASSERT(container != nullptr);
+		std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+		CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+		std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+		CPPUNIT_ASSERT(map != nullptr);
+		std::shared_ptr<aff4::IAFF4Stream> stream = map->getStream();
+		CPPUNIT_ASSERT(stream != nullptr);
+		if (pass == 0) {
+			// Sequential reads are served from chunks loaded ahead of time.
+			for (uint64_t rSize : readSizes) {
+				testStreamContentsInt(stream, strip_streamSHA1_1, rSize);
+			}
+		} else {
+			// Close the container while read ahead is outstanding.
+			uint8_t buffer[4096];
+			CPPUNIT_ASSERT_EQUAL((int64_t) sizeof(buffer), stream->read(buffer, sizeof(buffer), 0));
+			CPPUNIT_ASSERT_EQUAL((int64_t) sizeof(buffer), stream->read(buffer, sizeof(buffer), sizeof(buffer)));
+			map.reset();
+			images.clear();
+			container->close();
+			container.reset();
+		}
+	}
+	aff4::map::setPrefetchWindow(window);
+}
+
+TEST_METHOD(testMapStreamPrefetchHint) {
+	uint64_t window = aff4::map::setPrefetchWindow(0);
+	std::unique_ptr<aff4::IAFF4Resolver> resolver(aff4::container::createResolver(strip_file_1));
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(strip_file_1, resolver.get());
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+	CPPUNIT_ASSERT(map != nullptr);
+	std::shared_ptr<aff4::IAFF4Stream> stream = map->getStream();
+	CPPUNIT_ASSERT(stream != nullptr);
+
+	// Hints never change the content read.
+	uint64_t size = stream->size();
+	map->prefetch(0, size, aff4::PREFETCH_HIGH);
+	stream->prefetch(size / 2, size, aff4::PREFETCH_LOW);
+	stream->prefetch(size, 1024);
+	testStreamContentsInt(stream, strip_streamSHA1_1, 64 * 1024);
+	stream->evict(0, size / 2);
+	map->evict(size / 2, size);
+	testStreamContentsInt(stream, strip_streamSHA1_1, 64 * 1024);
+	aff4::map::setPrefetchWindow(window);
+}
+
 TEST_METHOD(testCAPI_Linear) {
 	AFF4_init();
 	int handle = AFF4_open(file_1.c_str());
@@ -611,6 +1085,139 @@ TEST_METHOD(testCAPI_PMem) {
 	CPPUNIT_ASSERT_EQUAL(-1, (int)AFF4_read(handle, 0, nullptr, 1));
 }
 
+TEST_METHOD(testMapStreamReadv) {
+	for (const std::string& filename : { file_1, file_2, strip_file_1 }) {
+		std::unique_ptr<aff4::IAFF4Resolver> resolver(aff4::container::createResolver(filename));
+		std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(filename, resolver.get());
+		CPPUNIT_ASSERT(container != nullptr);
+		std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+		CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+		std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+		CPPUNIT_ASSERT(map != nullptr);
+		std::shared_ptr<aff4::IAFF4Stream> stream = map->getStream();
+		CPPUNIT_ASSERT(stream != nullptr);
+		aff4::test::testReadv(stream, 300, 4096);
+		aff4::test::testReadv(stream, 16, 256 * 1024);
+	}
+
+	// The aff4:ImageStream directly.
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(file_1);
+	CPPUNIT_ASSERT(container != nullptr);
+	std::shared_ptr<aff4::IAFF4Stream> stream = static_cast<aff4::container::AFF4ZipContainer*>(container.get())->getImageStream(
+			"aff4://c215ba20-5648-4209-a793-1f918c723610");
+	CPPUNIT_ASSERT(stream != nullptr);
+	aff4::test::testReadv(stream, 300, 4096);
+	aff4::test::testReadv(stream, 16, 256 * 1024);
+}
+
+TEST_METHOD(testMapStreamReadAsync) {
+	std::unique_ptr<aff4::IAFF4Resolver> resolver(aff4::container::createResolver(strip_file_1));
+	std::shared_ptr<aff4::IAFF4Container> container = aff4::container::openAFF4Container(strip_file_1, resolver.get());
+	CPPUNIT_ASSERT(container != nullptr);
+	std::vector<std::shared_ptr<aff4::IAFF4Image>> images = container->getImages();
+	CPPUNIT_ASSERT_EQUAL(1, (int )images.size());
+	std::shared_ptr<aff4::IAFF4Map> map = images[0]->getMap();
+	CPPUNIT_ASSERT(map != nullptr);
+	std::shared_ptr<aff4::IAFF4Stream> stream = map->getStream();
+	CPPUNIT_ASSERT(stream != nullptr);
+
+	const uint64_t blockSize = 64 * 1024;
+	const uint64_t blocks = std::min<uint64_t>(64, stream->size() / blockSize);
+	std::unique_ptr<uint8_t[]> expected(new uint8_t[blocks * blockSize]);
+	std::unique_ptr<uint8_t[]> actual(new uint8_t[blocks * blockSize]);
+	CPPUNIT_ASSERT_EQUAL((int64_t) (blocks * blockSize), stream->read(expected.get(), blocks * blockSize, 0));
+
+	// Futures.
+	::memset(actual.get(), 0, blocks * blockSize);
+	std::vector<std::future<int64_t>> futures;
+	for (uint64_t i = 0; i < blocks; i++) {
+		futures.push_back(stream->readAsyncFuture(actual.get() + (i * blockSize), blockSize, i * blockSize));
+	}
+	for (std::future<int64_t>& future : futures) {
+		CPPUNIT_ASSERT_EQUAL((int64_t) blockSize, future.get());
+	}
+	CPPUNIT_ASSERT(::memcmp(expected.get(), actual.get(), blocks * blockSize) == 0);
+
+	// Callbacks, delivered through a completion executor.
+	std::atomic<uint64_t> dispatched(0);
+	aff4::stream::CompletionExecutor old = aff4::stream::setCompletionExecutor([&dispatched](std::function<void()> task) {
+		dispatched++;
+		task();
+	});
+	::memset(actual.get(), 0, blocks * blockSize);
+	std::mutex lock;
+	std::condition_variable done;
+	uint64_t completed = 0;
+	uint64_t errors = 0;
+	int64_t total = 0;
+	for (uint64_t i = 0; i < blocks; i++) {
+		stream->readAsync(actual.get() + (i * blockSize), blockSize, i * blockSize, [&](int64_t result, int error) {
+			std::lock_guard<std::mutex> guard(lock);
+			errors += (error != 0) ? 1 : 0;
+			total += result;
+			completed++;
+			done.notify_all();
+		});
+	}
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		done.wait(guard, [&]() {
+			return completed == blocks;
+		});
+	}
+	aff4::stream::setCompletionExecutor(old);
+	CPPUNIT_ASSERT_EQUAL((uint64_t) 0, errors);
+	CPPUNIT_ASSERT_EQUAL((int64_t) (blocks * blockSize), total);
+	CPPUNIT_ASSERT_EQUAL(blocks, dispatched.load());
+	CPPUNIT_ASSERT(::memcmp(expected.get(), actual.get(), blocks * blockSize) == 0);
+
+	// Failures are reported with their errno.
+	stream->close();
+	std::future<int64_t> failed = stream->readAsyncFuture(actual.get(), blockSize, 0);
+	CPPUNIT_ASSERT_EQUAL((int64_t) -1, failed.get());
+}
+
+TEST_METHOD(testCAPI_Prefetch) {
+	AFF4_init();
+	int handle = AFF4_open(file_1.c_str());
+	CPPUNIT_ASSERT_EQUAL(1, handle);
+	uint64_t size = AFF4_object_size(handle);
+
+	CPPUNIT_ASSERT_EQUAL(0, AFF4_prefetch(handle, 0, size, AFF4_PREFETCH_NORMAL));
+	CPPUNIT_ASSERT_EQUAL(-1, AFF4_prefetch(handle, 0, size, AFF4_PREFETCH_HIGH + 1));
+	CPPUNIT_ASSERT_EQUAL(EINVAL, errno);
+	std::string sha1 = aff4::test::sha1sum(handle, size);
+	CPPUNIT_ASSERT_EQUAL(streamSHA1_1, sha1);
+	CPPUNIT_ASSERT_EQUAL(0, AFF4_evict(handle, 0, size));
+
+	AFF4_close(handle);
+	CPPUNIT_ASSERT_EQUAL(-1, AFF4_prefetch(handle, 0, size, AFF4_PREFETCH_NORMAL));
+	CPPUNIT_ASSERT_EQUAL(EBADF, errno);
+	CPPUNIT_ASSERT_EQUAL(-1, AFF4_evict(handle, 0, size));
+}
+
+TEST_METHOD(testCAPI_SharedOpen) {
+	AFF4_init();
+	int handle1 = AFF4_open(file_1.c_str());
+	int handle2 = AFF4_open(file_1.c_str());
+	CPPUNIT_ASSERT_EQUAL(1, handle1);
+	CPPUNIT_ASSERT_EQUAL(2, handle2);
+	uint64_t size = AFF4_object_size(handle1);
+	CPPUNIT_ASSERT_EQUAL(size, (uint64_t) AFF4_object_size(handle2));
+
+	// Closing one handle leaves the shared container open for the other.
+	uint8_t buffer1[4096];
+	uint8_t buffer2[4096];
+	CPPUNIT_ASSERT_EQUAL(4096, AFF4_read(handle1, 0, buffer1, 4096));
+	CPPUNIT_ASSERT_EQUAL(0, AFF4_close(handle1));
+	CPPUNIT_ASSERT_EQUAL(4096, AFF4_read(handle2, 0, buffer2, 4096));
+	CPPUNIT_ASSERT(::memcmp(buffer1, buffer2, 4096) == 0);
+	std::string sha1 = aff4::test::sha1sum(handle2, size);
+	CPPUNIT_ASSERT_EQUAL(streamSHA1_1, sha1);
+	CPPUNIT_ASSERT_EQUAL(0, AFF4_close(handle2));
+	CPPUNIT_ASSERT_EQUAL(-1, AFF4_read(handle2, 0, buffer2, 4096));
+}
+
 std::wstring s2ws(const std::string& str) {
 	using convert_typeX = std::codecvt_utf8<wchar_t>;
 	std::wstring_convert<convert_typeX, wchar_t> converterX;
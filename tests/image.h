@@ -24,11 +24,16 @@
 #include "../src/aff4.h"
 #include "../src/aff4-c.h"
 #include "../src/container/AFF4ZipContainer.h"
+#include "../src/stream/struct/ChunkStore.h"
 
 #include "TestUtilities.h"
 
 #include <inttypes.h>
 #include <climits>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
 
 class image: public CPPUNIT_NS::TestFixture {
 CPPUNIT_TEST_SUITE(image);
@@ -45,6 +50,20 @@ CPPUNIT_TEST_SUITE(image);
 	CPPUNIT_TEST(testReadErrorImageStreamContents);
 	CPPUNIT_TEST(testAllHashsImageStreamContents);
 	CPPUNIT_TEST(testContainerAllocatedUnknown);
+	CPPUNIT_TEST(testMapStreamSharedTable);
+	CPPUNIT_TEST(testMapStreamCoalesced);
+	CPPUNIT_TEST(testMapStreamInPlace);
+	CPPUNIT_TEST(testMapStreamLazyStreams);
+	CPPUNIT_TEST(testMapStreamConcurrentRead);
+	CPPUNIT_TEST(testMapStreamPrefetch);
+	CPPUNIT_TEST(testMapStreamPrefetchHint);
+	CPPUNIT_TEST(testMapStreamReadv);
+	CPPUNIT_TEST(testMapStreamReadAsync);
+	CPPUNIT_TEST(testImageStreamScatterRead);
+	CPPUNIT_TEST(testImageStreamThreadCache);
+	CPPUNIT_TEST(testImageStreamCompressedCache);
+	CPPUNIT_TEST(testImageStreamChunkSharing);
+	CPPUNIT_TEST(testMapStreamExtents);
 
 	// Physical Memory Images.
 	CPPUNIT_TEST(testContainer7);
@@ -59,6 +78,8 @@ CPPUNIT_TEST_SUITE(image);
 	CPPUNIT_TEST(testCAPI_Allocated);
 	CPPUNIT_TEST(testCAPI_Striped);
 	CPPUNIT_TEST(testCAPI_PMem);
+	CPPUNIT_TEST(testCAPI_Prefetch);
+	CPPUNIT_TEST(testCAPI_SharedOpen);
 
 	// Unicode conversion
 	// CPPUNIT_TEST(testUnicodeFilename);
@@ -90,6 +111,20 @@ private:
 	void testReadErrorImageStreamContents();
 	void testAllHashsImageStreamContents();
 	void testContainerAllocatedUnknown();
+	void testMapStreamSharedTable();
+	void testMapStreamCoalesced();
+	void testMapStreamInPlace();
+	void testMapStreamLazyStreams();
+	void testMapStreamConcurrentRead();
+	void testMapStreamPrefetch();
+	void testMapStreamPrefetchHint();
+	void testMapStreamReadv();
+	void testMapStreamReadAsync();
+	void testImageStreamScatterRead();
+	void testImageStreamThreadCache();
+	void testImageStreamCompressedCache();
+	void testImageStreamChunkSharing();
+	void testMapStreamExtents();
 
 	/*
 	 * Physical Memory images.
@@ -110,6 +145,8 @@ private:
 	void testCAPI_Allocated();
 	void testCAPI_Striped();
 	void testCAPI_PMem();
+	void testCAPI_Prefetch();
+	void testCAPI_SharedOpen();
 
 	/*
 	 * Unicode conversions.
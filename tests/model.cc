@@ -0,0 +1,314 @@
+/*-
+ This file is part of AFF4 CPP.
+
+ AFF4 CPP is free software: you can redistribute it and/or modify
+ it under the terms of the GNU Lesser General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ AFF4 CPP is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public License
+ along with AFF4 CPP.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#if defined _WIN32 && defined _MSC_VER  
+
+ /*
+ * MS CPPUNIT
+ */
+
+#include "stdafx.h"
+#include "CppUnitTest.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+#include "aff4.h"
+#include "zip\Zip.h"
+#include "rdf\Model.h"
+#include "rdf\TurtleParser.h"
+#include "rdf\StringInterner.h"
+#include "TestUtilities.h"
+
+#define CPPUNIT_ASSERT Assert::IsTrue
+#define CPPUNIT_ASSERT_EQUAL Assert::AreEqual
+
+#define UNITTEST_BASE_PATH "..\\..\\..\\"
+
+namespace AFF4UnitTests
+{
+	TEST_CLASS(TestModel)
+	{
+	public:
+
+
+#else
+
+ /*
+  * CPPUNIT
+  */
+
+#include "model.h"
+
+CPPUNIT_TEST_SUITE_REGISTRATION(model);
+
+model::model() {
+}
+
+model::~model() {
+}
+
+void model::setUp() {
+}
+
+void model::tearDown() {
+}
+
+#define UNITTEST_BASE_PATH
+
+#define TEST_METHOD(x) void model::x()
+
+#endif
+
+/**
+ * A parsed statement.
+ */
+struct Statement {
+	std::string subject;
+	aff4::Lexicon property;
+	aff4::rdf::RDFValue value;
+};
+
+/**
+ * Parse the document with the native parser.
+ * @param turtle The document.
+ * @param statements The statements parsed.
+ * @return TRUE if the document was parsed.
+ */
+static bool parseNative(const std::string& turtle, std::vector<Statement>& statements) {
+	aff4::rdf::TurtleParser parser(turtle.data(), turtle.size(),
+			[&statements](const std::string& subject, aff4::Lexicon property, const aff4::rdf::RDFValue& value) {
+				statements.push_back(Statement {subject, property, value});
+			});
+	return parser.parse();
+}
+
+/**
+ * Load the information.turtle from the given container.
+ * @param filename The container filename.
+ * @return The turtle document.
+ */
+static std::string loadTurtle(const std::string& filename) {
+	aff4::zip::Zip zip(filename);
+	std::shared_ptr<aff4::IAFF4Stream> stream = zip.getStream(AFF4_INFORMATIONTURTLE);
+	CPPUNIT_ASSERT(stream != nullptr);
+	std::string turtle(stream->size(), '\0');
+	CPPUNIT_ASSERT_EQUAL((int64_t) turtle.size(), stream->read(&turtle[0], turtle.size(), 0));
+	return turtle;
+}
+
+/**
+ * Parse the document into a model.
+ * @param turtle The document.
+ * @param native Use the native parser.
+ * @return The model.
+ */
+static std::shared_ptr<aff4::rdf::Model> parseModel(const std::string& turtle, bool native) {
+	bool old = aff4::rdf::setNativeTurtleParserEnabled(native);
+	std::shared_ptr<aff4::rdf::Model> model = std::make_shared<aff4::rdf::Model>();
+	std::vector<unsigned char> buffer(turtle.begin(), turtle.end());
+	model->parse(buffer.data(), buffer.size());
+	aff4::rdf::setNativeTurtleParserEnabled(old);
+	return model;
+}
+
+TEST_METHOD(testTurtleParser) {
+	const std::string turtle = "@prefix : <aff4://volume> .\n"
+			"@prefix aff4: <http://aff4.org/Schema#> .\n"
+			"PREFIX xsd: <http://www.w3.org/2001/XMLSchema#>\n"
+			"# comment\n"
+			"<aff4://image> a aff4:Image , aff4:DiskImage ; # trailing comment\n"
+			"    aff4:stored : ;\n"
+			"    aff4:caseName \"Tab\\tQuote\\\" \\u00e9\" ;\n"
+			"    aff4:caseDescription \"\"\"Line 1\n\"Line 2\"\"\"\" ;\n"
+			"    aff4:examiner 'Single'@en-AU ;\n"
+			"    aff4:size \"1024\"^^xsd:long ;\n"
+			"    aff4:blockSize 512 ;\n"
+			"    aff4:unknownProperty <aff4://ignored> ;\n"
+			"    aff4:dataStream <aff4://map>;\n"
+			"    aff4:hash \"abcd\"^^<http://aff4.org/Schema#SHA1>;\n"
+			"    .\n"
+			":v1.2 aff4:target <aff4://image>.\n";
+	std::vector<Statement> statements;
+	CPPUNIT_ASSERT(parseNative(turtle, statements));
+	CPPUNIT_ASSERT_EQUAL((size_t) 11, statements.size());
+
+	for (size_t i = 0; i < 10; i++) {
+		CPPUNIT_ASSERT_EQUAL(std::string("aff4://image"), statements[i].subject);
+	}
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_TYPE, statements[0].property);
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_IMAGE_TYPE, statements[0].value.getType());
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_DISK_IMAGE_TYPE, statements[1].value.getType());
+
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_STORED, statements[2].property);
+	CPPUNIT_ASSERT(statements[2].value.getXSDType() == aff4::rdf::XSDType::Resource);
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4://volume"), statements[2].value.getValue());
+
+	CPPUNIT_ASSERT_EQUAL(std::string("Tab\tQuote\" \xc3\xa9"), statements[3].value.getValue());
+	CPPUNIT_ASSERT_EQUAL(std::string("Line 1\n\"Line 2\""), statements[4].value.getValue());
+	CPPUNIT_ASSERT_EQUAL(std::string("Single"), statements[5].value.getValue());
+	CPPUNIT_ASSERT(statements[5].value.getXSDType() == aff4::rdf::XSDType::String);
+
+	CPPUNIT_ASSERT(statements[6].value.getXSDType() == aff4::rdf::XSDType::Long);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 1024, statements[6].value.getLong());
+	CPPUNIT_ASSERT(statements[7].value.getXSDType() == aff4::rdf::XSDType::Int);
+	CPPUNIT_ASSERT_EQUAL((int32_t) 512, statements[7].value.getInteger());
+
+	// aff4:unknownProperty is skipped.
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_DATASTREAM, statements[8].property);
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4://map"), statements[8].value.getValue());
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_HASH, statements[9].property);
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_DIGEST_SHA1, statements[9].value.getType());
+	CPPUNIT_ASSERT_EQUAL(std::string("abcd"), statements[9].value.getValue());
+
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4://volumev1.2"), statements[10].subject);
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_TARGET, statements[10].property);
+}
+
+TEST_METHOD(testTurtleParserUnsupported) {
+	const std::vector<std::string> documents = { //
+			"@base <aff4://base> .", //
+					"<relative> <http://aff4.org/Schema#size> 1 .", //
+					"<aff4://a> <http://aff4.org/Schema#target> [ <http://aff4.org/Schema#size> 1 ] .", //
+					"<aff4://a> <http://aff4.org/Schema#target> _:b1 .", //
+					"<aff4://a> <http://aff4.org/Schema#target> ( <aff4://b> ) .", //
+					"<aff4://a> undeclared:target <aff4://b> .", //
+					"<aff4://a> <http://aff4.org/Schema#caseName> \"unterminated .", //
+					"<aff4://a> <http://aff4.org/Schema#caseName> \"missing dot\"", //
+			};
+	for (const std::string& turtle : documents) {
+		std::vector<Statement> statements;
+		CPPUNIT_ASSERT(!parseNative(turtle, statements));
+	}
+}
+
+TEST_METHOD(testNativeMatchesRaptor) {
+	const std::vector<std::string> filenames = { //
+			UNITTEST_BASE_PATH "tests/resources/Base-Linear.aff4", //
+					UNITTEST_BASE_PATH "tests/resources/Base-Allocated.aff4", //
+					UNITTEST_BASE_PATH "tests/resources/Base-Linear-AllHashes.aff4", //
+					UNITTEST_BASE_PATH "tests/resources/Micro7.001.aff4", //
+					UNITTEST_BASE_PATH "tests/resources/Micro9.001.aff4", //
+			};
+	for (const std::string& filename : filenames) {
+		std::string turtle = loadTurtle(filename);
+		std::vector<Statement> statements;
+		CPPUNIT_ASSERT(parseNative(turtle, statements));
+		CPPUNIT_ASSERT(!statements.empty());
+
+		std::shared_ptr<aff4::rdf::Model> native = parseModel(turtle, true);
+		std::shared_ptr<aff4::rdf::Model> raptor = parseModel(turtle, false);
+		for (int i = aff4::Lexicon::AFF4_TYPE; i <= aff4::Lexicon::BBT_CONTAINS_UNALLOCATED; i++) {
+			aff4::Lexicon type = static_cast<aff4::Lexicon>(i);
+			const std::vector<std::string>& resources = native->getResourcesOfType(type);
+			CPPUNIT_ASSERT(resources == raptor->getResourcesOfType(type));
+			for (const std::string& resource : resources) {
+				CPPUNIT_ASSERT(native->getObjectInformation(resource) == raptor->getObjectInformation(resource));
+			}
+		}
+	}
+}
+
+TEST_METHOD(testRaptorFallback) {
+	// Blank node objects are not handled natively, so the whole document is parsed by raptor.
+	const std::string turtle = "@prefix aff4: <http://aff4.org/Schema#> .\n"
+			"<aff4://image> a aff4:Image ; aff4:target [ aff4:size 1 ] .\n"
+			"<aff4://map> a aff4:Map ; aff4:target <aff4://image> .\n";
+	std::vector<Statement> statements;
+	CPPUNIT_ASSERT(!parseNative(turtle, statements));
+
+	std::shared_ptr<aff4::rdf::Model> model = parseModel(turtle, true);
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, model->getResourcesOfType(aff4::Lexicon::AFF4_IMAGE_TYPE).size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, model->getResourcesOfType(aff4::Lexicon::AFF4_MAP_TYPE).size());
+	CPPUNIT_ASSERT_EQUAL((size_t) 1, model->getResourcesWithProperty(aff4::Lexicon::AFF4_TARGET, "aff4://image").size());
+	CPPUNIT_ASSERT(model->isResourceOfType("aff4://map", aff4::Lexicon::AFF4_MAP_TYPE));
+}
+
+TEST_METHOD(testCompactRDFValue) {
+	CPPUNIT_ASSERT(sizeof(aff4::rdf::RDFValue) <= 16);
+
+	// Accessors for other types return defaults.
+	aff4::rdf::RDFValue i((int32_t) 42);
+	CPPUNIT_ASSERT_EQUAL((int32_t) 42, i.getInteger());
+	CPPUNIT_ASSERT_EQUAL((int64_t) 0, i.getLong());
+	CPPUNIT_ASSERT_EQUAL(std::string(), i.getValue());
+	aff4::rdf::RDFValue l((int64_t) 1 << 40);
+	CPPUNIT_ASSERT_EQUAL((int64_t) 1 << 40, l.getLong());
+	CPPUNIT_ASSERT_EQUAL((int32_t) 0, l.getInteger());
+	CPPUNIT_ASSERT(!aff4::rdf::RDFValue(std::string("true")).getBoolean());
+	CPPUNIT_ASSERT(aff4::rdf::RDFValue(true).getBoolean());
+	std::chrono::system_clock::time_point now = std::chrono::system_clock::now();
+	CPPUNIT_ASSERT(now == aff4::rdf::RDFValue(now).getXSDDateTime());
+
+	// Strings are shared on copy, and survive the original.
+	std::unique_ptr<aff4::rdf::RDFValue> s(new aff4::rdf::RDFValue(std::string("aff4 string")));
+	aff4::rdf::RDFValue copy(*s);
+	aff4::rdf::RDFValue assigned(false);
+	assigned = copy;
+	s.reset();
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4 string"), copy.getValue());
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4 string"), assigned.toString());
+	CPPUNIT_ASSERT(copy == assigned);
+	aff4::rdf::RDFValue moved(std::move(copy));
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4 string"), moved.getValue());
+	assigned = aff4::rdf::RDFValue((int32_t) 1);
+	CPPUNIT_ASSERT_EQUAL((int32_t) 1, assigned.getInteger());
+
+	// Equality compares type and value.
+	CPPUNIT_ASSERT(aff4::rdf::RDFValue(std::string("a")) == aff4::rdf::RDFValue(std::string("a")));
+	CPPUNIT_ASSERT(aff4::rdf::RDFValue(std::string("a")) != aff4::rdf::RDFValue(std::string("b")));
+	CPPUNIT_ASSERT(aff4::rdf::RDFValue(std::string("")) != aff4::rdf::RDFValue(std::string("b")));
+	CPPUNIT_ASSERT(aff4::rdf::RDFValue((int32_t) 1) != aff4::rdf::RDFValue((int64_t) 1));
+	CPPUNIT_ASSERT(aff4::rdf::RDFValue(aff4::Lexicon::AFF4_DIGEST_SHA1, "00") != aff4::rdf::RDFValue(aff4::Lexicon::AFF4_DIGEST_MD5, "00"));
+	aff4::rdf::RDFValue type(aff4::Lexicon::AFF4_IMAGE_TYPE);
+	CPPUNIT_ASSERT_EQUAL(aff4::lexicon::getLexiconString(aff4::Lexicon::AFF4_IMAGE_TYPE), type.toString());
+	CPPUNIT_ASSERT_EQUAL(std::string(), type.getValue());
+}
+
+TEST_METHOD(testStringInterner) {
+	aff4::rdf::StringInterner interner;
+	aff4::rdf::RDFValue a(aff4::rdf::XSDType::Resource, aff4::Lexicon::AFF4_STORED, "aff4://volume");
+	aff4::rdf::RDFValue b(aff4::rdf::XSDType::Resource, aff4::Lexicon::AFF4_STORED, "aff4://volume");
+	aff4::rdf::RDFValue c(std::string("aff4://other"));
+	aff4::rdf::RDFValue d((int64_t) 10);
+	interner.intern(a);
+	interner.intern(b);
+	interner.intern(c);
+	interner.intern(d);
+	interner.intern(a);
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, interner.size());
+	CPPUNIT_ASSERT(a == b);
+	interner.clear();
+	CPPUNIT_ASSERT_EQUAL((size_t) 0, interner.size());
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4://volume"), b.getValue());
+	CPPUNIT_ASSERT_EQUAL(std::string("aff4://other"), c.getValue());
+
+	// The model interns repeated strings.
+	const std::string turtle = "@prefix aff4: <http://aff4.org/Schema#> .\n"
+			"<aff4://a> aff4:stored <aff4://volume> ; aff4:tool \"tool\" .\n"
+			"<aff4://b> aff4:stored <aff4://volume> ; aff4:tool \"tool\" .\n";
+	aff4::rdf::Model model;
+	CPPUNIT_ASSERT_EQUAL(0, model.parse((unsigned char*) turtle.c_str(), turtle.size()));
+	CPPUNIT_ASSERT_EQUAL((size_t) 2, model.getInternedStringCount());
+}
+
+#if defined _WIN32 && defined _MSC_VER 
+
+	};
+
+}
+
+#endif
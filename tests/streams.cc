@@ -32,6 +32,7 @@ using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 #include "TestUtilities.h"
 #include "stream\ImageStreamFactory.h"
 #include "container\AFF4ZipContainer.h"
+#include "stream\struct\MapIndex.h"
 
 #define CPPUNIT_ASSERT Assert::IsTrue
 #define CPPUNIT_ASSERT_EQUAL Assert::AreEqual
@@ -402,6 +403,31 @@ TEST_METHOD(testReadUnknownEmptyBuffer) {
 	stream->close();
 }
 
+TEST_METHOD(testSymbolicStreamExtents) {
+	std::vector<std::pair<std::shared_ptr<aff4::IAFF4Stream>, aff4::ExtentType>> streams = { //
+			{ aff4::stream::createZeroStream(), aff4::ExtentType::EXTENT_ZERO }, //
+			{ aff4::stream::createSymbolicStream((uint8_t) 0), aff4::ExtentType::EXTENT_ZERO }, //
+			{ aff4::stream::createSymbolicStream((uint8_t) 0xff), aff4::ExtentType::EXTENT_SYMBOLIC }, //
+			{ aff4::stream::createUnknownStream(), aff4::ExtentType::EXTENT_UNKNOWN }, //
+			{ aff4::stream::createUnknownStream("aff4://missing"), aff4::ExtentType::EXTENT_UNKNOWN }, //
+			{ aff4::stream::createUnreadableStream(), aff4::ExtentType::EXTENT_UNREADABLE } //
+			};
+	CPPUNIT_ASSERT(aff4::ExtentType::EXTENT_SYMBOLIC == aff4::stream::getExtentType("http://aff4.org/Schema#SymbolicStream41"));
+	CPPUNIT_ASSERT(aff4::ExtentType::EXTENT_DATA == aff4::stream::getExtentType("aff4://missing"));
+	for (auto& it : streams) {
+		std::shared_ptr<aff4::IAFF4Stream> stream = it.first;
+		std::vector<aff4::StreamExtent> extents = stream->getExtents(4096, 1024);
+		CPPUNIT_ASSERT_EQUAL((size_t) 1, extents.size());
+		CPPUNIT_ASSERT_EQUAL((uint64_t) 4096, extents[0].offset);
+		CPPUNIT_ASSERT_EQUAL((uint64_t) 1024, extents[0].length);
+		CPPUNIT_ASSERT(it.second == extents[0].type);
+		CPPUNIT_ASSERT_EQUAL(stream->getResourceID(), extents[0].target);
+		// No stored data.
+		CPPUNIT_ASSERT_EQUAL(stream->size(), stream->nextData(0));
+		CPPUNIT_ASSERT_EQUAL((uint64_t) 4096, stream->nextHole(4096));
+	}
+}
+
 /*
  * aff4:ImageStream
  */
@@ -545,6 +571,42 @@ TEST_METHOD(testMicro9ImageStreamContents) {
 	}
 }
 
+TEST_METHOD(testMapIndexLookup) {
+	// Every tree shape up to 70 entries, of varying lengths.
+	for (uint32_t count = 1; count < 70; count++) {
+		std::vector<aff4::stream::structs::MapEntryPoint> entries;
+		uint64_t offset = 0;
+		for (uint32_t i = 0; i < count; i++) {
+			aff4::stream::structs::MapEntryPoint entry;
+			entry.offset = offset;
+			entry.length = 1 + (i % 5);
+			entry.streamOffset = i;
+			entry.streamID = i;
+			entries.push_back(entry);
+			offset += entry.length;
+		}
+		aff4::stream::structs::MapIndex index(std::move(entries));
+		CPPUNIT_ASSERT_EQUAL((size_t) count, index.size());
+
+		size_t cursor = 0;
+		for (uint64_t target = 0; target < offset + 4; target++) {
+			// Reference result, the last entry starting at or before target.
+			size_t expected = 0;
+			for (size_t i = 0; i < index.size(); i++) {
+				if (index.get(i).offset <= target) {
+					expected = i;
+				}
+			}
+			CPPUNIT_ASSERT_EQUAL(expected, index.find(target));
+			// Sequential, repeated and random cursors.
+			cursor = index.find(target, cursor);
+			CPPUNIT_ASSERT_EQUAL(expected, cursor);
+			CPPUNIT_ASSERT_EQUAL(expected, index.find(target, cursor));
+			CPPUNIT_ASSERT_EQUAL(expected, index.find(target, (size_t) ((target * 7) % (count + 2))));
+		}
+	}
+}
+
 #if defined _WIN32 && defined _MSC_VER 
 	};
 }
@@ -24,6 +24,7 @@
 #include "../src/aff4.h"
 #include "../src/stream/ImageStreamFactory.h"
 #include "../src/container/AFF4ZipContainer.h"
+#include "../src/stream/struct/MapIndex.h"
 
 #include "TestUtilities.h"
 
@@ -68,6 +69,7 @@ CPPUNIT_TEST_SUITE(streams);
 	CPPUNIT_TEST(testReadUnknownOverlap3MB);
 	CPPUNIT_TEST(testReadUnknownNullBuffer);
 	CPPUNIT_TEST(testReadUnknownEmptyBuffer);
+	CPPUNIT_TEST(testSymbolicStreamExtents);
 
 	/*
 	 * aff4:ImageStream
@@ -80,6 +82,11 @@ CPPUNIT_TEST_SUITE(streams);
 	CPPUNIT_TEST(testMicro7ImageStreamContents);
 	CPPUNIT_TEST(testMicro9ImageStreamContents);
 
+	/*
+	 * aff4:Map index
+	 */
+	CPPUNIT_TEST(testMapIndexLookup);
+
 	CPPUNIT_TEST_SUITE_END()
 	;
 
@@ -126,6 +133,7 @@ private:
 	void testReadUnknownOverlap3MB();
 	void testReadUnknownNullBuffer();
 	void testReadUnknownEmptyBuffer();
+	void testSymbolicStreamExtents();
 
 	/*
 	 * aff4:ImageStream
@@ -136,6 +144,11 @@ private:
 	void testAllHashsImageStreamContents();
 	void testMicro7ImageStreamContents();
 	void testMicro9ImageStreamContents();
+
+	/*
+	 * aff4:Map index
+	 */
+	void testMapIndexLookup();
 };
 
 #endif /* TESTS_STREAMS_H_ */
@@ -41,3 +41,24 @@ void version::testCVersionString() {
 	std::string v(version);
 	std::cout << version << std::endl;
 }
+
+void version::testLexicon() {
+	// Every lexicon with a string representation round trips.
+	for (int i = aff4::Lexicon::AFF4_TYPE; i <= aff4::Lexicon::BBT_CONTAINS_UNALLOCATED; i++) {
+		aff4::Lexicon lexicon = static_cast<aff4::Lexicon>(i);
+		std::string value = aff4::lexicon::getLexiconString(lexicon);
+		CPPUNIT_ASSERT(!value.empty());
+		if (value != aff4::lexicon::getLexiconString(aff4::Lexicon::UNKNOWN)) {
+			CPPUNIT_ASSERT_EQUAL(lexicon, aff4::lexicon::getLexicon(value));
+			CPPUNIT_ASSERT_EQUAL(lexicon, aff4::lexicon::getLexicon(value.data(), value.length()));
+		}
+	}
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::AFF4_IMAGE_TYPE, aff4::lexicon::getLexicon("http://aff4.org/Schema#Image"));
+	// Prefixes, extensions and unknown values don't match.
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::UNKNOWN, aff4::lexicon::getLexicon("http://aff4.org/Schema#Imag"));
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::UNKNOWN, aff4::lexicon::getLexicon("http://aff4.org/Schema#Images"));
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::UNKNOWN, aff4::lexicon::getLexicon("http://aff4.org/Schema#unknownProperty"));
+	CPPUNIT_ASSERT_EQUAL(aff4::Lexicon::UNKNOWN, aff4::lexicon::getLexicon(""));
+	CPPUNIT_ASSERT_EQUAL(aff4::lexicon::getLexiconString(aff4::Lexicon::UNKNOWN),
+			aff4::lexicon::getLexiconString(static_cast<aff4::Lexicon>(-2)));
+}
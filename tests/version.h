@@ -34,6 +34,7 @@ class version : public CPPUNIT_NS::TestFixture {
 
     CPPUNIT_TEST(testVersionString);
     CPPUNIT_TEST(testCVersionString);
+    CPPUNIT_TEST(testLexicon);
 
     CPPUNIT_TEST_SUITE_END();
 
@@ -46,6 +47,7 @@ public:
 private:
     void testVersionString();
     void testCVersionString();
+    void testLexicon();
 };
 
 #endif /* TEST_VERSION_H */